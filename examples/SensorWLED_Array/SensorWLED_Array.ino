@@ -0,0 +1,76 @@
+#ifdef ARDUINO
+//============================================================================
+// Name        : SensorWLED_Array.ino
+// Author      : Created by Debinix Team (C). The MIT License (MIT).
+// Version     : Date 2026-10-17.
+// Description : The 'SensorWLED' project. Find more information about the
+// electrical current project at (https://github.com/berrak/SensorWLED)
+// Track four ADC channels with one SensorArray, instead of four objects.
+// Add analog signals < 3.3V, via 10k potentiometers to the ANALOG_IN pins.
+//============================================================================
+
+#if defined(ARDUINO_ARCH_ESP32)
+    #define ADC_RESOLUTION bits12
+    const uint16_t analog_in[] = {32, 33, 34, 35};
+#else
+    #error This example is for ESP32 only!
+#endif
+
+// ------------ Sensor WLED Probes ----------------------------------
+// https://github.com/berrak/SensorWLED
+#include <SensorArray.h>
+
+#define CHANNELS 4
+SensorArray<CHANNELS> Probes;
+
+double mv_values[CHANNELS];       // Instant ADC values
+double mv_pk_values[CHANNELS];    // Peak ADC values
+DynamicDataType_t Params;         // Same parameters for all channels
+
+// ------------------------------------------------------------------
+// SETUP    SETUP    SETUP    SETUP    SETUP    SETUP    SETUP
+// ------------------------------------------------------------------
+void setup() {
+    Serial.begin(115200);
+	delay(250); 
+
+    // --------- SensorWLED setup -----------------
+    Params = {
+        .bits_resolution_adc = ADC_RESOLUTION,
+        .mv_maxvoltage_adc = mv_vcc_3v3,
+        .ms_poll_time = 250,
+        .ms_hold_time = 1000,  
+        .decay_model = exponential_decay,
+        .decay_rate = 1,
+    };
+
+    for (uint8_t ch = 0; ch < CHANNELS; ch++) {
+        Probes.addChannel(analog_in[ch], Params);
+    }
+
+    Serial.println("Setup completed.");
+}
+// ------------------------------------------------------------------
+// MAIN LOOP     MAIN LOOP     MAIN LOOP     MAIN LOOP     MAIN LOOP
+// ------------------------------------------------------------------
+void loop() {
+
+    // One conversion per call, bit 'ch' set for an updated channel
+    if (Probes.update() != 0) {
+
+        Probes.getMappedValues(mv_values);
+        Probes.getMappedPeakValues(mv_pk_values);
+
+        for (uint8_t ch = 0; ch < CHANNELS; ch++) {
+            Serial.print(mv_values[ch]);
+            Serial.print(",");
+            Serial.print(mv_pk_values[ch]);
+            Serial.print((ch < CHANNELS - 1) ? "," : "\n");
+        }
+    }
+
+    /* Do other tasks */
+}
+#endif // ARDUINO
+
+// EOF
@@ -0,0 +1,92 @@
+#ifdef ARDUINO
+//============================================================================
+// Name        : SensorWLED_MicBands.ino
+// Author      : Created by Debinix Team (c). The MIT License (MIT).
+// Version     : Date 2026-10-17.
+// Description : The 'SensorWLED' project.
+// Source code: (https://github.com/berrak/SensorWLED)
+// Tested Boards: ESP8266 D1-mini, UM ESP32 TinyPICO.
+//
+// Connect an analog microphone (MAX9814) to the analog input and some music.
+// Start the IDE Serial Plotter to see the band levels (mV). The microphone
+// bias is removed by the analyzer, i.e. no MV_MIC_BIAS constant.
+//============================================================================
+
+// ------------ Sensor WLED Probe -----------------------------------
+// https://github.com/berrak/SensorWLED
+#include <SensorWLED.h>
+#include <BandAnalyzer.h>
+
+#if defined(ARDUINO_ARCH_ESP8266)
+    #define ANALOG_IN_ONE 0
+    #define ADC_RESOLUTION bits10
+#elif defined(ARDUINO_ARCH_ESP32)
+    #define ANALOG_IN_ONE 33
+    #define ADC_RESOLUTION bits12
+#endif
+
+#define US_SAMPLE_PERIOD 125    // 8 kHz sample rate
+#define BLOCK_SAMPLES 32        // 4 ms of samples per loop
+
+SensorWLED ProbeOne(ANALOG_IN_ONE);
+BandAnalyzer<6, 128> Bands;     // 6 bands, 16 ms blocks
+
+DynamicDataType_t ParamsOne;    // All parameters for instance one
+uint16_t codes[BLOCK_SAMPLES];  // Raw ADC samples of one block
+
+const float hz_bands[] = {100, 250, 630, 1600, 2500, 3500};
+
+// ------------------------------------------------------------------
+// SETUP    SETUP    SETUP    SETUP    SETUP    SETUP    SETUP
+// ------------------------------------------------------------------
+void setup() {
+    Serial.begin(115200);
+    delay(250);
+
+    // --------- SensorWLED setup -----------------
+    ParamsOne = {
+        .bits_resolution_adc = ADC_RESOLUTION,
+        .mv_maxvoltage_adc = mv_vcc_3v3,
+        .ms_poll_time = 0,
+        .ms_hold_time = 100,    // Band peaks hold and decay like the sensor
+        .decay_model = exponential_decay,
+        .decay_rate = 0.5,
+    };
+
+    ProbeOne.begin(ParamsOne);  // Sets all parameters
+
+    for (float hz : hz_bands) {
+        Bands.addBand(hz);
+    }
+    Bands.begin(ProbeOne, 1000000.0 / US_SAMPLE_PERIOD, ParamsOne);
+
+    // Add serial plotter legends to graph
+    Serial.println("100Hz:,250Hz:,630Hz:,1k6Hz:,2k5Hz:,3k5Hz:");
+}
+// ------------------------------------------------------------------
+// MAIN LOOP     MAIN LOOP     MAIN LOOP     MAIN LOOP     MAIN LOOP
+// ------------------------------------------------------------------
+void loop() {
+
+    // Sample one block at a steady rate
+    uint32_t t0_us = micros();
+    for (uint16_t cnt = 0; cnt < BLOCK_SAMPLES; cnt++) {
+        while (micros() - t0_us < (uint32_t) cnt * US_SAMPLE_PERIOD) {
+        }
+        codes[cnt] = analogRead(ANALOG_IN_ONE);
+    }
+    ProbeOne.processBlock(codes, BLOCK_SAMPLES, t0_us, US_SAMPLE_PERIOD);
+
+    static uint32_t previous_print_millis_tm = 0;
+    if (millis() - previous_print_millis_tm >= 50) {
+        previous_print_millis_tm = millis();
+        for (uint8_t band = 0; band < Bands.getBandCount(); band++) {
+            Serial.print(Bands.getBandPeakValue(band));
+            Serial.print(band + 1 < Bands.getBandCount() ? "," : "\n");
+        }
+    }
+}
+
+#endif  // ARDUINO
+
+// EOF
@@ -167,9 +167,12 @@ void setup() {
         .bits_resolution_adc = ADC_RESOLUTION,
         .mv_maxvoltage_adc = mv_vcc_3v3,
         .ms_poll_time = 2,      // fast updates follow music
-        .ms_hold_time = 100,    // VU-meter needle dynamics
-        .decay_model = exponential_decay,
+        .ms_hold_time = 100,    // not used by the envelope
+        .decay_model = envelope_decay,
         .decay_rate = 1.0,
+        .acquisition_mode = blocking_average,
+        .ms_attack_time = 65,   // VU-meter needle dynamics,
+        .ms_release_time = 65,  // i.e. 99% in 300 ms
     };
 
     ProbeOne.begin(ParamsOne);  // Sets all parameters
@@ -0,0 +1,91 @@
+#ifdef ARDUINO
+//============================================================================
+// Name        : SensorWLED_Telemetry.ino
+// Author      : Created by Debinix Team (c). The MIT License (MIT).
+// Version     : Date 2026-10-17.
+// Description : The 'SensorWLED' project.
+// Source code: (https://github.com/berrak/SensorWLED)
+// Tested Boards: ESP8266 D1-mini, UM ESP32 TinyPICO.
+//
+// Streams the readings of two probes as binary telemetry frames. Capture
+// the serial port on the host, e.g.
+//   cat /dev/ttyUSB0 > capture.bin
+// and decode it to CSV with:
+//   extras/telemetry/telemetry_decode.py capture.bin -o readings.csv
+//============================================================================
+
+// ------------ Sensor WLED Probe -----------------------------------
+// https://github.com/berrak/SensorWLED
+#include <SensorWLED.h>
+#include <Telemetry.h>
+
+#if defined(ARDUINO_ARCH_ESP8266)
+    #define ANALOG_IN_ONE 0
+    #define ANALOG_IN_TWO 0
+    #define ADC_RESOLUTION bits10
+#elif defined(ARDUINO_ARCH_ESP32)
+    #define ANALOG_IN_ONE 33
+    #define ANALOG_IN_TWO 32
+    #define ADC_RESOLUTION bits12
+#endif
+
+#define MS_FRAME_TIME 100       // Send a frame at least every 100 ms
+
+SensorWLED ProbeOne(ANALOG_IN_ONE);
+SensorWLED ProbeTwo(ANALOG_IN_TWO);
+TelemetryEncoder Telemetry;
+
+DynamicDataType_t Params;       // Same parameters for both probes
+
+// ------------------------------------------------------------------
+// SETUP    SETUP    SETUP    SETUP    SETUP    SETUP    SETUP
+// ------------------------------------------------------------------
+void setup() {
+    Serial.begin(115200);
+    delay(250);
+
+    // --------- SensorWLED setup -----------------
+    Params = {
+        .bits_resolution_adc = ADC_RESOLUTION,
+        .mv_maxvoltage_adc = mv_vcc_3v3,
+        .ms_poll_time = 5,
+        .ms_hold_time = 250,
+        .decay_model = exponential_decay,
+        .decay_rate = 0.5,
+    };
+
+    ProbeOne.begin(Params);
+    ProbeTwo.begin(Params);
+}
+// ------------------------------------------------------------------
+// MAIN LOOP     MAIN LOOP     MAIN LOOP     MAIN LOOP     MAIN LOOP
+// ------------------------------------------------------------------
+void sendFrame(void) {
+    size_t length = Telemetry.finish();
+    if (length > 0) {
+        Serial.write(Telemetry.getFrame(), length);
+    }
+}
+
+void loop() {
+
+    static uint32_t previous_frame_millis_tm = millis();
+
+    if (ProbeOne.updateAnalogRead() && !Telemetry.add(ProbeOne)) {
+        sendFrame();
+        Telemetry.add(ProbeOne);
+    }
+    if (ProbeTwo.updateAnalogRead() && !Telemetry.add(ProbeTwo)) {
+        sendFrame();
+        Telemetry.add(ProbeTwo);
+    }
+
+    if (millis() - previous_frame_millis_tm >= MS_FRAME_TIME) {
+        previous_frame_millis_tm = millis();
+        sendFrame();
+    }
+}
+
+#endif  // ARDUINO
+
+// EOF
@@ -0,0 +1,251 @@
+/*!
+ * @file band_benchmark.cpp
+ *
+ * This is part of SensorWLED library for the Arduino platform.
+ * Source: https://github.com/berrak/SensorWLED
+ *
+ * The MIT license.
+ *
+ * Feeds an audio signal to BandAnalyzer, as the 12-bit codes of a biased
+ * microphone, and reports:
+ *
+ *   - the time per sample (ns), and per 2 ms poll at 8 and 16 kHz (us),
+ *   - the band levels against a double-precision Goertzel of the same
+ *     samples, also for a full-scale 16-bit 5 Hz square wave in 1024-sample
+ *     blocks, the worst case of the fixed-point states.
+ *
+ * The audio is a 16-bit PCM mono WAV file, if given, e.g. a recording of
+ * music. Otherwise a music-like signal is synthesized: a bass line, chords,
+ * percussion bursts, and noise.
+ *
+ * Build on the host (plog headers on the include path):
+ *   g++ -std=c++17 -O2 -Isrc -I<plog>/include extras/benchmark/band_benchmark.cpp \
+ *       src/SensorWLED.cpp src/ConfigStore.cpp src/CalibrationTable.cpp \
+ *       -o band_benchmark
+ *
+ * Usage:
+ *   band_benchmark [file.wav]
+ */
+#include "SensorWLED.h"
+#include "BandAnalyzer.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#define HZ_SAMPLE_RATE 16000    // Synthesized audio, and the default rate
+#define SECONDS 30              // Synthesized audio length
+#define CODE_BIAS 2048          // Microphone bias, mid-scale of 12 bits
+
+static const float BandCenters[] = {63, 160, 400, 1000, 2500, 6250, 125, 5000};
+
+static inline uint64_t nanoseconds(void) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Reads a 16-bit PCM mono WAV file, as 12-bit codes with a bias.
+ @return true if read.
+ */
+//-----------------------------------------------------------------------------
+static bool readWave(const char *path, std::vector<uint16_t> &rCodes, float &rSampleRate) {
+
+    FILE *pFile = fopen(path, "rb");
+    if (pFile == nullptr) {
+        return false;
+    }
+    uint8_t header[12];
+    bool ok_flag = fread(header, 1, 12, pFile) == 12 && memcmp(header, "RIFF", 4) == 0 &&
+                                                        memcmp(header + 8, "WAVE", 4) == 0;
+    bool format_flag = false;
+    uint8_t chunk[8];
+    while (ok_flag && fread(chunk, 1, 8, pFile) == 8) {
+        uint32_t size = chunk[4] | (chunk[5] << 8) | (chunk[6] << 16) | ((uint32_t) chunk[7] << 24);
+        if (memcmp(chunk, "fmt ", 4) == 0) {
+            uint8_t format[16];
+            ok_flag = size >= 16 && fread(format, 1, 16, pFile) == 16;
+            // PCM, one channel, 16 bits
+            format_flag = ok_flag && format[0] == 1 && format[2] == 1 && format[14] == 16;
+            rSampleRate = format[4] | (format[5] << 8) | (format[6] << 16);
+            fseek(pFile, size - 16 + (size & 1), SEEK_CUR);
+        } else if (memcmp(chunk, "data", 4) == 0 && format_flag) {
+            std::vector<int16_t> pcm(size / 2);
+            pcm.resize(fread(pcm.data(), 2, pcm.size(), pFile));
+            for (int16_t value : pcm) {
+                rCodes.push_back(CODE_BIAS + (value >> 4));
+            }
+            break;
+        } else {
+            fseek(pFile, size + (size & 1), SEEK_CUR);
+        }
+    }
+    fclose(pFile);
+    return ok_flag && format_flag && !rCodes.empty();
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Synthesizes music-like audio, as 12-bit codes with a bias.
+ */
+//-----------------------------------------------------------------------------
+static void synthesize(std::vector<uint16_t> &rCodes, float sample_rate) {
+
+    static const float Bass[] = {55, 55, 73.4f, 82.4f};                 // Hz
+    static const float Chords[][3] = {{220, 277, 330}, {294, 370, 440}};
+    uint32_t noise = 12345;
+
+    for (uint32_t cnt = 0; cnt < SECONDS * sample_rate; cnt++) {
+        double t = cnt / sample_rate;
+        uint32_t beat = t * 2;                                          // 120 bpm
+        double beat_time = t - beat * 0.5;
+
+        double value = 600 * sin(2 * M_PI * Bass[beat % 4] * t);
+        for (float hz : Chords[(beat / 4) % 2]) {
+            value += 150 * sin(2 * M_PI * hz * t) * (1 - beat_time);
+        }
+        noise = noise * 1664525 + 1013904223;
+        double white = (int32_t) noise / 2147483648.0;
+        value += 700 * white * exp(-beat_time * 40);                    // Percussion
+        value += 20 * white;
+
+        int32_t code = lround(CODE_BIAS + value);
+        rCodes.push_back((code < 0) ? 0 : (code > 4095) ? 4095 : code);
+    }
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Double-precision Goertzel of the analyzer's blocks, with the same
+         DC removal, window and Q14 coefficients, i.e. the analyzer's result
+         without rounding and overflow.
+ @return Largest level difference, of the reference full scale (%).
+ */
+//-----------------------------------------------------------------------------
+template <uint8_t BANDS, uint16_t BLOCK_SIZE>
+static double compare(std::vector<uint16_t> const &rCodes, float sample_rate,
+                        AdcResolutionType_e bits, const float *pCenters = BandCenters) {
+
+    BandAnalyzer<BANDS, BLOCK_SIZE> Bands;
+    SensorWLED Probe(0);
+    DynamicDataType_t Params = {};
+    Params.bits_resolution_adc = bits;
+    Params.mv_maxvoltage_adc = mv_vcc_3v3;
+    Params.ms_hold_time = 100;
+    Probe.begin(Params);
+    for (uint8_t band = 0; band < BANDS; band++) {
+        Bands.addBand(pCenters[band]);
+    }
+    Bands.begin(Probe, sample_rate, Params);
+
+    double mv_per_code = (double) mv_vcc_3v3 / bits;
+    double s1[BANDS] = {}, s2[BANDS] = {};
+    double dc_value = rCodes[0];
+    double max_error = 0;
+    double max_level = 0;
+    uint16_t sample_count = 0;
+
+    for (size_t cnt = 0; cnt < rCodes.size(); cnt++) {
+        dc_value += (rCodes[cnt] - dc_value) / (1 << DC_REMOVAL_SHIFT);
+        double w = 0.5 - 0.5 * cos(2 * M_PI * sample_count / BLOCK_SIZE);
+        double x = (rCodes[cnt] - dc_value) * w;
+        for (uint8_t band = 0; band < BANDS; band++) {
+            double c = lround(2 * cos(2 * M_PI * pCenters[band] / sample_rate) * (1 << Q14_SHIFT))
+                                                                    / (double) (1 << Q14_SHIFT);
+            double s0 = x + c * s1[band] - s2[band];
+            s2[band] = s1[band];
+            s1[band] = s0;
+        }
+        if (++sample_count < BLOCK_SIZE) {
+            Bands.addSample(rCodes[cnt], cnt * 1000 / sample_rate);
+            continue;
+        }
+        sample_count = 0;
+        Bands.addSample(rCodes[cnt], cnt * 1000 / sample_rate);
+
+        for (uint8_t band = 0; band < BANDS; band++) {
+            double c = lround(2 * cos(2 * M_PI * pCenters[band] / sample_rate) * (1 << Q14_SHIFT))
+                                                                    / (double) (1 << Q14_SHIFT);
+            double power = s1[band] * s1[band] + s2[band] * s2[band] - c * s1[band] * s2[band];
+            double level = sqrt((power > 0) ? power : 0) * 4 / BLOCK_SIZE * mv_per_code;
+            double error = fabs(Bands.getBandValue(band) - level);
+            max_error = (error > max_error) ? error : max_error;
+            max_level = (level > max_level) ? level : max_level;
+            s1[band] = s2[band] = 0;
+        }
+    }
+    return (max_level > 0) ? 100 * max_error / max_level : 0;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Times addSample() of all codes, and prints a table row.
+ */
+//-----------------------------------------------------------------------------
+template <uint8_t BANDS, uint16_t BLOCK_SIZE>
+static void runBenchmark(std::vector<uint16_t> const &rCodes, float sample_rate) {
+
+    BandAnalyzer<BANDS, BLOCK_SIZE> Bands;
+    SensorWLED Probe(0);
+    DynamicDataType_t Params = {};
+    Params.bits_resolution_adc = bits12;
+    Params.mv_maxvoltage_adc = mv_vcc_3v3;
+    Params.ms_hold_time = 100;
+    Probe.begin(Params);
+    for (uint8_t band = 0; band < BANDS; band++) {
+        Bands.addBand(BandCenters[band]);
+    }
+    Bands.begin(Probe, sample_rate, Params);
+
+    volatile uint32_t blocks = 0;
+    uint64_t start_ns = nanoseconds();
+    for (size_t cnt = 0; cnt < rCodes.size(); cnt++) {
+        blocks += Bands.addSample(rCodes[cnt], cnt * 1000 / sample_rate);
+    }
+    double sample_ns = (double) (nanoseconds() - start_ns) / rCodes.size();
+
+    printf("%6u %6u %12.1f %12.2f %12.2f %12.4f\n", BANDS, BLOCK_SIZE, sample_ns,
+            sample_ns * 16 / 1000, sample_ns * 32 / 1000,
+            compare<BANDS, BLOCK_SIZE>(rCodes, sample_rate, bits12));
+}
+
+int main(int argc, char *argv[]) {
+
+    std::vector<uint16_t> codes;
+    float sample_rate = HZ_SAMPLE_RATE;
+    if (argc > 1) {
+        if (!readWave(argv[1], codes, sample_rate)) {
+            printf("%s: not a 16-bit PCM mono WAV file\n", argv[1]);
+            return 1;
+        }
+        printf("%s: %zu samples at %.0f Hz\n", argv[1], codes.size(), sample_rate);
+    } else {
+        synthesize(codes, sample_rate);
+        printf("synthesized music: %zu samples at %.0f Hz\n", codes.size(), sample_rate);
+    }
+
+    printf("\n%6s %6s %12s %12s %12s %12s\n", "bands", "block", "ns/sample",
+            "8 kHz us/2ms", "16kHz us/2ms", "max error %");
+    runBenchmark<1, 128>(codes, sample_rate);
+    runBenchmark<6, 128>(codes, sample_rate);
+    runBenchmark<8, 128>(codes, sample_rate);
+    runBenchmark<8, 255>(codes, sample_rate);
+    runBenchmark<8, 1024>(codes, sample_rate);
+
+    // Worst case of the states, a full-scale 16-bit square wave, and a
+    // band at its frequency, near 0 Hz
+    static const float Worst[] = {5};
+    std::vector<uint16_t> square;
+    for (uint32_t cnt = 0; cnt < 4 * HZ_SAMPLE_RATE; cnt++) {
+        square.push_back((cnt % (HZ_SAMPLE_RATE / 5) < HZ_SAMPLE_RATE / 10) ? bits16 : 0);
+    }
+    printf("\nfull-scale 16-bit 5 Hz square, max error %%: 128 samples %.4f, 1024 samples %.4f\n",
+            compare<1, 128>(square, HZ_SAMPLE_RATE, bits16, Worst),
+            compare<1, 1024>(square, HZ_SAMPLE_RATE, bits16, Worst));
+    return 0;
+}
+
+// EOF
@@ -0,0 +1,135 @@
+/*!
+ * @file block_benchmark.cpp
+ *
+ * This is part of SensorWLED library for the Arduino platform.
+ * Source: https://github.com/berrak/SensorWLED
+ *
+ * The MIT license.
+ *
+ * Feeds a 20 kHz stream of a synthetic WLED strip current (HostSignal.h),
+ * as from the ESP32 continuous (DMA) ADC mode, to processBlock() in blocks
+ * of 1 to 1024 samples, without and with averaging, and reports:
+ *
+ *   - the samples per second of the blocks, and of one sample per call,
+ *   - if the values (raw, peak, mapped) after the stream are the same as
+ *     for one sample per call.
+ *
+ * For reference, the samples per second of updateAnalogRead(), one
+ * analogRead() per call, are also printed.
+ *
+ * Build on the host (plog headers on the include path):
+ *   g++ -std=c++17 -O2 -Isrc -I<plog>/include extras/benchmark/block_benchmark.cpp \
+ *       src/SensorWLED.cpp src/ConfigStore.cpp src/CalibrationTable.cpp \
+ *       -o block_benchmark
+ */
+#include "SensorWLED.h"
+#include "HostSignal.h"
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#define US_SAMPLE_TIME 50           // 20 kHz sample rate
+#define STREAM_SAMPLES 4194304UL    // Samples per run, a multiple of all blocks
+
+/** A typical strip: effects, ramps, 1 kHz PWM, data bursts, and noise */
+static const SignalDataType_t StripSignal = {
+    .mv_idle = 150,
+    .mv_full = 2800,
+    .ms_effect_time = 40,
+    .effect_depth = 0.6,
+    .ms_ramp_time = 3000,
+    .hz_pwm = 1000,
+    .pwm_ripple = 0.3,
+    .spike_rate = 5,
+    .mv_spike = 400,
+    .us_spike_time = 300,
+    .mv_noise = 8,
+    .hz_tone = 0,
+    .mv_tone = 0,
+};
+
+static inline uint64_t nanoseconds(void) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/** analogRead() of the stream, one sample per 'US_SAMPLE_TIME' */
+static uint16_t streamProvider(uint8_t pin, void *context) {
+    (void) pin;
+    std::vector<uint16_t> &rCodes = *static_cast<std::vector<uint16_t> *>(context);
+    return rCodes[(HostPlatform.getTime() / US_SAMPLE_TIME - 1) % rCodes.size()];
+}
+
+static void beginProbe(SensorWLED &rProbe) {
+
+    DynamicDataType_t Params = {};
+    Params.bits_resolution_adc = bits12;
+    Params.mv_maxvoltage_adc = mv_vcc_3v3;
+    Params.ms_poll_time = 0;
+    Params.ms_hold_time = 250;
+    Params.decay_model = exponential_decay;
+    Params.decay_rate = 0.5;
+    rProbe.begin(Params);
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Feeds the stream in blocks, and returns the samples per second.
+ */
+//-----------------------------------------------------------------------------
+static double feedBlocks(SensorWLED &rProbe, std::vector<uint16_t> const &rCodes, size_t block) {
+
+    beginProbe(rProbe);
+    uint64_t start_ns = nanoseconds();
+    for (size_t first = 0; first < rCodes.size(); first += block) {
+        rProbe.processBlock(&rCodes[first], block, first * US_SAMPLE_TIME, US_SAMPLE_TIME);
+    }
+    return rCodes.size() / ((nanoseconds() - start_ns) / 1e9);
+}
+
+static bool isSame(SensorWLED &rOne, SensorWLED &rOther) {
+    return rOne.getRawValue() == rOther.getRawValue() &&
+            rOne.getRawPeakValue() == rOther.getRawPeakValue() &&
+            rOne.getMappedPeakValue() == rOther.getMappedPeakValue();
+}
+
+int main(void) {
+
+    std::vector<uint16_t> codes(STREAM_SAMPLES);
+    SignalGenerator Signal;
+    Signal.begin(StripSignal, bits12, mv_vcc_3v3);
+    for (size_t cnt = 0; cnt < codes.size(); cnt++) {
+        codes[cnt] = Signal.getCode((uint64_t) cnt * US_SAMPLE_TIME);
+    }
+
+    printf("%-10s %8s %16s %16s %8s\n", "averaging", "block", "block samples/s",
+            "1 per call /s", "same");
+    for (uint16_t sample_count : {0, 16}) {
+        SensorWLED One(0, 0.0, 1.0, sample_count);
+        double single_rate = feedBlocks(One, codes, 1);
+
+        for (size_t block = 16; block <= 1024; block *= 4) {
+            SensorWLED Probe(0, 0.0, 1.0, sample_count);
+            double block_rate = feedBlocks(Probe, codes, block);
+            printf("%-10u %8zu %16.0f %16.0f %8s\n", sample_count, block, block_rate,
+                    single_rate, isSame(Probe, One) ? "yes" : "NO");
+        }
+    }
+
+    // One analogRead() per updateAnalogRead(), on the same stream
+    HostPlatform.reset();
+    HostPlatform.setAnalogReadProvider(&streamProvider, &codes);
+    SensorWLED Polled(0);
+    beginProbe(Polled);
+    uint64_t start_ns = nanoseconds();
+    for (size_t cnt = 0; cnt < codes.size(); cnt++) {
+        HostPlatform.advanceTime(US_SAMPLE_TIME);
+        Polled.updateAnalogRead();
+    }
+    printf("\nupdateAnalogRead(), one sample per call: %.0f samples/s\n",
+            codes.size() / ((nanoseconds() - start_ns) / 1e9));
+    return 0;
+}
+
+// EOF
@@ -0,0 +1,128 @@
+/*!
+ * @file crc_benchmark.cpp
+ *
+ * This is part of SensorWLED library for the Arduino platform.
+ * Source: https://github.com/berrak/SensorWLED
+ *
+ * The MIT license.
+ *
+ * Compares SensorWLED::calculateCRC32() (constant tables, slicing-by-8)
+ * with the former CRC32 of the library, which built the 1 kB table on the
+ * stack for each CRC and updated it one byte per call. Reports:
+ *
+ *   - the time per CRC (ns) of the EEPROM structs, and of larger buffers,
+ *     and the throughput (MB/s),
+ *   - if the CRCs are bit-identical, for all lengths up to 256 bytes at
+ *     each alignment, and in parts (the 'initial' argument).
+ *
+ * Build on the host (plog headers on the include path):
+ *   g++ -std=c++17 -O2 -Isrc -I<plog>/include extras/benchmark/crc_benchmark.cpp \
+ *       src/SensorWLED.cpp src/ConfigStore.cpp src/CalibrationTable.cpp \
+ *       -o crc_benchmark
+ *
+ * Returns 0 if the CRCs are identical.
+ */
+#include "SensorWLED.h"
+#include "Telemetry.h"
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#define BYTES_PER_RUN 64000000UL    // Bytes per size and CRC
+
+static inline uint64_t nanoseconds(void) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  The former CRC32: the table on the stack, and one call per byte,
+         as in begin() and the EEPROM writes.
+ */
+//-----------------------------------------------------------------------------
+static uint32_t formerCRC32(const void *buf, size_t len) {
+
+    uint32_t table[CRC32_TABLE_SIZE];
+    for (uint32_t i = 0; i < CRC32_TABLE_SIZE; i++) {
+        uint32_t c = i;
+        for (size_t j = 0; j < 8; j++) {
+            c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+        }
+        table[i] = c;
+    }
+
+    uint32_t crc = 0;
+    const uint8_t *u = static_cast<const uint8_t *>(buf);
+    for (size_t i = 0; i < len; i++) {
+        uint32_t c = crc ^ 0xFFFFFFFF;
+        c = table[(c ^ u[i]) & 0xFF] ^ (c >> 8);
+        crc = c ^ 0xFFFFFFFF;
+    }
+    return crc;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Times both CRCs of a buffer size, and prints a table row.
+ */
+//-----------------------------------------------------------------------------
+static void runBenchmark(const char *name, std::vector<uint8_t> const &rData, size_t len) {
+
+    uint32_t runs = BYTES_PER_RUN / len / 16 + 1;
+    volatile uint32_t sink = 0;
+
+    uint64_t start_ns = nanoseconds();
+    for (uint32_t run = 0; run < runs; run++) {
+        sink = sink + formerCRC32(rData.data(), len);
+    }
+    double former_ns = (double) (nanoseconds() - start_ns) / runs;
+
+    runs *= 16;
+    start_ns = nanoseconds();
+    for (uint32_t run = 0; run < runs; run++) {
+        sink = sink + SensorWLED::calculateCRC32(rData.data(), len);
+    }
+    double sliced_ns = (double) (nanoseconds() - start_ns) / runs;
+
+    printf("%-24s %8zu %12.1f %12.1f %10.0f %10.0f %8.1fx\n", name, len, former_ns, sliced_ns,
+            len * 1e3 / former_ns, len * 1e3 / sliced_ns, former_ns / sliced_ns);
+}
+
+int main(void) {
+
+    std::vector<uint8_t> data(65536 + 8);
+    uint32_t seed = 1;
+    for (uint8_t &rByte : data) {
+        seed = seed * 1664525 + 1013904223;
+        rByte = seed >> 24;
+    }
+
+    // Bit-identical for all lengths and alignments, also in two parts
+    uint32_t mismatches = 0;
+    for (size_t offset = 0; offset < 8; offset++) {
+        for (size_t len = 0; len <= 256; len++) {
+            const uint8_t *pData = &data[offset];
+            uint32_t crc = SensorWLED::calculateCRC32(pData, len);
+            uint32_t split = SensorWLED::calculateCRC32(pData + len / 3, len - len / 3,
+                                        SensorWLED::calculateCRC32(pData, len / 3));
+            mismatches += (crc != formerCRC32(pData, len)) + (split != crc);
+        }
+    }
+    printf("identical CRCs (all lengths 0 to 256, 8 alignments, split): %s\n\n",
+            (mismatches == 0) ? "yes" : "NO");
+
+    printf("%-24s %8s %12s %12s %10s %10s %9s\n", "buffer", "bytes", "former ns",
+            "sliced ns", "former MB/s", "sliced MB/s", "speedup");
+    runBenchmark("CalibrationDataType_t", data, sizeof(CalibrationDataType_t));
+    runBenchmark("DynamicDataType_t", data, sizeof(DynamicDataType_t));
+    runBenchmark("CalibrationPointsType_t", data, sizeof(CalibrationPointsType_t));
+    runBenchmark("telemetry frame", data, TELEMETRY_FRAME_SIZE);
+    runBenchmark("buffer", data, 4096);
+    runBenchmark("buffer", data, 65536);
+
+    return (mismatches == 0) ? 0 : 1;
+}
+
+// EOF
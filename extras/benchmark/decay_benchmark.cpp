@@ -0,0 +1,155 @@
+/*!
+ * @file decay_benchmark.cpp
+ *
+ * This is part of SensorWLED library for the Arduino platform.
+ * Source: https://github.com/berrak/SensorWLED
+ *
+ * The MIT license.
+ *
+ * Compares the per-sample cost of the decay models, the hold-time
+ * linear_decay and exponential_decay and the attack/release
+ * envelope_decay, on a synthetic WLED strip current (HostSignal.h) at
+ * 20 kHz. Reports for each model:
+ *
+ *   - the time per sample (ns), one updateAnalogRead() per sample, and
+ *     in processBlock() blocks of 256 samples,
+ *   - the peak value changes per second, and the largest change (mV),
+ *     i.e. how smooth a VU meter of the peak value is.
+ *
+ * The samples are made before the run, so the time is the library's.
+ *
+ * Build on the host (plog headers on the include path):
+ *   g++ -std=c++17 -O2 -Isrc -I<plog>/include extras/benchmark/decay_benchmark.cpp \
+ *       src/SensorWLED.cpp src/ConfigStore.cpp src/CalibrationTable.cpp \
+ *       -o decay_benchmark
+ */
+#include "SensorWLED.h"
+#include "HostSignal.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#define US_SAMPLE_TIME 50           // 20 kHz sample rate
+#define STREAM_SAMPLES 2097152UL    // Samples per run, about 105 s
+#define BLOCK_SIZE 256              // processBlock() samples
+
+typedef struct {
+    const char *name;               ///< Printed model name
+    DecayModelType_e decay_model;
+} BenchmarkModelType_t;
+
+static const BenchmarkModelType_t Models[] = {
+    {"linear", linear_decay},
+    {"exponential", exponential_decay},
+    {"envelope", envelope_decay},
+};
+
+/** A typical strip: effects, ramps, 1 kHz PWM, data bursts, and noise */
+static const SignalDataType_t StripSignal = {
+    .mv_idle = 150,
+    .mv_full = 2800,
+    .ms_effect_time = 40,
+    .effect_depth = 0.6,
+    .ms_ramp_time = 3000,
+    .hz_pwm = 1000,
+    .pwm_ripple = 0.3,
+    .spike_rate = 5,
+    .mv_spike = 400,
+    .us_spike_time = 300,
+    .mv_noise = 8,
+    .hz_tone = 0,
+    .mv_tone = 0,
+};
+
+static inline uint64_t nanoseconds(void) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/** analogRead() of the stream, one sample per 'US_SAMPLE_TIME' */
+static uint16_t streamProvider(uint8_t pin, void *context) {
+    (void) pin;
+    std::vector<uint16_t> &rCodes = *static_cast<std::vector<uint16_t> *>(context);
+    return rCodes[(HostPlatform.getTime() / US_SAMPLE_TIME - 1) % rCodes.size()];
+}
+
+static void beginProbe(SensorWLED &rProbe, DecayModelType_e decay_model) {
+
+    DynamicDataType_t Params = {};
+    Params.bits_resolution_adc = bits12;
+    Params.mv_maxvoltage_adc = mv_vcc_3v3;
+    Params.ms_poll_time = 0;
+    Params.ms_hold_time = 100;
+    Params.decay_model = decay_model;
+    Params.decay_rate = 0.5;
+    Params.ms_attack_time = 65;         // VU ballistics
+    Params.ms_release_time = 65;
+    rProbe.begin(Params);
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Runs one decay model, and prints a table row.
+ */
+//-----------------------------------------------------------------------------
+static void runBenchmark(BenchmarkModelType_t const &rModel, std::vector<uint16_t> &rCodes) {
+
+    // One updateAnalogRead() per sample, the peak value after each
+    HostPlatform.reset();
+    HostPlatform.setAnalogReadProvider(&streamProvider, &rCodes);
+    SensorWLED Polled(0);
+    beginProbe(Polled, rModel.decay_model);
+
+    uint32_t changes = 0;
+    double mv_max_change = 0;
+    double mv_previous = 0;
+    uint64_t sum_ns = 0;
+    for (size_t cnt = 0; cnt < rCodes.size(); cnt++) {
+        HostPlatform.advanceTime(US_SAMPLE_TIME);
+        uint64_t start_ns = nanoseconds();
+        Polled.updateAnalogRead();
+        sum_ns += nanoseconds() - start_ns;
+
+        double mv_peak = Polled.getMappedPeakValue();
+        if (mv_peak != mv_previous) {
+            changes++;
+            mv_max_change = fmax(mv_max_change, fabs(mv_peak - mv_previous));
+            mv_previous = mv_peak;
+        }
+    }
+    double polled_ns = (double) sum_ns / rCodes.size();
+
+    // Blocks, as from the DMA ADC
+    SensorWLED Block(1);
+    beginProbe(Block, rModel.decay_model);
+    uint64_t start_ns = nanoseconds();
+    for (size_t first = 0; first < rCodes.size(); first += BLOCK_SIZE) {
+        Block.processBlock(&rCodes[first], BLOCK_SIZE, first * US_SAMPLE_TIME, US_SAMPLE_TIME);
+    }
+    double block_ns = (double) (nanoseconds() - start_ns) / rCodes.size();
+
+    double seconds = rCodes.size() * US_SAMPLE_TIME / 1e6;
+    printf("%-12s %14.1f %14.2f %12.0f %14.1f\n", rModel.name, polled_ns, block_ns,
+            changes / seconds, mv_max_change);
+}
+
+int main(void) {
+
+    std::vector<uint16_t> codes(STREAM_SAMPLES);
+    SignalGenerator Signal;
+    Signal.begin(StripSignal, bits12, mv_vcc_3v3);
+    for (size_t cnt = 0; cnt < codes.size(); cnt++) {
+        codes[cnt] = Signal.getCode((uint64_t) (cnt + 1) * US_SAMPLE_TIME);
+    }
+
+    printf("%-12s %14s %14s %12s %14s\n", "decay", "ns/sample", "block ns/sample",
+            "changes/s", "max change mV");
+    for (BenchmarkModelType_t const &rModel : Models) {
+        runBenchmark(rModel, codes);
+    }
+    return 0;
+}
+
+// EOF
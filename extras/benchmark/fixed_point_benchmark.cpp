@@ -0,0 +1,169 @@
+/*!
+ * @file fixed_point_benchmark.cpp
+ *
+ * This is part of SensorWLED library for the Arduino platform.
+ * Source: https://github.com/berrak/SensorWLED
+ *
+ * The MIT license.
+ *
+ * Compares the double and the fixed-point (Q16.16) paths of the mapping,
+ * calibration and decay, on a synthetic WLED strip current (HostSignal.h).
+ * The path is a build option of the library, so the program is built
+ * twice, and reports for each build:
+ *
+ *   - the time per poll, updateAnalogRead() with a mapping of the value
+ *     and the peak value (ns), and the polls per second,
+ *   - with -w, writes the mapped and peak values of each poll to a file,
+ *   - with -c, compares the values with such a file, of the other build,
+ *     and checks that they match within 1 LSB (one ADC code, in mV).
+ *
+ * The hold time is short, so a poll often decays the peak value. The
+ * signal codes are made before the run, so the time is the library's.
+ *
+ * Build and run on the host (plog headers on the include path):
+ *   for fixed in 0 1; do
+ *     g++ -std=c++17 -O2 -DFIXED_POINT_MATH=$fixed -Isrc -I<plog>/include \
+ *         extras/benchmark/fixed_point_benchmark.cpp src/SensorWLED.cpp \
+ *         src/ConfigStore.cpp src/CalibrationTable.cpp -o fixed_point_benchmark_$fixed
+ *   done
+ *   ./fixed_point_benchmark_0 -w double.bin && ./fixed_point_benchmark_1 -c double.bin
+ *
+ * Returns 0, or 1 if the values differ by more than 1 LSB.
+ */
+#include "SensorWLED.h"
+#include "HostSignal.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#define US_LOOP_TIME 100        // Virtual main loop period (microseconds)
+#define POLL_COUNT 2000000UL    // Polls per run
+
+/** A typical strip: effects, ramps, 1 kHz PWM, data bursts, and noise */
+static const SignalDataType_t StripSignal = {
+    .mv_idle = 150,
+    .mv_full = 2800,
+    .ms_effect_time = 40,
+    .effect_depth = 0.6,
+    .ms_ramp_time = 3000,
+    .hz_pwm = 1000,
+    .pwm_ripple = 0.3,
+    .spike_rate = 5,
+    .mv_spike = 400,
+    .us_spike_time = 300,
+    .mv_noise = 8,
+    .hz_tone = 0,
+    .mv_tone = 0,
+};
+
+typedef struct {
+    float mv_value;             ///< getMappedValue()
+    float mv_peak_value;        ///< getMappedPeakValue()
+} PollValueType_t;
+
+/** analogRead() of the codes made before the run */
+static uint16_t codeProvider(uint8_t pin, void *context) {
+    (void) pin;
+    std::vector<uint16_t> &rCodes = *static_cast<std::vector<uint16_t> *>(context);
+    return rCodes[HostPlatform.getTime() / US_LOOP_TIME % rCodes.size()];
+}
+
+static inline uint64_t nanoseconds(void) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Polls one calibrated channel, and prints the time per poll.
+ */
+//-----------------------------------------------------------------------------
+static void runBenchmark(DecayModelType_e decay_model, std::vector<PollValueType_t> &rValues) {
+
+    DynamicDataType_t Params = {};
+    Params.bits_resolution_adc = bits12;
+    Params.mv_maxvoltage_adc = mv_vcc_3v3;
+    Params.ms_poll_time = 0;
+    Params.ms_hold_time = 2;
+    Params.decay_model = decay_model;
+    Params.decay_rate = 0.5;
+
+    HostPlatform.reset();
+    SignalGenerator Signal;
+    Signal.begin(StripSignal, bits12, mv_vcc_3v3);
+    std::vector<uint16_t> codes;
+    codes.resize(POLL_COUNT + 1);
+    for (uint32_t poll = 0; poll <= POLL_COUNT; poll++) {
+        codes[poll] = Signal.getCode((uint64_t) poll * US_LOOP_TIME);
+    }
+    HostPlatform.setAnalogReadProvider(&codeProvider, &codes);
+
+    SensorWLED Probe(0, 12.5, 1.037);
+    Probe.begin(Params);
+
+    size_t first = rValues.size();
+    rValues.resize(first + POLL_COUNT);
+    uint64_t start_ns = nanoseconds();
+
+    for (uint32_t poll = 0; poll < POLL_COUNT; poll++) {
+        HostPlatform.advanceTime(US_LOOP_TIME);
+        Probe.updateAnalogRead();
+        rValues[first + poll].mv_value = Probe.getMappedValue();
+        rValues[first + poll].mv_peak_value = Probe.getMappedPeakValue();
+    }
+
+    double poll_ns = (double) (nanoseconds() - start_ns) / POLL_COUNT;
+    printf("%-12s %-12s %10.1f %14.0f\n", FIXED_POINT_MATH ? "Q16.16" : "double",
+            (decay_model == linear_decay) ? "linear" : "exponential", poll_ns, 1e9 / poll_ns);
+}
+
+int main(int argc, char *argv[]) {
+
+    const char *pMode = (argc > 2) ? argv[1] : "";
+    std::vector<PollValueType_t> values;
+
+    printf("%-12s %-12s %10s %14s\n", "math", "decay", "ns/poll", "polls/s");
+    runBenchmark(linear_decay, values);
+    runBenchmark(exponential_decay, values);
+
+    if (strcmp(pMode, "-w") == 0) {
+        FILE *pFile = fopen(argv[2], "wb");
+        bool ok_flag = pFile != nullptr &&
+                fwrite(values.data(), sizeof(PollValueType_t), values.size(), pFile) == values.size();
+        if (pFile != nullptr) {
+            fclose(pFile);
+        }
+        printf("%s: %s\n", argv[2], ok_flag ? "written" : "write failed");
+        return ok_flag ? 0 : 1;
+    }
+    if (strcmp(pMode, "-c") != 0) {
+        return 0;
+    }
+
+    std::vector<PollValueType_t> other(values.size());
+    FILE *pFile = fopen(argv[2], "rb");
+    if (pFile == nullptr ||
+            fread(other.data(), sizeof(PollValueType_t), other.size(), pFile) != other.size()) {
+        printf("%s: not a file of the other build\n", argv[2]);
+        return 1;
+    }
+    fclose(pFile);
+
+    double max_error = 0;
+    double max_peak_error = 0;
+    for (size_t cnt = 0; cnt < values.size(); cnt++) {
+        max_error = fmax(max_error, fabs(values[cnt].mv_value - other[cnt].mv_value));
+        max_peak_error = fmax(max_peak_error,
+                                fabs(values[cnt].mv_peak_value - other[cnt].mv_peak_value));
+    }
+    double mv_lsb = (double) mv_vcc_3v3 / bits12;
+    bool ok_flag = max_error <= mv_lsb && max_peak_error <= mv_lsb;
+    printf("largest difference: value %.4f mV, peak %.4f mV, 1 LSB %.4f mV: %s\n",
+            max_error, max_peak_error, mv_lsb, ok_flag ? "ok" : "FAILED");
+    return ok_flag ? 0 : 1;
+}
+
+// EOF
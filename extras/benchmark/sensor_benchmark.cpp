@@ -0,0 +1,225 @@
+/*!
+ * @file sensor_benchmark.cpp
+ *
+ * This is part of SensorWLED library for the Arduino platform.
+ * Source: https://github.com/berrak/SensorWLED
+ *
+ * The MIT license.
+ *
+ * Runs 1 to 1000 simulated SensorWLED channels on a synthetic WLED strip
+ * current (HostSignal.h), for each acquisition mode, and reports:
+ *
+ *   - ADC samples per second (all channels),
+ *   - updateAnalogRead() latency percentiles (ns),
+ *   - RAM per channel (bytes).
+ *
+ * A second table compares SensorArray<N> with N SensorWLED instances, for
+ * the same signal and one reading per channel per loop: the time per
+ * channel reading (ns), and the RAM per channel.
+ *
+ * The clock is virtual, the main loop runs every 'US_LOOP_TIME', so the
+ * results are the CPU cost of the library only.
+ *
+ * Build on the host (plog headers on the include path), with the sample
+ * queue of the interrupt mode:
+ *   g++ -std=c++17 -O2 -DSENSOR_SAMPLE_QUEUE=1 -Isrc -I<plog>/include \
+ *       extras/benchmark/sensor_benchmark.cpp \
+ *       src/SensorWLED.cpp src/ConfigStore.cpp src/CalibrationTable.cpp \
+ *       -o sensor_benchmark
+ *
+ * Usage:
+ *   sensor_benchmark [max_channels [bits]]     e.g. sensor_benchmark 1000 4095
+ */
+#include "SensorWLED.h"
+#include "SensorArray.h"
+#include "HostSignal.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#define US_LOOP_TIME 100        // Virtual main loop period (microseconds)
+#define SAMPLE_COUNT 16         // Samples per reading, averaging modes
+#define CALLS_PER_RUN 2000000   // updateAnalogRead() calls per mode and size
+
+typedef struct {
+    const char *name;           ///< Printed mode name
+    uint16_t sample_count;      ///< Samples per reading
+    AcquisitionModeType_e acquisition_mode;
+} BenchmarkModeType_t;
+
+static const BenchmarkModeType_t Modes[] = {
+    {"single", 0, blocking_average},
+    {"blocking", SAMPLE_COUNT, blocking_average},
+    {"incremental", SAMPLE_COUNT, incremental_average},
+    {"interrupt", SAMPLE_COUNT, interrupt_driven},
+};
+
+/** A typical strip: effects, ramps, 1 kHz PWM, data bursts, and noise */
+static const SignalDataType_t StripSignal = {
+    .mv_idle = 150,
+    .mv_full = 2800,
+    .ms_effect_time = 40,
+    .effect_depth = 0.6,
+    .ms_ramp_time = 3000,
+    .hz_pwm = 1000,
+    .pwm_ripple = 0.3,
+    .spike_rate = 5,
+    .mv_spike = 400,
+    .us_spike_time = 300,
+    .mv_noise = 8,
+    .hz_tone = 0,
+    .mv_tone = 0,
+};
+
+static inline uint64_t nanoseconds(void) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Runs one mode with 'channels' instances, and prints a table row.
+ */
+//-----------------------------------------------------------------------------
+static void runBenchmark(BenchmarkModeType_t const &rMode, uint16_t channels,
+                                                    AdcResolutionType_e bits) {
+
+    DynamicDataType_t Params = {};
+    Params.bits_resolution_adc = bits;
+    Params.mv_maxvoltage_adc = mv_vcc_3v3;
+    Params.ms_poll_time = 0;
+    Params.ms_hold_time = 250;
+    Params.decay_model = exponential_decay;
+    Params.decay_rate = 0.5;
+    Params.acquisition_mode = rMode.acquisition_mode;
+
+    HostPlatform.reset();
+    SignalGenerator Signal;
+    Signal.begin(StripSignal, bits, mv_vcc_3v3);
+    Signal.install();
+
+    std::vector<std::unique_ptr<SensorWLED>> Probes;
+    for (uint16_t cnt = 0; cnt < channels; cnt++) {
+        Probes.emplace_back(new SensorWLED(cnt % 256, 0.0, 1.0, rMode.sample_count));
+        Probes.back()->begin(Params);
+    }
+
+    // Latencies in ns, 1/16 bucket resolution up to 65 us
+    LogHistogram<4> Latency;
+    uint32_t loops = CALLS_PER_RUN / channels;
+    uint64_t pushed_samples = 0;
+    uint32_t start_reads = HostPlatform.getAnalogReadCount();
+    uint64_t start_ns = nanoseconds();
+
+    for (uint32_t loop = 0; loop < loops; loop++) {
+        HostPlatform.advanceTime(US_LOOP_TIME);
+        for (auto &pProbe : Probes) {
+            // A timer ISR would push the samples between the loops
+            if (rMode.acquisition_mode == interrupt_driven) {
+                pProbe->pushSample(Signal.getCode(HostPlatform.getTime(),
+                                    pProbe->CalibrationData.analog_pin));
+                pushed_samples++;
+            }
+            uint64_t call_ns = nanoseconds();
+            pProbe->updateAnalogRead();
+            uint64_t elapsed_ns = nanoseconds() - call_ns;
+            Latency.add((elapsed_ns > UINT16_MAX) ? UINT16_MAX : elapsed_ns);
+        }
+    }
+
+    double seconds = (nanoseconds() - start_ns) / 1e9;
+    uint64_t samples = pushed_samples + (HostPlatform.getAnalogReadCount() - start_reads);
+    printf("%-12s %8u %14.0f %8.0f %8.0f %8.0f %8.0f %10zu\n", rMode.name, channels,
+            samples / seconds, Latency.quantile(0.50), Latency.quantile(0.90),
+            Latency.quantile(0.99), Latency.quantile(0.999),
+            SensorWLED::getChannelRAMSize());
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Runs N instances and a SensorArray<N> on the same signal, one 
+         reading per channel per loop, and prints a table row.
+ */
+//-----------------------------------------------------------------------------
+template <uint8_t CHANNELS>
+static void runArrayBenchmark(AdcResolutionType_e bits) {
+
+    DynamicDataType_t Params = {};
+    Params.bits_resolution_adc = bits;
+    Params.mv_maxvoltage_adc = mv_vcc_3v3;
+    Params.ms_poll_time = 0;
+    Params.ms_hold_time = 250;
+    Params.decay_model = exponential_decay;
+    Params.decay_rate = 0.5;
+
+    uint32_t loops = CALLS_PER_RUN / CHANNELS;
+    SignalGenerator Signal;
+    Signal.begin(StripSignal, bits, mv_vcc_3v3);
+
+    // N independent instances, each polled in the loop
+    HostPlatform.reset();
+    Signal.install();
+    std::vector<std::unique_ptr<SensorWLED>> Probes;
+    for (uint8_t ch = 0; ch < CHANNELS; ch++) {
+        Probes.emplace_back(new SensorWLED(ch));
+        Probes.back()->begin(Params);
+    }
+    uint64_t start_ns = nanoseconds();
+    for (uint32_t loop = 0; loop < loops; loop++) {
+        HostPlatform.advanceTime(US_LOOP_TIME);
+        for (auto &pProbe : Probes) {
+            pProbe->updateAnalogRead();
+        }
+    }
+    double instance_ns = (double) (nanoseconds() - start_ns) / (loops * CHANNELS);
+    uint32_t instance_reads = HostPlatform.getAnalogReadCount();
+    Probes.clear();
+
+    // One array, one update() (conversion) per channel
+    HostPlatform.reset();
+    Signal.install();
+    std::unique_ptr<SensorArray<CHANNELS>> pArray(new SensorArray<CHANNELS>);
+    for (uint8_t ch = 0; ch < CHANNELS; ch++) {
+        pArray->addChannel(ch, Params);
+    }
+    start_ns = nanoseconds();
+    for (uint32_t loop = 0; loop < loops; loop++) {
+        HostPlatform.advanceTime(US_LOOP_TIME);
+        for (uint8_t ch = 0; ch < CHANNELS; ch++) {
+            pArray->update();
+        }
+    }
+    double array_ns = (double) (nanoseconds() - start_ns) / (loops * CHANNELS);
+    uint32_t array_reads = HostPlatform.getAnalogReadCount();
+
+    printf("%8u %14.1f %14.1f %10zu %10zu %s\n", CHANNELS, instance_ns, array_ns,
+            SensorWLED::getChannelRAMSize(), sizeof(SensorArray<CHANNELS>) / CHANNELS,
+            (instance_reads == array_reads) ? "" : "(reading counts differ)");
+}
+
+int main(int argc, char *argv[]) {
+
+    uint16_t max_channels = (argc > 1) ? atoi(argv[1]) : 1000;
+    AdcResolutionType_e bits = (AdcResolutionType_e) ((argc > 2) ? atoi(argv[2]) : bits12);
+
+    printf("%-12s %8s %14s %8s %8s %8s %8s %10s\n", "mode", "channels", "samples/s",
+            "p50 ns", "p90 ns", "p99 ns", "p99.9 ns", "RAM/ch");
+    for (BenchmarkModeType_t const &rMode : Modes) {
+        for (uint16_t channels = 1; channels <= max_channels; channels *= 10) {
+            runBenchmark(rMode, channels, bits);
+        }
+    }
+
+    printf("\n%8s %14s %14s %10s %10s\n", "channels", "instances ns", "array ns",
+            "RAM/ch", "array RAM/ch");
+    runArrayBenchmark<1>(bits);
+    runArrayBenchmark<4>(bits);
+    runArrayBenchmark<8>(bits);
+    runArrayBenchmark<32>(bits);
+    return 0;
+}
+
+// EOF
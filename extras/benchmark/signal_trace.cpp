@@ -0,0 +1,79 @@
+/*!
+ * @file signal_trace.cpp
+ *
+ * This is part of SensorWLED library for the Arduino platform.
+ * Source: https://github.com/berrak/SensorWLED
+ *
+ * The MIT license.
+ *
+ * Writes a synthetic WLED strip current (HostSignal.h) as a trace file, to
+ * tune the poll, hold and decay parameters with extras/replay/sensor_replay.
+ *
+ * Build on the host (plog headers on the include path):
+ *   g++ -std=c++17 -O2 -Isrc -I<plog>/include extras/benchmark/signal_trace.cpp \
+ *       src/SensorWLED.cpp src/ConfigStore.cpp src/CalibrationTable.cpp \
+ *       -o signal_trace
+ *
+ * Usage:
+ *   signal_trace out.swtr [seconds [hz_sample_rate [bits [seed]]]]
+ *   e.g. signal_trace strip.swtr 600 1000 4095
+ */
+#include "SensorWLED.h"
+#include "HostSignal.h"
+#include "HostReplay.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+#define TRACE_PIN 33            // Analog pin of the readings
+
+/** A typical strip: effects, ramps, 1 kHz PWM, data bursts, and noise */
+static const SignalDataType_t StripSignal = {
+    .mv_idle = 150,
+    .mv_full = 2800,
+    .ms_effect_time = 40,
+    .effect_depth = 0.6,
+    .ms_ramp_time = 3000,
+    .hz_pwm = 1000,
+    .pwm_ripple = 0.3,
+    .spike_rate = 5,
+    .mv_spike = 400,
+    .us_spike_time = 300,
+    .mv_noise = 8,
+    .hz_tone = 0,
+    .mv_tone = 0,
+};
+
+int main(int argc, char *argv[]) {
+
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s out.swtr [seconds [hz_sample_rate [bits [seed]]]]\n", argv[0]);
+        return 2;
+    }
+    uint32_t seconds = (argc > 2) ? atoi(argv[2]) : 60;
+    float hz_sample_rate = (argc > 3) ? atof(argv[3]) : 1000;
+    AdcResolutionType_e bits = (AdcResolutionType_e) ((argc > 4) ? atoi(argv[4]) : bits12);
+    uint32_t seed = (argc > 5) ? atoi(argv[5]) : 1;
+
+    SignalGenerator Signal;
+    Signal.begin(StripSignal, bits, mv_vcc_3v3, seed);
+
+    TraceWriter Trace;
+    if (!Trace.open(argv[1])) {
+        fprintf(stderr, "%s: can not create\n", argv[1]);
+        return 1;
+    }
+    uint64_t count = (uint64_t) (seconds * hz_sample_rate);
+    for (uint64_t cnt = 0; cnt < count; cnt++) {
+        uint64_t us_time = (uint64_t) (cnt * 1e6 / hz_sample_rate);
+        Trace.add(us_time, TRACE_PIN, Signal.getCode(us_time, TRACE_PIN));
+    }
+    if (!Trace.close()) {
+        fprintf(stderr, "%s: write error\n", argv[1]);
+        return 1;
+    }
+    fprintf(stderr, "%llu readings\n", (unsigned long long) count);
+    return 0;
+}
+
+// EOF
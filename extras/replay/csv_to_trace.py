@@ -0,0 +1,61 @@
+#!/usr/bin/env python3
+#
+# This is part of SensorWLED library for the Arduino platform.
+# Source: https://github.com/berrak/SensorWLED
+#
+# The MIT license.
+#
+"""Converts recorded ADC readings from CSV to a trace file for the replay
+(HostReplay.h, sensor_replay).
+
+    csv_to_trace.py readings.csv field.swtr
+
+The CSV has a header row, with either the columns us_time,pin,code or the
+columns channel,ms_time,raw of extras/telemetry/telemetry_decode.py. For
+telemetry, --pin CHANNEL=PIN maps a channel id to its analog pin (default:
+the pin is the channel id).
+"""
+
+import argparse
+import csv
+import struct
+import sys
+
+TRACE_HEADER = struct.Struct("<4sHH")   # magic, format, record size
+TRACE_RECORD = struct.Struct("<IHBB")   # us_time, code, pin, reserved
+
+
+def main():
+    parser = argparse.ArgumentParser(description="CSV readings to a SensorWLED trace")
+    parser.add_argument("csv", help="CSV file, '-' for stdin")
+    parser.add_argument("trace", help="trace file to write")
+    parser.add_argument("--pin", action="append", default=[], metavar="CHANNEL=PIN",
+                        help="analog pin of a telemetry channel id")
+    args = parser.parse_args()
+
+    pins = {}
+    for item in args.pin:
+        channel, pin = item.split("=")
+        pins[int(channel)] = int(pin)
+
+    source = sys.stdin if args.csv == "-" else open(args.csv, newline="")
+    reader = csv.DictReader(source)
+    count = 0
+    with open(args.trace, "wb") as out:
+        out.write(TRACE_HEADER.pack(b"SWTR", 1, TRACE_RECORD.size))
+        for row in reader:
+            if "us_time" in row:
+                us_time, pin, code = int(row["us_time"]), int(row["pin"]), int(row["code"])
+            else:
+                channel = int(row["channel"])
+                us_time = int(row["ms_time"]) * 1000
+                pin, code = pins.get(channel, channel), int(row["raw"])
+            out.write(TRACE_RECORD.pack(us_time & 0xFFFFFFFF, code, pin, 0))
+            count += 1
+
+    sys.stderr.write("%d readings\n" % count)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,81 @@
+/*!
+ * @file sensor_replay.cpp
+ *
+ * This is part of SensorWLED library for the Arduino platform.
+ * Source: https://github.com/berrak/SensorWLED
+ *
+ * The MIT license.
+ *
+ * Replays a recorded ADC trace through one SensorWLED instance, on the
+ * virtual clock, and prints each new value as CSV:
+ *
+ *   ms_time,raw,peak_raw,mapped_mv,peak_mv
+ *
+ * The same trace always gives the same output, so a diff of the output of
+ * two library versions shows any change of the peak/decay behaviour.
+ *
+ * Build on the host (plog headers on the include path):
+ *   g++ -std=c++17 -O2 -Isrc -I<plog>/include extras/replay/sensor_replay.cpp \
+ *       src/SensorWLED.cpp src/ConfigStore.cpp src/CalibrationTable.cpp \
+ *       -o sensor_replay
+ *
+ * Usage:
+ *   sensor_replay trace.swtr pin [bits mv_vcc poll_ms hold_ms model rate]
+ *   e.g. sensor_replay field.swtr 33 4095 3300 0 250 1 0.5
+ */
+#include "SensorWLED.h"
+#include "HostReplay.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+int main(int argc, char *argv[]) {
+
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s trace.swtr pin [bits mv_vcc poll_ms hold_ms model rate]\n",
+                                                                            argv[0]);
+        return 2;
+    }
+
+    TraceReplay Replay;
+    if (!Replay.open(argv[1])) {
+        fprintf(stderr, "%s: not a trace file\n", argv[1]);
+        return 1;
+    }
+
+    DynamicDataType_t Params = {};
+    Params.bits_resolution_adc = (AdcResolutionType_e) ((argc > 3) ? atoi(argv[3]) : bits12);
+    Params.mv_maxvoltage_adc = (VoltageVccType_e) ((argc > 4) ? atoi(argv[4]) : mv_vcc_3v3);
+    Params.ms_poll_time = (argc > 5) ? atoi(argv[5]) : 0;
+    Params.ms_hold_time = (argc > 6) ? atoi(argv[6]) : 250;
+    Params.decay_model = (DecayModelType_e) ((argc > 7) ? atoi(argv[7]) : exponential_decay);
+    Params.decay_rate = (argc > 8) ? atof(argv[8]) : 0.5;
+
+    // The timers of the instance start at the first reading
+    SensorWLED Probe(atoi(argv[2]));
+    Probe.begin(Params);
+
+    auto start_time = std::chrono::steady_clock::now();
+    uint64_t us_first_time = HostPlatform.getVirtualTime();
+    uint32_t update_count = 0;
+
+    printf("ms_time,raw,peak_raw,mapped_mv,peak_mv\n");
+    while (Replay.step()) {
+        if (Replay.isUpdated(Probe.getChannelId())) {
+            update_count++;
+            printf("%u,%u,%u,%.3f,%.3f\n", millis(), Probe.getRawValue(),
+                    Probe.getRawPeakValue(), Probe.getMappedValue(), Probe.getMappedPeakValue());
+        }
+    }
+
+    double wall_seconds = std::chrono::duration<double>(
+                            std::chrono::steady_clock::now() - start_time).count();
+    double trace_seconds = (HostPlatform.getVirtualTime() - us_first_time) / 1e6;
+    fprintf(stderr, "%zu readings, %u updates, %.1f s of trace in %.3f s (%.0fx)\n",
+            Replay.getRecordCount(), update_count, trace_seconds, wall_seconds,
+            (wall_seconds > 0) ? trace_seconds / wall_seconds : 0);
+    return 0;
+}
+
+// EOF
@@ -0,0 +1,162 @@
+/*!
+ * @file telemetry_capture.cpp
+ *
+ * This is part of SensorWLED library for the Arduino platform.
+ * Source: https://github.com/berrak/SensorWLED
+ *
+ * The MIT license.
+ *
+ * Writes a telemetry capture on the host, as the example
+ * SensorWLED_Telemetry sends it, and the CSV the decoder should give:
+ *
+ *   - 'CHANNEL_COUNT' probes poll a synthetic strip signal (HostSignal.h)
+ *     on the virtual clock, each reading is added with add(SensorWLED &),
+ *     and a frame is sent when full or every 'MS_FRAME_TIME' ms,
+ *   - a last frame of edge cases: 16-bit codes from 0 to 65535 and back,
+ *     a channel id above MAX_CHANNELS, and a millis() wrap.
+ *
+ * The round trip, encode -> decode, is then checked with:
+ *   telemetry_capture capture.bin expected.csv
+ *   extras/telemetry/telemetry_decode.py capture.bin -o readings.csv --expect expected.csv
+ *
+ * Build on the host (plog headers on the include path):
+ *   g++ -std=c++17 -O2 -Isrc -I<plog>/include extras/telemetry/telemetry_capture.cpp \
+ *       src/SensorWLED.cpp src/ConfigStore.cpp src/CalibrationTable.cpp \
+ *       src/Telemetry.cpp -o telemetry_capture
+ */
+#include "SensorWLED.h"
+#include "Telemetry.h"
+#include "HostSignal.h"
+
+#include <cstdio>
+
+#define CHANNEL_COUNT 4         // Probes, on pins 0..CHANNEL_COUNT-1
+#define US_LOOP_TIME 250        // Virtual time of one loop()
+#define LOOP_COUNT 240000UL     // Loops, 60 s
+#define MS_FRAME_TIME 100       // Send a frame at least every 100 ms
+
+/** A typical strip: effects, ramps, 1 kHz PWM, data bursts, and noise */
+static const SignalDataType_t StripSignal = {
+    .mv_idle = 150,
+    .mv_full = 2800,
+    .ms_effect_time = 40,
+    .effect_depth = 0.6,
+    .ms_ramp_time = 3000,
+    .hz_pwm = 1000,
+    .pwm_ripple = 0.3,
+    .spike_rate = 5,
+    .mv_spike = 400,
+    .us_spike_time = 300,
+    .mv_noise = 8,
+    .hz_tone = 0,
+    .mv_tone = 0,
+};
+
+static TelemetryEncoder Telemetry;
+static FILE *pCapture;
+static FILE *pExpected;
+static uint32_t frame_count = 0;
+static uint32_t record_count = 0;
+static uint32_t capture_bytes = 0;
+
+static void sendFrame(void) {
+
+    size_t length = Telemetry.finish();
+    if (length > 0) {
+        fwrite(Telemetry.getFrame(), 1, length, pCapture);
+        frame_count++;
+        capture_bytes += length;
+    }
+}
+
+/** Adds a record, and writes the CSV row the decoder should give */
+static void addRecord(uint16_t channel_id, uint32_t ms_time, uint16_t raw_value,
+                                                        uint16_t pk_raw_value) {
+    if (!Telemetry.add(channel_id, ms_time, raw_value, pk_raw_value)) {
+        sendFrame();
+        Telemetry.add(channel_id, ms_time, raw_value, pk_raw_value);
+    }
+    fprintf(pExpected, "%u,%lu,%u,%u\n", channel_id, (unsigned long) ms_time,
+                                                        raw_value, pk_raw_value);
+    record_count++;
+}
+
+static void addSensor(SensorWLED &rSensor) {
+
+    if (!Telemetry.add(rSensor)) {
+        sendFrame();
+        Telemetry.add(rSensor);
+    }
+    fprintf(pExpected, "%u,%lu,%u,%u\n", rSensor.getChannelId(), (unsigned long) millis(),
+                                        rSensor.getRawValue(), rSensor.getRawPeakValue());
+    record_count++;
+}
+
+int main(int argc, char *argv[]) {
+
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s capture.bin expected.csv\n", argv[0]);
+        return 2;
+    }
+    pCapture = fopen(argv[1], "wb");
+    pExpected = fopen(argv[2], "w");
+    if (pCapture == NULL || pExpected == NULL) {
+        fprintf(stderr, "can't write %s or %s\n", argv[1], argv[2]);
+        return 1;
+    }
+    fprintf(pExpected, "channel,ms_time,raw,peak\n");
+
+    HostPlatform.reset();
+    SignalGenerator Signal;
+    Signal.begin(StripSignal, bits12, mv_vcc_3v3);
+    Signal.install();
+
+    DynamicDataType_t Params = {};
+    Params.bits_resolution_adc = bits12;
+    Params.mv_maxvoltage_adc = mv_vcc_3v3;
+    Params.ms_poll_time = 5;
+    Params.ms_hold_time = 250;
+    Params.decay_model = exponential_decay;
+    Params.decay_rate = 0.5;
+
+    SensorWLED Probes[CHANNEL_COUNT] = {0, 1, 2, 3};
+    for (SensorWLED &rProbe : Probes) {
+        rProbe.begin(Params);
+    }
+
+    // The loop() of the example
+    uint32_t previous_frame_millis_tm = millis();
+    for (uint32_t loop = 0; loop < LOOP_COUNT; loop++) {
+        HostPlatform.advanceTime(US_LOOP_TIME);
+        for (SensorWLED &rProbe : Probes) {
+            if (rProbe.updateAnalogRead()) {
+                addSensor(rProbe);
+            }
+        }
+        if (millis() - previous_frame_millis_tm >= MS_FRAME_TIME) {
+            previous_frame_millis_tm = millis();
+            sendFrame();
+        }
+    }
+    sendFrame();
+    uint32_t stream_records = record_count;
+
+    // Edge cases: the largest deltas, a channel id without deltas, a wrap
+    addRecord(1, 0xFFFFFFF0UL, 0, 65535);
+    addRecord(1, 0xFFFFFFF8UL, 65535, 0);
+    addRecord(1, 0x00000004UL, 0, 0);
+    addRecord(MAX_CHANNELS, 0x00000010UL, 65535, 65535);
+    addRecord(MAX_CHANNELS + 1, 0x00000010UL, 40000, 12);
+    addRecord(65535, 0x7FFFFFFFUL, 65535, 0);
+    sendFrame();
+
+    fclose(pCapture);
+    fclose(pExpected);
+    printf("%lu records (%lu of the probes), %lu frames, %lu bytes, %.2f bytes/sample\n",
+            (unsigned long) record_count, (unsigned long) stream_records,
+            (unsigned long) frame_count, (unsigned long) capture_bytes,
+            (double) capture_bytes / record_count);
+    return 0;
+}
+
+// EOF
@@ -0,0 +1,173 @@
+#!/usr/bin/env python3
+#
+# This is part of SensorWLED library for the Arduino platform.
+# Source: https://github.com/berrak/SensorWLED
+#
+# The MIT license.
+#
+"""Decodes a captured SensorWLED telemetry stream (TelemetryEncoder frames)
+to CSV: channel,ms_time,raw,peak
+
+    telemetry_decode.py capture.bin > readings.csv
+
+Frames with a bad CRC32 are skipped, and the stream is searched for the next
+frame start. A frame sent twice (same sequence number) is decoded once. A
+summary, with the bytes per sample, goes to stderr.
+
+With --expect, the records are compared with a CSV of the same columns, e.g.
+of extras/telemetry/telemetry_capture.cpp, to check the encode -> decode
+round trip:
+
+    telemetry_capture capture.bin expected.csv
+    telemetry_decode.py capture.bin -o readings.csv --expect expected.csv
+"""
+
+import argparse
+import sys
+import zlib
+
+TELEMETRY_SYNC = b"\xa5\x5a"
+TELEMETRY_FORMAT = 1
+MAX_CHANNELS = 32
+
+
+def read_varint(data, pos):
+    """Returns (value, next position), unsigned LEB128."""
+    value = 0
+    shift = 0
+    while True:
+        if pos >= len(data) or shift > 28:
+            raise ValueError("truncated varint")
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        if byte < 0x80:
+            return value, pos
+        shift += 7
+
+
+def read_zigzag(data, pos):
+    """Returns (signed value, next position)."""
+    value, pos = read_varint(data, pos)
+    return (value >> 1) ^ -(value & 1), pos
+
+
+def decode_body(body, max_channels=MAX_CHANNELS):
+    """Returns (sequence, records), records are (channel, ms_time, raw, peak)."""
+    if not body or body[0] != TELEMETRY_FORMAT:
+        raise ValueError("unknown format")
+    sequence, pos = read_varint(body, 1)
+    ms_time, pos = read_varint(body, pos)
+
+    previous_raw = [0] * (max_channels + 1)
+    records = []
+    while pos < len(body):
+        channel, pos = read_varint(body, pos)
+        dt_ms, pos = read_varint(body, pos)
+        raw_delta, pos = read_zigzag(body, pos)
+        peak_delta, pos = read_zigzag(body, pos)
+
+        ms_time = (ms_time + dt_ms) & 0xFFFFFFFF
+        raw = raw_delta + (previous_raw[channel] if channel <= max_channels else 0)
+        if channel <= max_channels:
+            previous_raw[channel] = raw
+        records.append((channel, ms_time, raw, raw + peak_delta))
+    return sequence, records
+
+
+def decode_stream(data, stats, max_channels=MAX_CHANNELS):
+    """Yields the records of all valid frames in 'data'."""
+    pos = 0
+    previous_sequence = None
+    while True:
+        start = data.find(TELEMETRY_SYNC, pos)
+        if start < 0:
+            return
+        try:
+            body_size, body_start = read_varint(data, start + 2)
+            body_end = body_start + body_size
+            if body_end + 4 > len(data):
+                raise ValueError("truncated frame")
+            body = data[body_start:body_end]
+            crc32 = int.from_bytes(data[body_end:body_end + 4], "little")
+            if zlib.crc32(body) != crc32:
+                raise ValueError("bad CRC32")
+            sequence, records = decode_body(body, max_channels)
+        except ValueError:
+            stats["bad_frames"] += 1
+            pos = start + 1
+            continue
+
+        pos = body_end + 4
+        if sequence == previous_sequence:
+            stats["repeated_frames"] += 1
+            continue
+        if previous_sequence is not None and sequence != previous_sequence + 1:
+            stats["lost_frames"] += (sequence - previous_sequence - 1) & 0xFFFFFFFF
+        previous_sequence = sequence
+
+        stats["frames"] += 1
+        stats["records"] += len(records)
+        stats["frame_bytes"] += body_end + 4 - start
+        yield from records
+
+
+def compare_records(records, expect_file):
+    """Returns the number of records that differ from the expected CSV."""
+    with open(expect_file) as f:
+        lines = f.read().splitlines()[1:]
+    expected = [tuple(int(field) for field in line.split(",")) for line in lines if line]
+
+    mismatches = abs(len(records) - len(expected))
+    shown = 0
+    for index, (record, expected_record) in enumerate(zip(records, expected)):
+        if record != expected_record:
+            if shown < 10:
+                shown += 1
+                sys.stderr.write("record %d: %s, expected %s\n" % (index + 1,
+                    ",".join(map(str, record)), ",".join(map(str, expected_record))))
+            mismatches += 1
+    sys.stderr.write("round trip: %d records decoded, %d expected, %d differ\n" % (
+        len(records), len(expected), mismatches))
+    return mismatches
+
+
+def main():
+    parser = argparse.ArgumentParser(description="SensorWLED telemetry to CSV")
+    parser.add_argument("capture", help="captured binary stream, '-' for stdin")
+    parser.add_argument("-o", "--output", help="CSV file (default: stdout)")
+    parser.add_argument("--max-channels", type=int, default=MAX_CHANNELS,
+                        help="MAX_CHANNELS of the sketch (default: %(default)s)")
+    parser.add_argument("--expect", metavar="CSV",
+                        help="expected records, fails if the decoded ones differ")
+    args = parser.parse_args()
+
+    if args.capture == "-":
+        data = sys.stdin.buffer.read()
+    else:
+        with open(args.capture, "rb") as f:
+            data = f.read()
+
+    stats = dict(frames=0, bad_frames=0, lost_frames=0, repeated_frames=0,
+                 records=0, frame_bytes=0)
+    records = list(decode_stream(data, stats, args.max_channels))
+    out = open(args.output, "w") if args.output else sys.stdout
+    out.write("channel,ms_time,raw,peak\n")
+    for record in records:
+        out.write("%d,%d,%d,%d\n" % record)
+    if out is not sys.stdout:
+        out.close()
+
+    per_sample = stats["frame_bytes"] / stats["records"] if stats["records"] else 0
+    sys.stderr.write(
+        "frames %d (bad %d, lost %d, repeated %d), records %d, %d of %d bytes "
+        "in frames, %.2f bytes/sample\n" % (stats["frames"], stats["bad_frames"],
+        stats["lost_frames"], stats["repeated_frames"], stats["records"],
+        stats["frame_bytes"], len(data), per_sample))
+
+    mismatches = compare_records(records, args.expect) if args.expect else 0
+    return 0 if stats["bad_frames"] == 0 and mismatches == 0 else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,125 @@
+/*!
+ * @file block_wrap_test.cpp
+ *
+ * This is part of SensorWLED library for the Arduino platform.
+ * Source: https://github.com/berrak/SensorWLED
+ *
+ * The MIT license.
+ *
+ * processBlock() across the micros() wraparound, i.e. with block times
+ * from the 32-bit micros() that wrap every 71.6 minutes. The blocks are
+ * 'BLOCK_SIZE' samples 'US_SAMPLE_TIME' apart, back to back, starting
+ * 'US_BEFORE_WRAP' before the wrap. Checks:
+ *
+ *   - the integrated time and charge of a constant input are those of the
+ *     elapsed time, not of a jump back by 4294967 ms,
+ *   - a peak before the wrap is held for the hold time (60 s), and then
+ *     decays once per hold period, not to the floor at the wrap.
+ *
+ * Build and run on the host:
+ *   g++ -std=c++17 -O2 -Isrc -I<plog>/include extras/tests/block_wrap_test.cpp \
+ *       src/SensorWLED.cpp src/ConfigStore.cpp src/CalibrationTable.cpp \
+ *       -o block_wrap_test && ./block_wrap_test
+ *
+ * Returns 0 if all checks pass.
+ */
+#include "SensorWLED.h"
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#define BLOCK_SIZE 100          // Samples per block
+#define US_SAMPLE_TIME 100      // Time between samples, i.e. 10 ms blocks
+#define US_BEFORE_WRAP 1000000UL// First block, 1 s before the wrap
+#define ADC_CODE 2000           // Constant input, 12 bits
+#define PEAK_CODE 4000          // A peak, before the wrap
+#define FLOOR_CODE 100          // The input after the peak
+#define MS_HOLD_TIME 60000      // Hold time of the peak
+
+static int failures = 0;
+static uint32_t DecayOnce[DECAY_TABLE_SIZE];
+
+static void check(bool ok_flag, const char *name, double detail) {
+    printf("%-44s %s (%.3f)\n", name, ok_flag ? "ok" : "FAILED", detail);
+    if (!ok_flag) {
+        failures++;
+    }
+}
+
+static void beginProbe(SensorWLED &rProbe, uint16_t ms_hold_time) {
+
+    DynamicDataType_t Params = {};
+    Params.bits_resolution_adc = bits12;
+    Params.mv_maxvoltage_adc = mv_vcc_3v3;
+    Params.ms_poll_time = 0;
+    Params.ms_hold_time = ms_hold_time;
+    Params.decay_model = exponential_decay;
+    Params.decay_rate = 0.5;
+    rProbe.begin(Params);
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Feeds blocks of 'code' for 'us_run_time', from 't0_us' on.
+ @return The start time of the next block.
+ */
+//-----------------------------------------------------------------------------
+static uint32_t runBlocks(SensorWLED &rProbe, uint16_t code, uint32_t t0_us,
+                                                        uint32_t us_run_time) {
+
+    std::vector<uint16_t> codes(BLOCK_SIZE, code);
+    for (uint32_t us_time = 0; us_time < us_run_time; us_time += BLOCK_SIZE * US_SAMPLE_TIME) {
+        rProbe.processBlock(codes.data(), codes.size(), t0_us, US_SAMPLE_TIME);
+        t0_us += BLOCK_SIZE * US_SAMPLE_TIME;
+    }
+    return t0_us;
+}
+
+int main(void) {
+
+    HostPlatform.reset();
+    SensorWLED::generateDecayTable(DecayOnce, exponential_decay, 0.5);
+
+    // 2 s of a constant input, the wrap after 1 s
+    SensorWLED Integrator(0);
+    beginProbe(Integrator, 250);
+    runBlocks(Integrator, ADC_CODE, 0 - (uint32_t) US_BEFORE_WRAP, 2 * US_BEFORE_WRAP);
+
+    // The first block starts the integral, at its last sample
+    double seconds = 2.0 - BLOCK_SIZE * US_SAMPLE_TIME / 1e6;
+    double mv_value = Integrator.getMappedValue();
+    check(fabs(Integrator.getIntegratedSeconds() - seconds) < 1e-3,
+            "integrated time across the wrap (s)", Integrator.getIntegratedSeconds());
+    check(fabs(Integrator.getCharge() - mv_value * seconds / 3600) < 1e-6,
+            "integrated charge across the wrap (mVh)", Integrator.getCharge());
+
+    // A peak, then a low input across the wrap
+    SensorWLED Hold(1);
+    beginProbe(Hold, MS_HOLD_TIME);
+    uint32_t t_start_us = 0 - (uint32_t) US_BEFORE_WRAP;
+    uint32_t t0_us = runBlocks(Hold, PEAK_CODE, t_start_us, 10000);
+    t0_us = runBlocks(Hold, FLOOR_CODE, t0_us, US_BEFORE_WRAP + 30000);
+    check(Hold.getRawPeakValue() == PEAK_CODE, "peak held, 40 ms after the wrap",
+            Hold.getRawPeakValue());
+
+    // The hold periods keep their phase, from time 0: one decay, then two
+    uint32_t ms_peak_time = t_start_us / 1000;
+    uint32_t ms_to_decay = MS_HOLD_TIME - ms_peak_time % MS_HOLD_TIME - 
+                                                (t0_us - t_start_us) / 1000;
+    t0_us = runBlocks(Hold, FLOOR_CODE, t0_us, (ms_to_decay - 1000) * 1000);
+    check(Hold.getRawPeakValue() == PEAK_CODE, "peak held, 1 s before the hold ends",
+            Hold.getRawPeakValue());
+    uint16_t once = SensorWLED::applyDecayTable(DecayOnce, PEAK_CODE, 1);
+    t0_us = runBlocks(Hold, FLOOR_CODE, t0_us, 2000000);
+    check(Hold.getRawPeakValue() == once, "one decay, 1 s after the hold ends",
+            Hold.getRawPeakValue());
+    runBlocks(Hold, FLOOR_CODE, t0_us, MS_HOLD_TIME * 1000UL);
+    check(Hold.getRawPeakValue() == SensorWLED::applyDecayTable(DecayOnce, once, 1),
+            "two decays, after another hold time", Hold.getRawPeakValue());
+
+    printf("%s\n", (failures == 0) ? "PASSED" : "FAILED");
+    return (failures == 0) ? 0 : 1;
+}
+
+// EOF
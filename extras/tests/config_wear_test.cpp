@@ -0,0 +1,158 @@
+/*!
+ * @file config_wear_test.cpp
+ *
+ * This is part of SensorWLED library for the Arduino platform.
+ * Source: https://github.com/berrak/SensorWLED
+ *
+ * The MIT license.
+ *
+ * Wear of the ConfigStore record log, on the sector model of HostEEPROM.h.
+ * Writes 'UPDATE_COUNT' changed records of 'CHANNEL_COUNT' channels, each
+ * with its own commit, as repeated recalibrations, and checks:
+ *
+ *   - the log compacts, and both banks are used,
+ *   - the erases are spread over the sectors of both banks, and the most
+ *     erased sector has a small part of the erases of a record rewritten
+ *     in place (one per commit),
+ *   - the sectors before the log are never erased,
+ *   - after a reboot, each channel reads its last record,
+ *   - with the live records filling the bank, a record is still replaced,
+ *     and the compaction stays inside the bank.
+ *
+ * Build and run on the host:
+ *   g++ -std=c++17 -O2 -Isrc -I<plog>/include extras/tests/config_wear_test.cpp \
+ *       src/SensorWLED.cpp src/ConfigStore.cpp src/CalibrationTable.cpp \
+ *       -o config_wear_test && ./config_wear_test
+ *
+ * Returns 0 if all checks pass.
+ */
+#include "SensorWLED.h"
+#include "ConfigStore.h"
+
+#include <cstdio>
+
+#define UPDATE_COUNT 5000       // Records written, one commit each
+#define CHANNEL_COUNT 4         // Channels (ids 1..CHANNEL_COUNT)
+#define FULL_RECORD_SIZE 100    // Payload of the records that fill the bank
+#define FULL_ROUNDS 20          // Rewrites of each record of the full bank
+
+static int failures = 0;
+
+static void check(bool ok_flag, const char *name, unsigned long detail) {
+    printf("%-44s %s (%lu)\n", name, ok_flag ? "ok" : "FAILED", detail);
+    if (!ok_flag) {
+        failures++;
+    }
+}
+
+/** A record payload, the size of DynamicDataType_t */
+typedef struct {
+    uint32_t update;            ///< Update number
+    uint16_t id;                ///< Channel
+    uint8_t filler[sizeof(DynamicDataType_t) - 6];
+} WearRecordType_t;
+
+int main(void) {
+
+    ConfigStore Store;
+    Store.begin();
+
+    uint32_t commit_failures = 0;
+    for (uint32_t update = 0; update < UPDATE_COUNT; update++) {
+        WearRecordType_t Record = {};
+        Record.update = update;
+        Record.id = 1 + update % CHANNEL_COUNT;
+        commit_failures += !Store.write(dynamic_record, Record.id, &Record, sizeof(Record));
+        commit_failures += !Store.commit();
+    }
+    check(commit_failures == 0, "all writes and commits", commit_failures);
+
+    // The erase counts of the log sectors, and of the sectors before it
+    uint16_t first_sector = CONFIG_STORE_START / HOST_EEPROM_SECTOR_SIZE;
+    uint16_t last_sector = (CONFIG_STORE_START + 2 * CONFIG_BANK_SIZE - 1) / HOST_EEPROM_SECTOR_SIZE;
+    uint16_t boundary_sector = (CONFIG_STORE_START + CONFIG_BANK_SIZE) / HOST_EEPROM_SECTOR_SIZE;
+    uint32_t min_erases = UINT32_MAX;
+    uint32_t max_erases = 0;
+    uint32_t bank_erases[2] = {0, 0};
+    uint32_t outside_erases = 0;
+
+    printf("\nsector erases:");
+    for (uint16_t sector = 0; sector < HOST_EEPROM_SECTORS; sector++) {
+        uint32_t erases = EEPROM.getEraseCount(sector);
+        printf(" %lu", (unsigned long) erases);
+        if (sector < first_sector || sector > last_sector) {
+            outside_erases += erases;
+            continue;
+        }
+        bank_erases[(sector < boundary_sector) ? 0 : 1] += erases;
+        // The sector of the bank boundary is erased for both banks
+        if (sector != boundary_sector) {
+            min_erases = (erases < min_erases) ? erases : min_erases;
+            max_erases = (erases > max_erases) ? erases : max_erases;
+        }
+    }
+    printf("\ncompactions %lu, flash writes %lu\n\n", (unsigned long) Store.getCompactionCount(),
+            (unsigned long) EEPROM.getFlashWriteCount());
+
+    check(Store.getCompactionCount() > 1, "the log compacts", Store.getCompactionCount());
+    check(bank_erases[0] > 0 && bank_erases[1] > 0, "both banks are erased", bank_erases[1]);
+    check(max_erases <= min_erases + 1, "erases are even over the log sectors", max_erases - min_erases);
+    check(EEPROM.getEraseCount(boundary_sector) <= 2 * max_erases,
+            "the boundary sector, for both banks", EEPROM.getEraseCount(boundary_sector));
+    check(max_erases * 20 <= UPDATE_COUNT, "most erases, under 5% of in place", max_erases);
+    check(outside_erases == 0, "no erases before the log", outside_erases);
+
+    // Reboot, the index is rebuilt from the flash
+    ConfigStore Rebooted;
+    Rebooted.begin();
+    uint32_t wrong_records = 0;
+    for (uint16_t id = 1; id <= CHANNEL_COUNT; id++) {
+        WearRecordType_t Record = {};
+        uint32_t last_update = (UPDATE_COUNT - id) / CHANNEL_COUNT * CHANNEL_COUNT + id - 1;
+        wrong_records += !Rebooted.read(dynamic_record, id, &Record, sizeof(Record)) ||
+                            Record.update != last_update || Record.id != id;
+    }
+    check(wrong_records == 0 && Rebooted.getRecordCount() == CHANNEL_COUNT,
+            "reboot, the last record of each channel", wrong_records);
+
+    // Fill the bank with live records, until a new one is refused
+    uint8_t payload[FULL_RECORD_SIZE] = {};
+    uint16_t full_count = 0;
+    while (full_count < MAX_CHANNELS) {
+        payload[0] = full_count;
+        if (!Rebooted.write(calibration_record, full_count + 1, payload, sizeof(payload))) {
+            break;
+        }
+        full_count++;
+    }
+    Rebooted.commit();
+
+    // Replace each of them, i.e. compact with a full set of live records
+    uint32_t full_failures = 0;
+    uint16_t max_used_bytes = 0;
+    for (uint8_t round = 1; round <= FULL_ROUNDS; round++) {
+        for (uint16_t id = 1; id <= full_count; id++) {
+            payload[0] = id - 1 + round;
+            full_failures += !Rebooted.write(calibration_record, id, payload, sizeof(payload));
+            uint16_t used_bytes = Rebooted.getUsedBytes();
+            max_used_bytes = (used_bytes > max_used_bytes) ? used_bytes : max_used_bytes;
+        }
+        full_failures += !Rebooted.commit();
+    }
+    check(full_count > 1 && full_failures == 0, "full bank, each record replaced", full_failures);
+    check(max_used_bytes <= CONFIG_BANK_SIZE, "full bank, compaction inside the bank", max_used_bytes);
+
+    ConfigStore Full;
+    Full.begin();
+    uint32_t wrong_full = 0;
+    for (uint16_t id = 1; id <= full_count; id++) {
+        wrong_full += !Full.read(calibration_record, id, payload, sizeof(payload)) ||
+                            payload[0] != (uint8_t) (id - 1 + FULL_ROUNDS);
+    }
+    check(wrong_full == 0, "full bank, reboot reads the last records", wrong_full);
+
+    printf("%s\n", (failures == 0) ? "PASSED" : "FAILED");
+    return (failures == 0) ? 0 : 1;
+}
+
+// EOF
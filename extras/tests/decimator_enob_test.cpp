@@ -0,0 +1,181 @@
+/*!
+ * @file decimator_enob_test.cpp
+ *
+ * This is part of SensorWLED library for the Arduino platform.
+ * Source: https://github.com/berrak/SensorWLED
+ *
+ * The MIT license.
+ *
+ * Effective number of bits (ENOB) of the decimation, on a 10-bit ADC (as
+ * the ESP8266) at 100 kHz. The input is a 37 Hz sine tone of HostSignal.h,
+ * 85 % of full scale, with about 1 LSB RMS of noise as dither. The codes
+ * go to processBlock(), and setReadingTap() collects the readings.
+ *
+ * The ENOB follows IEEE 1241: a sine of the known frequency is fitted to
+ * the readings (least squares), and ENOB = log2(FSR / (sqrt(12) * NAD)),
+ * with the full-scale range FSR and the RMS residual NAD (noise and
+ * distortion), both in ADC codes. Checks:
+ *
+ *   - without decimation, the ENOB is limited by the noise (8 to 9 bits),
+ *   - each four times the ratio (4, 16, 64) adds about one bit, at least
+ *     3/4 bit.
+ *
+ * Build and run on the host:
+ *   g++ -std=c++17 -O2 -Isrc -I<plog>/include extras/tests/decimator_enob_test.cpp \
+ *       src/SensorWLED.cpp src/ConfigStore.cpp src/CalibrationTable.cpp \
+ *       -o decimator_enob_test && ./decimator_enob_test
+ *
+ * Returns 0 if all checks pass.
+ */
+#include "SensorWLED.h"
+#include "HostSignal.h"
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#define US_SAMPLE_TIME 10       // 100 kHz ADC
+#define SAMPLE_COUNT 4194304UL  // ADC samples per run, about 42 s
+#define BLOCK_SIZE 1024         // processBlock() samples
+#define HZ_TONE 37              // Below the passband edge of all ratios
+
+static int failures = 0;
+
+static void check(bool ok_flag, const char *name, double detail) {
+    printf("%-44s %s (%.2f)\n", name, ok_flag ? "ok" : "FAILED", detail);
+    if (!ok_flag) {
+        failures++;
+    }
+}
+
+/** A mid-scale 37 Hz tone, 85 % of full scale, 1 LSB of noise */
+static const SignalDataType_t ToneSignal = {
+    .mv_idle = 1650,
+    .mv_full = 1650,
+    .ms_effect_time = 0,
+    .effect_depth = 0,
+    .ms_ramp_time = 0,
+    .hz_pwm = 0,
+    .pwm_ripple = 0,
+    .spike_rate = 0,
+    .mv_spike = 0,
+    .us_spike_time = 0,
+    .mv_noise = 3.2,
+    .hz_tone = HZ_TONE,
+    .mv_tone = 1400,
+};
+
+/** Readings of the tap, at the output resolution */
+static void collectReading(uint16_t raw_value, uint32_t reading_millis, void *context) {
+    (void) reading_millis;
+    static_cast<std::vector<uint16_t> *>(context)->push_back(raw_value);
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Fits a sine of the tone frequency to equally spaced readings.
+ @param  rReadings
+         Readings, 'us_period' apart.
+ @param  us_period
+         Time between the readings (microseconds).
+ @return RMS of the residual, i.e. the noise and distortion.
+ */
+//-----------------------------------------------------------------------------
+static double fitResidual(std::vector<uint16_t> const &rReadings, double us_period) {
+
+    // Normal equations of a cos + b sin + c
+    double m[3][4] = {};
+    size_t n = rReadings.size();
+    for (size_t cnt = 0; cnt < n; cnt++) {
+        double phase = 2 * M_PI * HZ_TONE * cnt * us_period / 1e6;
+        double basis[3] = {cos(phase), sin(phase), 1};
+        for (uint8_t row = 0; row < 3; row++) {
+            for (uint8_t col = 0; col < 3; col++) {
+                m[row][col] += basis[row] * basis[col];
+            }
+            m[row][3] += basis[row] * rReadings[cnt];
+        }
+    }
+    for (uint8_t pivot = 0; pivot < 3; pivot++) {
+        for (uint8_t row = 0; row < 3; row++) {
+            if (row != pivot) {
+                double factor = m[row][pivot] / m[pivot][pivot];
+                for (uint8_t col = 0; col < 4; col++) {
+                    m[row][col] -= factor * m[pivot][col];
+                }
+            }
+        }
+    }
+    double a = m[0][3] / m[0][0], b = m[1][3] / m[1][1], c = m[2][3] / m[2][2];
+
+    double sq_sum = 0;
+    for (size_t cnt = 0; cnt < n; cnt++) {
+        double phase = 2 * M_PI * HZ_TONE * cnt * us_period / 1e6;
+        double residual = rReadings[cnt] - (a * cos(phase) + b * sin(phase) + c);
+        sq_sum += residual * residual;
+    }
+    return sqrt(sq_sum / n);
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Decimates the tone with a ratio, and returns the ENOB.
+ */
+//-----------------------------------------------------------------------------
+static double runRatio(std::vector<uint16_t> const &rCodes, uint8_t log2_ratio, uint8_t extra_bits) {
+
+    DynamicDataType_t Params = {};
+    Params.bits_resolution_adc = bits10;
+    Params.mv_maxvoltage_adc = mv_vcc_3v3;
+    Params.ms_poll_time = 0;
+    Params.ms_hold_time = 250;
+    Params.decay_model = exponential_decay;
+    Params.decay_rate = 0.5;
+
+    std::vector<uint16_t> readings;
+    SensorWLED Probe(0);
+    Probe.setDecimation(log2_ratio, extra_bits);
+    Probe.begin(Params);
+    Probe.setReadingTap(&collectReading, &readings);
+
+    for (size_t first = 0; first < rCodes.size(); first += BLOCK_SIZE) {
+        Probe.processBlock(&rCodes[first], BLOCK_SIZE, first * US_SAMPLE_TIME, US_SAMPLE_TIME);
+    }
+
+    // The residual in ADC codes, without the settling readings
+    readings.erase(readings.begin(), readings.begin() + CIC_ORDER);
+    double nad = fitResidual(readings, US_SAMPLE_TIME << log2_ratio) / (1 << extra_bits);
+    double enob = log2((bits10 + 1) / (sqrt(12) * nad));
+
+    printf("ratio %4u, extra bits %u: %8zu readings, noise %6.3f LSB, ENOB %5.2f\n",
+            1U << log2_ratio, extra_bits, readings.size(), nad, enob);
+    return enob;
+}
+
+int main(void) {
+
+    SignalGenerator Signal;
+    Signal.begin(ToneSignal, bits10, mv_vcc_3v3);
+    std::vector<uint16_t> codes(SAMPLE_COUNT);
+    for (size_t cnt = 0; cnt < codes.size(); cnt++) {
+        codes[cnt] = Signal.getCode((uint64_t) cnt * US_SAMPLE_TIME);
+    }
+
+    double native_enob = runRatio(codes, 0, 0);
+    check(native_enob > 8 && native_enob < 9, "no decimation, noise limited", native_enob);
+
+    double previous_enob = native_enob;
+    // Up to 64, the ratio is reduced above 128 for 10 bits (31-bit integrators)
+    for (uint8_t log2_ratio = 2; log2_ratio <= 6; log2_ratio += 2) {
+        double enob = runRatio(codes, log2_ratio, log2_ratio / 2 + 1);
+        char name[64];
+        snprintf(name, sizeof(name), "ratio %u, bits gained", 1U << log2_ratio);
+        check(enob - previous_enob >= 0.75, name, enob - previous_enob);
+        previous_enob = enob;
+    }
+
+    printf("%s\n", (failures == 0) ? "PASSED" : "FAILED");
+    return (failures == 0) ? 0 : 1;
+}
+
+// EOF
@@ -0,0 +1,127 @@
+/*!
+ * @file known_vector_test.cpp
+ *
+ * This is part of SensorWLED library for the Arduino platform.
+ * Source: https://github.com/berrak/SensorWLED
+ *
+ * The MIT license.
+ *
+ * Checks the library against published and offline reference values:
+ *
+ *   - CRC32 check values, e.g. "123456789" gives 0xCBF43926,
+ *   - the statistics (mean, RMS, min, max, variance) of a fixed sequence
+ *     of 64 codes, tumbling and sliding window, against the values of a
+ *     double-precision reference computed offline (Python), with the
+ *     offset and the 12-bit / 3300 mV scale of the channel.
+ *
+ * Build and run on the host:
+ *   g++ -std=c++17 -O2 -DSENSOR_MOVING_WINDOW=1 -Isrc -I<plog>/include \
+ *       extras/tests/known_vector_test.cpp \
+ *       src/SensorWLED.cpp src/ConfigStore.cpp src/CalibrationTable.cpp \
+ *       -o known_vector_test && ./known_vector_test
+ *
+ * Returns 0 if all checks pass.
+ */
+#include "SensorWLED.h"
+
+#if !SENSOR_MOVING_WINDOW
+    #error "Build with -DSENSOR_MOVING_WINDOW=1"
+#endif
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#define SLIDING_WINDOW 16       // Moving window of the channel
+#define MV_OFFSET 10            // Zero offset of the channel (mV)
+
+static_assert(STATS_WINDOW_SIZE == 64, "The reference is of 64 readings");
+
+static int failures = 0;
+
+static void check(bool ok_flag, const char *name, double detail) {
+    printf("%-44s %s (%.9g)\n", name, ok_flag ? "ok" : "FAILED", detail);
+    if (!ok_flag) {
+        failures++;
+    }
+}
+
+typedef struct {
+    const char *text;           ///< Input
+    uint32_t crc32;             ///< Published CRC-32 (IEEE 802.3) value
+} CRCVectorType_t;
+
+static const CRCVectorType_t CRCVectors[] = {
+    {"", 0x00000000},
+    {"a", 0xE8B7BE43},
+    {"123456789", 0xCBF43926},
+    {"The quick brown fox jumps over the lazy dog", 0x414FA339},
+};
+
+/** Reference statistics: mean, RMS, min, max (mV), variance (mV^2) */
+typedef struct {
+    const char *name;
+    double mean, rms, min, max, variance;
+} StatisticsVectorType_t;
+
+/*
+ * Offline reference, codes[i] = (37 i^2 + 11 i + 100) % 4096:
+ *   m = [3300 / 4095 * c - 10 for c in codes], the min and max are the
+ *   integer map() of the code less 10, the variance is of the population.
+ */
+static const StatisticsVectorType_t Tumbling = {
+    "tumbling window of 64",
+    1635.567765568, 1882.137772364, 70.0, 3289.0, 867360.678393645
+};
+static const StatisticsVectorType_t Sliding = {
+    "sliding window, last 16",
+    2061.062271062, 2173.705410413, 143.0, 3177.0, 477017.526063680
+};
+
+static void checkStatistics(StatisticsType_t const &rStats, StatisticsVectorType_t const &rRef,
+                                                                            uint32_t count) {
+    char name[64];
+    double error = fmax(fmax(fabs(rStats.mean - rRef.mean), fabs(rStats.rms - rRef.rms)),
+                        fmax(fabs(rStats.min - rRef.min), fabs(rStats.max - rRef.max)));
+    snprintf(name, sizeof(name), "%s, mean/rms/min/max", rRef.name);
+    check(rStats.count == count && error < 1e-6, name, error);
+    snprintf(name, sizeof(name), "%s, variance", rRef.name);
+    check(fabs(rStats.variance - rRef.variance) < 1e-6 * rRef.variance, name,
+                                                rStats.variance - rRef.variance);
+}
+
+int main(void) {
+
+    for (CRCVectorType_t const &rVector : CRCVectors) {
+        char name[64];
+        uint32_t crc32 = SensorWLED::calculateCRC32(rVector.text, strlen(rVector.text));
+        snprintf(name, sizeof(name), "CRC32 \"%.16s\" = 0x%08lX", rVector.text,
+                                                        (unsigned long) crc32);
+        check(crc32 == rVector.crc32, name, crc32 ^ rVector.crc32);
+    }
+
+    HostPlatform.reset();
+    DynamicDataType_t Params = {};
+    Params.bits_resolution_adc = bits12;
+    Params.mv_maxvoltage_adc = mv_vcc_3v3;
+    Params.ms_poll_time = 0;
+    Params.ms_hold_time = 250;
+    Params.decay_model = exponential_decay;
+    Params.decay_rate = 0.5;
+
+    SensorWLED Probe(0, MV_OFFSET, 1.0, 0, SLIDING_WINDOW);
+    Probe.begin(Params);
+
+    for (uint32_t cnt = 0; cnt < STATS_WINDOW_SIZE; cnt++) {
+        HostPlatform.setAnalogValue(0, (37 * cnt * cnt + 11 * cnt + 100) % 4096);
+        HostPlatform.advanceTime(1000);
+        Probe.updateAnalogRead();
+    }
+    checkStatistics(Probe.getWindowStatistics(), Tumbling, STATS_WINDOW_SIZE);
+    checkStatistics(Probe.getSlidingStatistics(), Sliding, SLIDING_WINDOW);
+
+    printf("%s\n", (failures == 0) ? "PASSED" : "FAILED");
+    return (failures == 0) ? 0 : 1;
+}
+
+// EOF
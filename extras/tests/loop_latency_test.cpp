@@ -0,0 +1,128 @@
+/*!
+ * @file loop_latency_test.cpp
+ *
+ * This is part of SensorWLED library for the Arduino platform.
+ * Source: https://github.com/berrak/SensorWLED
+ *
+ * The MIT license.
+ *
+ * Loop latency of updateAnalogRead() with 64-sample averaging, blocking
+ * and incremental, on the virtual clock of HostPlatform.h. Each
+ * analogRead() takes 'US_CONVERSION_TIME' of the clock, as a real ADC, and
+ * the delays advance the clock. The main loop runs every 'US_LOOP_TIME'.
+ * Checks, for each mode:
+ *
+ *   - the longest call (the loop stall), blocking: the whole window of
+ *     conversions and delays, incremental: at most one conversion,
+ *   - the averaged reading of a constant input, and the readings per
+ *     second.
+ *
+ * Build and run on the host:
+ *   g++ -std=c++17 -O2 -Isrc -I<plog>/include extras/tests/loop_latency_test.cpp \
+ *       src/SensorWLED.cpp src/ConfigStore.cpp src/CalibrationTable.cpp \
+ *       -o loop_latency_test && ./loop_latency_test
+ *
+ * Returns 0 if all checks pass.
+ */
+#include "SensorWLED.h"
+
+#include <cstdio>
+
+#define SAMPLE_COUNT 64         // Samples per reading
+#define US_CONVERSION_TIME 20   // Virtual time of an analogRead()
+#define US_LOOP_TIME 100        // Virtual main loop period
+#define US_RUN_TIME 2000000UL   // Virtual time per mode
+#define ADC_CODE 2000           // Constant input
+
+static int failures = 0;
+
+static void check(bool ok_flag, const char *name, unsigned long detail) {
+    printf("%-44s %s (%lu)\n", name, ok_flag ? "ok" : "FAILED", detail);
+    if (!ok_flag) {
+        failures++;
+    }
+}
+
+/** A conversion takes time, as on a real ADC */
+static uint16_t slowAnalogRead(uint8_t pin, void *context) {
+    (void) pin;
+    (void) context;
+    HostPlatform.advanceTime(US_CONVERSION_TIME);
+    return ADC_CODE;
+}
+
+typedef struct {
+    uint64_t us_max_call_time;      ///< Longest updateAnalogRead() call
+    uint64_t us_total_call_time;    ///< All calls
+    uint32_t call_count;            ///< Calls
+    uint32_t reading_count;         ///< Calls that returned true
+    uint16_t raw_value;             ///< The last averaged code
+} LatencyResultType_t;
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Runs the main loop for 'US_RUN_TIME' in an acquisition mode, and
+         times each updateAnalogRead() call on the virtual clock.
+ */
+//-----------------------------------------------------------------------------
+static LatencyResultType_t runLoop(AcquisitionModeType_e acquisition_mode) {
+
+    HostPlatform.reset();
+    HostPlatform.setAnalogReadProvider(&slowAnalogRead, nullptr);
+
+    DynamicDataType_t Params = {};
+    Params.bits_resolution_adc = bits12;
+    Params.mv_maxvoltage_adc = mv_vcc_3v3;
+    Params.ms_poll_time = 0;
+    Params.ms_hold_time = 250;
+    Params.decay_model = exponential_decay;
+    Params.decay_rate = 0.5;
+    Params.acquisition_mode = acquisition_mode;
+
+    SensorWLED Probe(0, 0.0, 1.0, SAMPLE_COUNT);
+    Probe.begin(Params);
+
+    LatencyResultType_t Result = {};
+    while (HostPlatform.getTime() < US_RUN_TIME) {
+        uint64_t us_start_time = HostPlatform.getTime();
+        Result.reading_count += Probe.updateAnalogRead();
+        uint64_t us_call_time = HostPlatform.getTime() - us_start_time;
+
+        Result.us_total_call_time += us_call_time;
+        Result.call_count++;
+        if (us_call_time > Result.us_max_call_time) {
+            Result.us_max_call_time = us_call_time;
+        }
+        // The rest of the loop, e.g. the LED driver
+        HostPlatform.advanceTime(US_LOOP_TIME);
+    }
+    Result.raw_value = Probe.getRawValue();
+
+    printf("%-12s max call %6lu us, mean call %7.1f us, %6.0f readings/s\n",
+            (acquisition_mode == blocking_average) ? "blocking" : "incremental",
+            (unsigned long) Result.us_max_call_time,
+            (double) Result.us_total_call_time / Result.call_count,
+            Result.reading_count / (US_RUN_TIME / 1e6));
+    return Result;
+}
+
+int main(void) {
+
+    LatencyResultType_t Blocking = runLoop(blocking_average);
+    LatencyResultType_t Incremental = runLoop(incremental_average);
+
+    check(Blocking.us_max_call_time >= SAMPLE_COUNT * (uint64_t) US_CONVERSION_TIME,
+            "blocking, a call reads the whole window", Blocking.us_max_call_time);
+    check(Incremental.us_max_call_time <= US_CONVERSION_TIME,
+            "incremental, a call is one conversion", Incremental.us_max_call_time);
+    check(Blocking.raw_value == ADC_CODE && Incremental.raw_value == ADC_CODE,
+            "both, the averaged code", Incremental.raw_value);
+    check(Blocking.reading_count > 0 && Incremental.reading_count > 0 &&
+            Incremental.reading_count <= Incremental.call_count / SAMPLE_COUNT,
+            "incremental, a reading per full window", Incremental.reading_count);
+
+    printf("%s\n", (failures == 0) ? "PASSED" : "FAILED");
+    return (failures == 0) ? 0 : 1;
+}
+
+// EOF
@@ -0,0 +1,187 @@
+/*!
+ * @file quantile_accuracy_test.cpp
+ *
+ * This is part of SensorWLED library for the Arduino platform.
+ * Source: https://github.com/berrak/SensorWLED
+ *
+ * The MIT license.
+ *
+ * Accuracy of the LogHistogram quantiles against the exact quantiles of
+ * the sorted readings, on synthetic signals of HostSignal.h: a WLED strip
+ * with effects, a steady level with noise, rare spikes (a heavy tail),
+ * and slow ramps. For each signal, a SensorWLED channel polls the signal,
+ * and checks, at the 50th to 99.9th percentile:
+ *
+ *   - getQuantile() (mV), within a bucket width (1/8 of the value, with
+ *     HISTOGRAM_SUB_BITS 3) and one code of the exact quantile,
+ *   - the same for a LogHistogram of 16-bit codes, i.e. with halved
+ *     counts after 65535 codes in a bucket,
+ *   - getQuantile() of a channel fed the signal with processBlock(), i.e.
+ *     counting each reading of a block, not the last one only.
+ *
+ * Build and run on the host:
+ *   g++ -std=c++17 -O2 -DSENSOR_QUANTILES=1 -Isrc -I<plog>/include \
+ *       extras/tests/quantile_accuracy_test.cpp \
+ *       src/SensorWLED.cpp src/ConfigStore.cpp src/CalibrationTable.cpp \
+ *       -o quantile_accuracy_test && ./quantile_accuracy_test
+ *
+ * Returns 0 if all checks pass.
+ */
+#include "SensorWLED.h"
+
+#if !SENSOR_QUANTILES
+    #error "Build with -DSENSOR_QUANTILES=1"
+#endif
+#include "HostSignal.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#define US_POLL_TIME 100        // Virtual time between polls
+#define POLL_COUNT 300000UL     // Polls per signal, 30 s
+#define BLOCK_SIZE 100          // Samples per processBlock(), US_POLL_TIME apart
+
+static int failures = 0;
+
+static const double Quantiles[] = {0.5, 0.9, 0.95, 0.99, 0.999};
+
+typedef struct {
+    const char *name;           ///< Printed signal name
+    SignalDataType_t Signal;    ///< The signal shape
+} QuantileSignalType_t;
+
+static const QuantileSignalType_t Signals[] = {
+    {"strip effects", {150, 2800, 40, 0.6, 3000, 1000, 0.3, 5, 400, 300, 8, 0, 0}},
+    {"steady, noise", {150, 1200, 0, 0, 0, 0, 0, 0, 0, 0, 25, 0, 0}},
+    {"rare spikes", {150, 600, 0, 0, 0, 0, 0, 20, 2000, 500, 4, 0, 0}},
+    {"slow ramps", {100, 3000, 0, 0, 5000, 0, 0, 0, 0, 0, 2, 0, 0}},
+};
+
+/** The largest quantile error (codes), a bucket and one code */
+static double codeBound(double code) {
+
+    uint32_t value = (code < 1) ? 1 : (uint32_t) code;
+    uint8_t msb = 31 - __builtin_clz(value);
+    uint32_t width = (msb <= HISTOGRAM_SUB_BITS) ? 1 : 1U << (msb - HISTOGRAM_SUB_BITS);
+    return width + 1;
+}
+
+/** Exact quantile of sorted values, the nearest rank */
+template <typename T>
+static double exactQuantile(std::vector<T> const &rSorted, double q) {
+
+    size_t rank = (size_t) ceil(q * rSorted.size());
+    return rSorted[(rank > 0) ? rank - 1 : 0];
+}
+
+/** Exact quantile of sorted codes, in mV, and counts a miss of getQuantile() */
+static double checkQuantile(SensorWLED &rProbe, std::vector<uint16_t> const &rSorted,
+                                                    double q, uint32_t &rMisses) {
+
+    double exact_code = exactQuantile(rSorted, q);
+    double mv_exact = (exact_code * mv_vcc_3v3) / bits12;
+    double mv_error = fabs(rProbe.getQuantile(q) - mv_exact);
+    rMisses += mv_error > codeBound(exact_code) * mv_vcc_3v3 / bits12;
+    return (mv_exact > 0) ? 100 * mv_error / mv_exact : 0;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Polls a signal, and compares the quantiles with the exact ones.
+ */
+//-----------------------------------------------------------------------------
+static void runSignal(QuantileSignalType_t const &rSignal) {
+
+    HostPlatform.reset();
+    SignalGenerator Signal;
+    Signal.begin(rSignal.Signal, bits12, mv_vcc_3v3, 7);
+    Signal.install();
+
+    DynamicDataType_t Params = {};
+    Params.bits_resolution_adc = bits12;
+    Params.mv_maxvoltage_adc = mv_vcc_3v3;
+    Params.ms_poll_time = 0;
+    Params.ms_hold_time = 250;
+    Params.decay_model = exponential_decay;
+    Params.decay_rate = 0.5;
+
+    SensorWLED Probe(0);
+    Probe.begin(Params);
+    SensorWLED BlockProbe(1);
+    BlockProbe.begin(Params);
+
+    LogHistogram<HISTOGRAM_SUB_BITS> Histogram;
+    std::vector<uint16_t> codes;
+    for (uint32_t poll = 0; poll < POLL_COUNT; poll++) {
+        HostPlatform.advanceTime(US_POLL_TIME);
+        if (Probe.updateAnalogRead()) {
+            codes.push_back(Probe.getRawValue());
+        }
+        // Codes scaled to 16 bits, to fill the buckets and halve them
+        for (uint8_t cnt = 0; cnt < 4; cnt++) {
+            Histogram.add(Signal.getCode(HostPlatform.getTime() + cnt * 25) << 4);
+        }
+    }
+    std::sort(codes.begin(), codes.end());
+
+    // The 16-bit codes of the histogram, in the same order
+    std::vector<uint32_t> wide_codes;
+    for (uint32_t poll = 1; poll <= POLL_COUNT; poll++) {
+        for (uint8_t cnt = 0; cnt < 4; cnt++) {
+            wide_codes.push_back(Signal.getCode(poll * US_POLL_TIME + cnt * 25) << 4);
+        }
+    }
+    std::sort(wide_codes.begin(), wide_codes.end());
+
+    // The same signal, in blocks of converted samples
+    std::vector<uint16_t> block_codes;
+    std::vector<uint16_t> block(BLOCK_SIZE);
+    for (uint32_t poll = 0; poll < POLL_COUNT; poll += BLOCK_SIZE) {
+        uint32_t t0_us = poll * US_POLL_TIME;
+        for (uint16_t cnt = 0; cnt < BLOCK_SIZE; cnt++) {
+            block[cnt] = Signal.getCode(t0_us + cnt * US_POLL_TIME);
+        }
+        BlockProbe.processBlock(block.data(), block.size(), t0_us, US_POLL_TIME);
+        block_codes.insert(block_codes.end(), block.begin(), block.end());
+    }
+    std::sort(block_codes.begin(), block_codes.end());
+
+    uint32_t misses = 0;
+    uint32_t block_misses = 0;
+    printf("%-16s", rSignal.name);
+    for (double q : Quantiles) {
+        double mv_exact = (exactQuantile(codes, q) * mv_vcc_3v3) / bits12;
+        double error_percent = checkQuantile(Probe, codes, q, misses);
+        checkQuantile(BlockProbe, block_codes, q, block_misses);
+
+        double exact_wide = exactQuantile(wide_codes, q);
+        double wide_error = fabs(Histogram.quantile(q) - exact_wide);
+        misses += wide_error > codeBound(exact_wide);
+
+        printf(" p%-5g %7.1f mV %5.2f%% |", q * 100, mv_exact, error_percent);
+    }
+    printf("\n");
+
+    char name[64];
+    snprintf(name, sizeof(name), "%s, quantiles within a bucket", rSignal.name);
+    printf("%-44s %s (%lu)\n", name, (misses == 0) ? "ok" : "FAILED", (unsigned long) misses);
+    failures += (misses != 0);
+    snprintf(name, sizeof(name), "%s, processBlock() quantiles", rSignal.name);
+    printf("%-44s %s (%lu)\n", name, (block_misses == 0) ? "ok" : "FAILED",
+                                                    (unsigned long) block_misses);
+    failures += (block_misses != 0);
+}
+
+int main(void) {
+
+    for (QuantileSignalType_t const &rSignal : Signals) {
+        runSignal(rSignal);
+    }
+
+    printf("%s\n", (failures == 0) ? "PASSED" : "FAILED");
+    return (failures == 0) ? 0 : 1;
+}
+
+// EOF
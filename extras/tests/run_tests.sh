@@ -0,0 +1,38 @@
+#!/bin/sh
+#
+# This is part of SensorWLED library for the Arduino platform.
+# Source: https://github.com/berrak/SensorWLED
+#
+# The MIT license.
+#
+# Builds and runs the host checks in extras/tests, from the library root:
+#   PLOG_INCLUDE=<plog>/include extras/tests/run_tests.sh
+#
+# The checks are built with all optional features (FEATURES) compiled in.
+#
+# Returns 0 if all checks pass.
+
+CXX=${CXX:-g++}
+CXXFLAGS=${CXXFLAGS:-"-std=c++17 -O2 -Wall -Wextra -pthread"}
+BUILD_DIR=${BUILD_DIR:-/tmp/sensorwled_tests}
+PLOG_INCLUDE=${PLOG_INCLUDE:-/usr/include}
+FEATURES=${FEATURES:-"-DSENSOR_MOVING_WINDOW=1 -DSENSOR_TRIGGERS=1 -DSENSOR_CAPTURE=1 -DSENSOR_QUANTILES=1 -DSENSOR_SAMPLE_QUEUE=1"}
+
+mkdir -p "$BUILD_DIR" || exit 1
+
+failed=0
+for test in extras/tests/*.cpp; do
+    name=$(basename "$test" .cpp)
+    echo "== $name"
+    if ! $CXX $CXXFLAGS $FEATURES -Isrc -I"$PLOG_INCLUDE" "$test" src/*.cpp -o "$BUILD_DIR/$name"; then
+        echo "$name: build FAILED"
+        failed=1
+        continue
+    fi
+    if ! "$BUILD_DIR/$name"; then
+        failed=1
+    fi
+done
+
+[ $failed -eq 0 ] && echo "ALL PASSED" || echo "SOME FAILED"
+exit $failed
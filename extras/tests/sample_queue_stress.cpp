@@ -0,0 +1,179 @@
+/*!
+ * @file sample_queue_stress.cpp
+ *
+ * This is part of SensorWLED library for the Arduino platform.
+ * Source: https://github.com/berrak/SensorWLED
+ *
+ * The MIT license.
+ *
+ * Producer/consumer stress test of the lock-free SampleQueue, with a
+ * producer thread in place of the timer ISR, and the main thread as the
+ * loop(). Checks, for each queue size:
+ *
+ *   - lossless: the producer retries a full queue, and every sample is
+ *     received once, in order,
+ *   - overflow: the producer drops on a full queue, the received samples
+ *     are in order, and received + dropped = pushed,
+ *   - copy: a copied queue holds the same samples.
+ *
+ * Build and run on the host (also with -fsanitize=thread):
+ *   g++ -std=c++17 -O2 -pthread -Isrc extras/tests/sample_queue_stress.cpp \
+ *       -o sample_queue_stress && ./sample_queue_stress
+ *
+ * Returns 0 if all checks pass.
+ */
+#include "SampleQueue.h"
+
+#include <cstdio>
+#include <atomic>
+#include <cstdlib>
+#include <thread>
+
+#define SAMPLE_COUNT 2000000UL      // Samples per run
+
+static int failures = 0;
+
+static void check(bool ok_flag, const char *name, unsigned long detail) {
+    printf("%-40s %s (%lu)\n", name, ok_flag ? "ok" : "FAILED", detail);
+    if (!ok_flag) {
+        failures++;
+    }
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Every sample is received once and in order, the producer spins
+         on a full queue.
+ */
+//-----------------------------------------------------------------------------
+template <uint16_t SIZE>
+static void runLossless(unsigned long count) {
+
+    static SampleQueue<SIZE> Queue;
+    std::thread Producer([count]() {
+        for (unsigned long cnt = 0; cnt < count; cnt++) {
+            while (!Queue.push((uint16_t) cnt)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    unsigned long received = 0;
+    unsigned long out_of_order = 0;
+    uint16_t code;
+    while (received < count) {
+        if (Queue.pop(code)) {
+            out_of_order += (code != (uint16_t) received);
+            received++;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    Producer.join();
+
+    char name[64];
+    snprintf(name, sizeof(name), "lossless, size %u, out of order", SIZE);
+    check(out_of_order == 0 && !Queue.pop(code), name, out_of_order);
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  A producer that never waits, as an ISR. The received samples
+         increase, and none are lost without being counted.
+ */
+//-----------------------------------------------------------------------------
+template <uint16_t SIZE>
+static void runOverflow(unsigned long count) {
+
+    static SampleQueue<SIZE> Queue;
+    static std::atomic<bool> done_flag;
+    done_flag = false;
+
+    // The drops in a row are limited, so the 16-bit codes can be unwrapped
+    std::thread Producer([count]() {
+        unsigned long dropped_in_row = 0;
+        for (unsigned long cnt = 0; cnt < count; cnt++) {
+            if (Queue.push((uint16_t) cnt)) {
+                dropped_in_row = 0;
+            } else if (++dropped_in_row >= 0x8000) {
+                while (Queue.available() == SIZE) {
+                    std::this_thread::yield();
+                }
+                dropped_in_row = 0;
+            }
+        }
+        done_flag = true;
+    });
+
+    unsigned long received = 0;
+    unsigned long not_increasing = 0;
+    unsigned long previous = 0;
+    uint16_t code;
+    bool first_flag = true;
+
+    // The consumer gives up the CPU often, to overflow the queue
+    while (!done_flag || Queue.available() > 0) {
+        if (Queue.pop(code)) {
+            // Unwraps the 16-bit codes
+            unsigned long value = (previous & ~0xFFFFUL) | code;
+            if (!first_flag && value <= previous) {
+                value += 0x10000UL;
+            }
+            not_increasing += (!first_flag && value <= previous);
+            previous = value;
+            first_flag = false;
+            received++;
+        }
+        if ((received & 0xFF) == 0 || Queue.available() == 0) {
+            std::this_thread::yield();
+        }
+    }
+    Producer.join();
+
+    char name[64];
+    snprintf(name, sizeof(name), "overflow, size %u, not increasing", SIZE);
+    check(not_increasing == 0, name, not_increasing);
+    snprintf(name, sizeof(name), "overflow, size %u, received + dropped", SIZE);
+    check(received + Queue.getOverflowCount() == count && Queue.getOverflowCount() > 0,
+                                                name, received + Queue.getOverflowCount());
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  A copy holds the queued samples and the overflow count.
+ */
+//-----------------------------------------------------------------------------
+static void runCopy(void) {
+
+    SampleQueue<8> Queue;
+    for (uint16_t cnt = 0; cnt < 10; cnt++) {
+        Queue.push(cnt);
+    }
+    SampleQueue<8> Copy(Queue);
+
+    unsigned long mismatch = 0;
+    uint16_t code;
+    for (uint16_t cnt = 0; cnt < 8; cnt++) {
+        mismatch += !(Copy.pop(code) && code == cnt);
+    }
+    mismatch += Copy.pop(code);
+    check(mismatch == 0 && Copy.getOverflowCount() == 2 && Queue.available() == 8,
+                                                        "copy, mismatched samples", mismatch);
+}
+
+int main(int argc, char *argv[]) {
+
+    unsigned long count = (argc > 1) ? strtoul(argv[1], nullptr, 10) : SAMPLE_COUNT;
+
+    runLossless<2>(count / 10);
+    runLossless<64>(count);
+    runLossless<1024>(count);
+    runOverflow<4>(count);
+    runOverflow<64>(count);
+    runCopy();
+
+    printf("%s\n", (failures == 0) ? "PASSED" : "FAILED");
+    return (failures == 0) ? 0 : 1;
+}
+
+// EOF
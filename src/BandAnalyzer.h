@@ -0,0 +1,325 @@
+/*!
+ * @file BandAnalyzer.h
+ *
+ * This is part of SensorWLED library for the Arduino platform.
+ * Source: https://github.com/berrak/SensorWLED
+ *
+ * The MIT license.
+ *
+ */
+#ifndef BANDANALYZER_H_
+#define BANDANALYZER_H_
+
+#include "SensorWLED.h"
+
+#include <cmath>
+#include <type_traits>
+
+/** Time constant of the DC (bias) removal, 2^DC_REMOVAL_SHIFT samples */
+#if !defined(DC_REMOVAL_SHIFT)
+    #define DC_REMOVAL_SHIFT 8
+#endif
+
+#define Q14_SHIFT 14    ///< Fractional bits of the coefficients and the window
+
+//-----------------------------------------------------------------------------
+/*!
+    @brief  Band levels of the sample stream of a SensorWLED instance, e.g.
+            for a microphone spectrum VU meter.
+
+            The DC bias is removed with a single-pole high-pass, i.e. no
+            hand-tuned bias constant. Each block of BLOCK_SIZE samples is
+            Hann windowed, and a fixed-point Goertzel filter per band
+            gives the band amplitude (mV), at the end of the block. Each
+            band has a peak value, with the same hold time and decay
+            model as SensorWLED (the precomputed decay table).
+
+            Per sample, the work is one multiplication for the window and
+            one per band. The square roots are per block and band.
+
+            A band near 0 Hz (coefficient 2.0) sums up to BLOCK_SIZE^2 / 2
+            windowed samples of up to 16 bits, so the Goertzel states are
+            32 bits up to 255 samples per block, and 64 bits above.
+*/
+//-----------------------------------------------------------------------------
+template <uint8_t BANDS, uint16_t BLOCK_SIZE = 128>
+class BandAnalyzer {
+
+    static_assert(BANDS > 0 && BANDS <= 16, "Use 1 to 16 bands");
+    static_assert(BLOCK_SIZE >= 16 && BLOCK_SIZE <= 1024, "Use 16 to 1024 samples per block");
+
+    /** Largest Goertzel state, 16-bit samples and a 0 Hz band */
+    static constexpr uint64_t max_state = 65536ULL * BLOCK_SIZE * (BLOCK_SIZE + 1) / 2;
+
+    /** Goertzel state type, 32 bits if the largest state fits */
+    typedef typename std::conditional<(max_state <= INT32_MAX),
+                                            int32_t, int64_t>::type StateType_t;
+
+    /** Type of the block power, 64-bit states need the double mantissa */
+    typedef typename std::conditional<(max_state <= INT32_MAX),
+                                            float, double>::type PowerType_t;
+
+    static_assert((max_state << (Q14_SHIFT + 2)) <= INT64_MAX,
+                    "The coefficient times the state must fit 64 bits");
+
+public:
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Creates an analyzer without bands.
+     */
+    //-------------------------------------------------------------------------
+    BandAnalyzer(void) {
+        band_count = 0;
+        hz_sample_rate = 0;
+        mv_per_code = 0;
+        reset();
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Attaches to the readings of a sensor, which must run without
+             averaging, at a steady rate (e.g. interrupt-driven, or with
+             processBlock()). Call after the sensor begin().
+
+     @param  rSensor
+             The sensor, its calibration maps the levels to mV.
+     @param  sample_rate
+             Readings per second (Hz).
+     @param  rDynamicParams
+             The hold time and decay model of the band peak values.
+     */
+    //-------------------------------------------------------------------------
+    void begin(SensorWLED &rSensor, float sample_rate,
+                                    DynamicDataType_t const &rDynamicParams) {
+
+        hz_sample_rate = sample_rate;
+        mv_per_code = (float) rSensor.DynamicParams.mv_maxvoltage_adc /
+                        rSensor.getCodeMax() * rSensor.CalibrationData.cal_slope;
+
+        ms_hold_time = rDynamicParams.ms_hold_time;
+        float decay_rate = SensorWLED::validateDecayRate(rDynamicParams.decay_model,
+                                                        rDynamicParams.decay_rate);
+        SensorWLED::generateDecayTable(q16_decay_table, rDynamicParams.decay_model,
+                                                                        decay_rate);
+
+        // Hann window, the coherent gain 0.5 is compensated in the levels
+        for (uint16_t cnt = 0; cnt < BLOCK_SIZE; cnt++) {
+            double w = 0.5 - 0.5 * cos(2 * M_PI * cnt / BLOCK_SIZE);
+            q14_window[cnt] = lround(w * (1L << Q14_SHIFT));
+        }
+        for (uint8_t band = 0; band < band_count; band++) {
+            setCoefficient(band);
+        }
+        reset();
+
+        rSensor.setReadingTap(&BandAnalyzer::readingTap, this);
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Adds a band, around a center frequency.
+     @param  hz_center
+             Center frequency (Hz), below half the sample rate.
+     @return The band index, or -1 if all bands are used.
+     */
+    //-------------------------------------------------------------------------
+    int16_t addBand(float hz_center) {
+
+        if (band_count >= BANDS) {
+            return -1;
+        }
+        uint8_t band = band_count++;
+        hz_band[band] = hz_center;
+        setCoefficient(band);
+        mapped_band_value[band] = 0;
+        pk_mapped_band_value[band] = 0;
+        return band;
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Adds a sample, e.g. without an attached sensor.
+     @param  code
+             Raw ADC value.
+     @param  sample_millis
+             The time of the sample, for the peak hold time.
+     @return true when the block is complete, i.e. new band values.
+     */
+    //-------------------------------------------------------------------------
+    bool addSample(uint16_t code, uint32_t sample_millis) {
+
+        // Remove the DC bias, starting at the first sample
+        int32_t q8_code = (int32_t) code << 8;
+        if (dc_started_flag == false) {
+            q8_dc_value = q8_code;
+            dc_started_flag = true;
+        }
+        q8_dc_value += (q8_code - q8_dc_value) >> DC_REMOVAL_SHIFT;
+        int32_t ac_value = (q8_code - q8_dc_value) >> 8;
+
+        int32_t x = (ac_value * q14_window[sample_count]) >> Q14_SHIFT;
+        for (uint8_t band = 0; band < band_count; band++) {
+            int64_t s0 = x + (((int64_t) q14_coefficient[band] * s1[band]) >> Q14_SHIFT)
+                                                                            - s2[band];
+            s2[band] = s1[band];
+            s1[band] = (StateType_t) s0;
+        }
+
+        if (++sample_count < BLOCK_SIZE) {
+            return false;
+        }
+        sample_count = 0;
+        updateBands(sample_millis);
+        return true;
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  The level of a band, of the last block.
+     @param  band
+             Band index.
+     @return Amplitude (mV).
+     */
+    //-------------------------------------------------------------------------
+    double getBandValue(uint8_t band) {
+        return (double) mapped_band_value[band] / Q16_ONE;
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  The peak level of a band, decaying with the hold time.
+     @param  band
+             Band index.
+     @return Peak amplitude (mV).
+     */
+    //-------------------------------------------------------------------------
+    double getBandPeakValue(uint8_t band) {
+        return (double) pk_mapped_band_value[band] / Q16_ONE;
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Gets the number of added bands.
+     @return Bands added.
+     */
+    //-------------------------------------------------------------------------
+    uint8_t getBandCount(void) {
+        return band_count;
+    }
+
+private:
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Called by the sensor with each reading.
+     */
+    //-------------------------------------------------------------------------
+    static void readingTap(uint16_t raw_value, uint32_t reading_millis, void *context) {
+        static_cast<BandAnalyzer *>(context)->addSample(raw_value, reading_millis);
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Sets the Goertzel coefficient 2 cos(w) of a band.
+     @param  band
+             Band index.
+     */
+    //-------------------------------------------------------------------------
+    void setCoefficient(uint8_t band) {
+
+        double omega = 0;
+        if (hz_sample_rate > 0) {
+            omega = 2 * M_PI * hz_band[band] / hz_sample_rate;
+        }
+        q14_coefficient[band] = lround(2 * cos(omega) * (1L << Q14_SHIFT));
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Converts the Goertzel states to band levels at the end of a
+             block, and updates the peak values.
+     @param  current_millis
+             The time of the last sample.
+     */
+    //-------------------------------------------------------------------------
+    void updateBands(uint32_t current_millis) {
+
+        // Decay the peak values, depending on the hold time
+        uint32_t hold_periods = 0;
+        uint32_t elapsed_millis = current_millis - previous_hold_millis_tm;
+        if (elapsed_millis >= ms_hold_time) {
+            hold_periods = 1;
+            if (ms_hold_time > 0) {
+                hold_periods = elapsed_millis / ms_hold_time;
+            }
+            previous_hold_millis_tm += hold_periods * ms_hold_time;
+        }
+
+        // Amplitude 2 |X| / N, and 2 for the Hann window gain
+        float scale = 4.0f / BLOCK_SIZE * mv_per_code * Q16_ONE;
+
+        for (uint8_t band = 0; band < band_count; band++) {
+            PowerType_t f1 = s1[band];
+            PowerType_t f2 = s2[band];
+            PowerType_t power = f1 * f1 + f2 * f2 -
+                    f1 * f2 * q14_coefficient[band] / (1L << Q14_SHIFT);
+            s1[band] = 0;
+            s2[band] = 0;
+
+            uint32_t q16_value = std::lround(std::sqrt((power > 0) ? power : 0) * scale);
+            mapped_band_value[band] = q16_value;
+
+            if (hold_periods > 0) {
+                pk_mapped_band_value[band] = SensorWLED::applyDecayTable(q16_decay_table,
+                                            pk_mapped_band_value[band], hold_periods);
+            }
+            if (q16_value >= pk_mapped_band_value[band]) {
+                pk_mapped_band_value[band] = q16_value;
+            }
+        }
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Clears the filter states.
+     */
+    //-------------------------------------------------------------------------
+    void reset(void) {
+
+        for (uint8_t band = 0; band < BANDS; band++) {
+            s1[band] = 0;
+            s2[band] = 0;
+        }
+        q8_dc_value = 0;
+        dc_started_flag = false;
+        sample_count = 0;
+        previous_hold_millis_tm = 0;
+    }
+
+    uint8_t band_count;                     ///< Number of added bands
+    uint16_t sample_count;                  ///< Samples in the current block
+    float hz_sample_rate;                   ///< Readings per second
+    float mv_per_code;                      ///< Sensor scale and slope
+
+    int32_t q8_dc_value;                    ///< DC bias estimate (Q24.8 code)
+    bool dc_started_flag;                   ///< There is a DC estimate
+
+    uint16_t ms_hold_time;                  ///< Peak hold time (milliseconds)
+    uint32_t previous_hold_millis_tm;       ///< Holds previous hold time
+    uint32_t q16_decay_table[DECAY_TABLE_SIZE]; ///< Decay factor^n (Q16.16)
+
+    uint16_t q14_window[BLOCK_SIZE];        ///< Hann window (Q2.14)
+
+    // Band state, structure-of-arrays
+    float hz_band[BANDS];                   ///< Band center frequency
+    int32_t q14_coefficient[BANDS];         ///< Goertzel 2 cos(w) (Q2.14)
+    StateType_t s1[BANDS];                  ///< Goertzel state, previous
+    StateType_t s2[BANDS];                  ///< Goertzel state, before previous
+    uint32_t mapped_band_value[BANDS];      ///< Band amplitude (Q16.16 mV)
+    uint32_t pk_mapped_band_value[BANDS];   ///< Band peak amplitude (Q16.16 mV)
+
+};
+/* class BandAnalyzer */
+
+#endif /* BANDANALYZER_H_ */
@@ -0,0 +1,212 @@
+/*!
+ * @file CalibrationTable.cpp
+ *
+ * This is part of SensorWLED library for the Arduino platform.
+ * Source: https://github.com/berrak/SensorWLED
+ *
+ * The MIT license.
+ *
+ */
+#ifdef ARDUINO
+// Required includes for Arduino libraries always go first.
+#include <Arduino.h>
+#endif
+
+// Q16.16 constants
+#include "SensorWLED.h"
+#include "CalibrationTable.h"
+
+#include <new>      // std::nothrow, a table may not fit
+#include <string.h>
+
+static_assert(MAX_CAL_TABLE_BITS <= 16, "The native codes are 16 bits");
+
+CalibrationTable::SharedTableType_t *CalibrationTable::pFirstTable = nullptr;
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Constructor, no table.
+ */
+//-----------------------------------------------------------------------------
+CalibrationTable::CalibrationTable(void) {
+    pTable = nullptr;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Copy, shares the table of 'rOther'.
+ */
+//-----------------------------------------------------------------------------
+CalibrationTable::CalibrationTable(CalibrationTable const &rOther) {
+
+    pTable = rOther.pTable;
+    if (pTable != nullptr) {
+        pTable->ref_count++;
+    }
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Assignment, releases this table and shares the table of 'rOther'.
+ */
+//-----------------------------------------------------------------------------
+CalibrationTable &CalibrationTable::operator=(CalibrationTable const &rOther) {
+
+    if (pTable != rOther.pTable) {
+        release();
+        pTable = rOther.pTable;
+        if (pTable != nullptr) {
+            pTable->ref_count++;
+        }
+    }
+    return *this;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Destructor, the last handle frees the table.
+ */
+//-----------------------------------------------------------------------------
+CalibrationTable::~CalibrationTable(void) {
+    release();
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Uses the table of the points and resolution, i.e. shares an
+         existing table, or builds a new one.
+
+ @param  rPoints
+         The sorted calibration points, at least two.
+ @param  code_max
+         Largest native ADC code (the resolution, without decimation).
+ @return true if there is a table, false if it did not fit in memory.
+ */
+//-----------------------------------------------------------------------------
+bool CalibrationTable::build(CalibrationPointsType_t const &rPoints, uint16_t code_max) {
+
+    release();
+
+    for (SharedTableType_t *pShared = pFirstTable; pShared != nullptr; pShared = pShared->pNext) {
+        if (pShared->code_max == code_max &&
+                memcmp(&pShared->Points, &rPoints, sizeof(rPoints)) == 0) {
+            pShared->ref_count++;
+            pTable = pShared;
+            return true;
+        }
+    }
+
+    SharedTableType_t *pNew = new (std::nothrow) SharedTableType_t;
+    if (pNew == nullptr) {
+        return false;
+    }
+    pNew->values = new (std::nothrow) int32_t[code_max + 1UL];
+    if (pNew->values == nullptr) {
+        delete pNew;
+        return false;
+    }
+
+    for (uint32_t code = 0; code <= code_max; code++) {
+        pNew->values[code] = lround(interpolate(rPoints, code) * Q16_ONE);
+    }
+    pNew->Points = rPoints;
+    pNew->code_max = code_max;
+    pNew->ref_count = 1;
+    pNew->pNext = pFirstTable;
+    pFirstTable = pNew;
+
+    pTable = pNew;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Stops using the table, and frees it if no other handle uses it.
+ */
+//-----------------------------------------------------------------------------
+void CalibrationTable::release(void) {
+
+    if (pTable == nullptr) {
+        return;
+    }
+    if (--pTable->ref_count == 0) {
+        SharedTableType_t **ppLink = &pFirstTable;
+        while (*ppLink != pTable) {
+            ppLink = &(*ppLink)->pNext;
+        }
+        *ppLink = pTable->pNext;
+        delete[] pTable->values;
+        delete pTable;
+    }
+    pTable = nullptr;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Checks if other handles (channels) use the same table.
+
+ @return true if shared.
+ */
+//-----------------------------------------------------------------------------
+bool CalibrationTable::isShared(void) const {
+    return pTable != nullptr && pTable->ref_count > 1;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Gets the memory of the table, also if shared.
+
+ @return Table size (bytes), 0 without a table.
+ */
+//-----------------------------------------------------------------------------
+size_t CalibrationTable::getSize(void) const {
+    return (pTable != nullptr) ? (pTable->code_max + 1UL) * sizeof(int32_t) : 0;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Gets the memory of all tables, i.e. of all channels.
+
+ @return Size (bytes).
+ */
+//-----------------------------------------------------------------------------
+size_t CalibrationTable::getTotalSize(void) {
+
+    size_t size = 0;
+    for (SharedTableType_t *pShared = pFirstTable; pShared != nullptr; pShared = pShared->pNext) {
+        size += (pShared->code_max + 1UL) * sizeof(int32_t) + sizeof(SharedTableType_t);
+    }
+    return size;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Interpolates the calibration points. Outside the points, the
+         first or last segment is extended.
+
+ @param  rPoints
+         The sorted calibration points, at least two.
+ @param  raw_value
+         Native ADC code, with any fraction of the decimation.
+ @return The calibrated value (mV), not below zero.
+ */
+//-----------------------------------------------------------------------------
+double CalibrationTable::interpolate(CalibrationPointsType_t const &rPoints, double raw_value) {
+
+    const CalibrationPointType_t *pPoints = rPoints.Points;
+
+    // The segment of the code, or the first or last one
+    uint8_t segment = 0;
+    while (segment + 2 < rPoints.point_count && raw_value > pPoints[segment + 1].raw_value) {
+        segment++;
+    }
+
+    const CalibrationPointType_t &rLow = pPoints[segment];
+    const CalibrationPointType_t &rHigh = pPoints[segment + 1];
+    double mv_value = rLow.mv_value + (raw_value - rLow.raw_value) *
+                (rHigh.mv_value - rLow.mv_value) / (rHigh.raw_value - rLow.raw_value);
+
+    return (mv_value > 0) ? mv_value : 0;
+}
+
+// EOF
@@ -0,0 +1,133 @@
+/*!
+ * @file CalibrationTable.h
+ *
+ * This is part of SensorWLED library for the Arduino platform.
+ * Source: https://github.com/berrak/SensorWLED
+ *
+ * The MIT license.
+ *
+ */
+#ifndef CALIBRATIONTABLE_H_
+#define CALIBRATIONTABLE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/** Max reference points of the multi-point calibration */
+#if !defined(MAX_CAL_POINTS)
+    #define MAX_CAL_POINTS 16
+#endif
+
+/** Largest ADC resolution (bits) with a calibration table, above it each
+    mapping interpolates the points */
+#if !defined(MAX_CAL_TABLE_BITS)
+    #define MAX_CAL_TABLE_BITS 12
+#endif
+
+//-----------------------------------------------------------------------------
+/*!
+    @brief  A reference point of the multi-point calibration.
+*/
+//-----------------------------------------------------------------------------
+typedef struct {
+    float mv_value;             ///< True input voltage at the point (mV)
+    uint16_t raw_value;         ///< ADC reading at the point, at bits capability
+    uint16_t reserved;          ///< Always zero
+} CalibrationPointType_t;
+
+//-----------------------------------------------------------------------------
+/*!
+    @brief  Piecewise-linear (multi-point) calibration, also the EEPROM record.
+*/
+//-----------------------------------------------------------------------------
+typedef struct {
+    uint16_t point_count;       ///< Used points, 0: slope and offset calibration
+    uint16_t reserved;          ///< Always zero
+    CalibrationPointType_t Points[MAX_CAL_POINTS]; ///< In increasing 'raw_value' order
+} CalibrationPointsType_t;
+
+/** How the multi-point calibration is mapped, after begin() */
+typedef enum : uint8_t {
+    cal_table_none = 0,         ///< No calibration points
+    cal_table_built,            ///< A new table was built
+    cal_table_shared,           ///< The table of another channel is used
+    cal_table_interpolated,     ///< ADC above MAX_CAL_TABLE_BITS, no table
+    cal_table_no_memory,        ///< The table did not fit, no table
+} CalibrationTableStatusType_e;
+
+//-----------------------------------------------------------------------------
+/*!
+    @brief  Shared table of the calibrated value (Q16.16 mV) of each native
+            ADC code, i.e. a mapping is one indexed load.
+
+            Channels with the same points and ADC resolution use the same
+            table, i.e. one table of 4 bytes per code (16 kB for 12 bits).
+            The handle counts the references, and the last one frees the
+            table, so copies of a channel share it safely. Decimated codes
+            with extra bits interpolate between two entries, which is exact,
+            as the points are at native codes.
+*/
+//-----------------------------------------------------------------------------
+class CalibrationTable {
+
+public:
+
+    CalibrationTable(void);
+    CalibrationTable(CalibrationTable const &rOther);
+    CalibrationTable &operator=(CalibrationTable const &rOther);
+    ~CalibrationTable(void);
+
+    bool build(CalibrationPointsType_t const &rPoints, uint16_t code_max);
+    void release(void);
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  The calibrated value of a code, from the table. Codes above the
+             table use the last entry.
+     @param  code
+             Raw code, with 'extra_bits' more than the native ADC codes.
+     @param  extra_bits
+             Extra (decimation) bits of the code.
+     @return The calibrated value (mV) in Q16.16.
+     */
+    //-------------------------------------------------------------------------
+    inline int32_t map(uint32_t code, uint8_t extra_bits) const {
+
+        const int32_t *values = pTable->values;
+        uint32_t index = code >> extra_bits;
+        if (index >= pTable->code_max) {
+            return values[pTable->code_max];
+        }
+        if (extra_bits == 0) {
+            return values[index];
+        }
+        int32_t fraction = code & ((1UL << extra_bits) - 1);
+        return values[index] + (int32_t) (((int64_t) (values[index + 1] - values[index])
+                                                            * fraction) >> extra_bits);
+    }
+
+    bool isValid(void) const { return pTable != nullptr; }  ///< Has a table
+    bool isShared(void) const;
+    size_t getSize(void) const;
+
+    static size_t getTotalSize(void);
+    static double interpolate(CalibrationPointsType_t const &rPoints, double raw_value);
+
+private:
+
+    /** A table, and the points and resolution it was built for */
+    typedef struct SharedTableType_t {
+        SharedTableType_t *pNext;           ///< Next table in the list
+        CalibrationPointsType_t Points;     ///< The points of the table
+        uint16_t code_max;                  ///< Largest native code
+        uint16_t ref_count;                 ///< Handles using the table
+        int32_t *values;                    ///< Value per code 0..code_max (Q16.16)
+    } SharedTableType_t;
+
+    SharedTableType_t *pTable;              ///< The used table, or nullptr
+
+    static SharedTableType_t *pFirstTable;  ///< All tables in use
+};
+/* class CalibrationTable */
+
+#endif /* CALIBRATIONTABLE_H_ */
@@ -0,0 +1,508 @@
+/*!
+ * @file ConfigStore.cpp
+ *
+ * This is part of SensorWLED library for the Arduino platform.
+ * Source: https://github.com/berrak/SensorWLED
+ *
+ * The MIT license.
+ *
+ */
+#ifdef ARDUINO
+// Required includes for Arduino libraries always go first.
+#include <Arduino.h>
+#endif
+
+// EEPROM, the CRC32 routine, and the used EEPROM size
+#include "SensorWLED.h"
+#include "ConfigStore.h"
+
+#include <string.h>
+
+static_assert(CONFIG_BANK_SIZE % CONFIG_RECORD_ALIGN == 0, "Bank size must be aligned");
+static_assert(sizeof(ConfigRecordHeaderType_t) == 16, "Unexpected record header size");
+static_assert(CONFIG_STORE_START > 0, "Address 0 marks an unused index entry");
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Record size, i.e. header and payload, rounded up to the alignment.
+ @param  len
+         Payload size.
+ @return Log space used by the record (bytes).
+ */
+//-----------------------------------------------------------------------------
+uint16_t ConfigStore::getRecordSize(uint16_t len) {
+    uint16_t size = sizeof(ConfigRecordHeaderType_t) + len;
+    return (size + CONFIG_RECORD_ALIGN - 1) & ~(CONFIG_RECORD_ALIGN - 1);
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Constructor, the EEPROM is not touched until begin().
+ */
+//-----------------------------------------------------------------------------
+ConfigStore::ConfigStore(void) {
+
+    memset(index_address, 0, sizeof(index_address));
+    index_count = 0;
+    active_bank = 0;
+    write_address = CONFIG_STORE_START;
+    next_sequence = 1;
+    compaction_count = 0;
+    open_flag = false;
+    dirty_flag = false;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Loads the emulated EEPROM into RAM, scans both banks, and builds
+         the index of the newest valid records. Only the first call (for
+         all instances) does any work.
+ */
+//-----------------------------------------------------------------------------
+void ConfigStore::begin(void) {
+
+    if (open_flag) {
+        return;
+    }
+    open_flag = true;
+
+    EEPROM.begin(EEPROM_AREA_SIZE);
+
+    memset(index_address, 0, sizeof(index_address));
+    index_count = 0;
+    next_sequence = 1;
+    active_bank = 0;
+
+    // The bank with the newest record is the active one
+    uint16_t end_address[2];
+    for (uint8_t bank = 0; bank < 2; bank++) {
+        uint32_t sequence = next_sequence;
+        end_address[bank] = bankStart(bank);
+        scanBank(bank, end_address[bank]);
+        if (next_sequence != sequence) {
+            active_bank = bank;
+        }
+    }
+    write_address = end_address[active_bank];
+
+#ifndef ARDUINO
+    PLOG_INFO << "EEPROM log: bank " << (int) active_bank << ", records " << index_count
+                                    << ", used " << getUsedBytes();
+#endif
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Adds the valid records of one bank to the index.
+
+ @param  bank
+         Bank number (0 or 1).
+ @param  rEndAddress
+         Returns the address after the last valid record.
+ */
+//-----------------------------------------------------------------------------
+void ConfigStore::scanBank(uint8_t bank, uint16_t &rEndAddress) {
+
+    uint16_t address = bankStart(bank);
+    uint16_t bank_end = address + CONFIG_BANK_SIZE;
+    ConfigRecordHeaderType_t Header;
+
+    while (readHeader(address, bank_end, Header)) {
+
+        uint16_t *entry = indexEntry(Header.type, Header.id);
+        if (entry != nullptr && *entry == 0) {
+            *entry = address;
+            index_count++;
+        } else if (entry != nullptr) {
+            ConfigRecordHeaderType_t Indexed;
+            EEPROM.get(*entry, Indexed);
+            if (Header.sequence > Indexed.sequence) {
+                *entry = address;
+            }
+        }
+
+        if (Header.sequence >= next_sequence) {
+            next_sequence = Header.sequence + 1;
+        }
+        address += getRecordSize(Header.length);
+    }
+    rEndAddress = address;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Reads and validates a record header, and the payload CRC32.
+
+ @param  address
+         EEPROM address of the header.
+ @param  bank_end
+         The record must end before this address.
+ @param  rHeader
+         Returns the header.
+ @return true if a valid record starts at 'address'.
+ */
+//-----------------------------------------------------------------------------
+bool ConfigStore::readHeader(uint16_t address, uint16_t bank_end,
+                                    ConfigRecordHeaderType_t &rHeader) {
+
+    if (address + sizeof(ConfigRecordHeaderType_t) > bank_end) {
+        return false;
+    }
+    EEPROM.get(address, rHeader);
+
+    if (rHeader.magic != CONFIG_RECORD_MAGIC || rHeader.reserved != 0 ||
+                    address + getRecordSize(rHeader.length) > bank_end) {
+        return false;
+    }
+    uint16_t payload = address + sizeof(ConfigRecordHeaderType_t);
+    return calculateRecordCRC32(rHeader, nullptr, payload) == rHeader.crc32;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Copies the newest record of a (type, id) into 'data'.
+
+ @param  type
+         Record type (ConfigRecordType_e).
+ @param  id
+         Channel (instance) number, or 0.
+ @param  data
+         Receives the payload.
+ @param  len
+         Size of 'data', must match the stored size.
+ @return true if a record was found.
+ */
+//-----------------------------------------------------------------------------
+bool ConfigStore::read(uint8_t type, uint16_t id, void *data, uint16_t len) {
+
+    begin();
+
+    uint16_t *entry = indexEntry(type, id);
+    if (entry == nullptr || *entry == 0) {
+        return false;
+    }
+
+    ConfigRecordHeaderType_t Header;
+    EEPROM.get(*entry, Header);
+    if (Header.length != len) {
+        return false;
+    }
+
+    uint8_t *u = static_cast<uint8_t *>(data);
+    uint16_t payload = *entry + sizeof(ConfigRecordHeaderType_t);
+    for (uint16_t cnt = 0; cnt < len; cnt++) {
+        u[cnt] = EEPROM.read(payload + cnt);
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Appends a record. The bank is compacted first if it is full.
+         The record is staged, until commit().
+
+ @param  type
+         Record type (ConfigRecordType_e).
+ @param  id
+         Channel (instance) number, or 0.
+ @param  data
+         The payload.
+ @param  len
+         Size of 'data'.
+ @return true if the record is staged.
+ */
+//-----------------------------------------------------------------------------
+bool ConfigStore::write(uint8_t type, uint16_t id, const void *data, uint16_t len) {
+
+    begin();
+
+    if (indexEntry(type, id) == nullptr) {
+        return false;
+    }
+    if (getRecordSize(len) > CONFIG_BANK_SIZE) {
+        return false;
+    }
+
+    uint16_t bank_end = bankStart(active_bank) + CONFIG_BANK_SIZE;
+    if (write_address + getRecordSize(len) > bank_end) {
+        // Compaction would not make room, i.e. all records are live
+        if (getLiveBytes(type, id) + getRecordSize(len) > CONFIG_BANK_SIZE) {
+            return false;
+        }
+        compact(type, id);
+    }
+    return appendRecord(type, id, data, len, 0);
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Log space of the live records, except the (type, id) to replace.
+
+ @param  type
+         Record type of a record to be replaced.
+ @param  id
+         Channel (instance) number of a record to be replaced.
+ @return Bytes used by the live records after compaction.
+ */
+//-----------------------------------------------------------------------------
+uint16_t ConfigStore::getLiveBytes(uint8_t type, uint16_t id) {
+
+    uint16_t *replaced = indexEntry(type, id);
+    uint16_t live_bytes = 0;
+
+    for (uint8_t cnt = 0; cnt < CONFIG_RECORD_TYPES; cnt++) {
+        for (uint16_t channel = 0; channel <= MAX_CHANNELS; channel++) {
+            uint16_t *entry = &index_address[cnt][channel];
+            if (*entry != 0 && entry != replaced) {
+                ConfigRecordHeaderType_t Header;
+                EEPROM.get(*entry, Header);
+                live_bytes += getRecordSize(Header.length);
+            }
+        }
+    }
+    return live_bytes;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Copies the live records to the other bank, which is erased first,
+         and makes it the active bank. The record to be replaced is not
+         copied, i.e. the bank holds the space of getLiveBytes().
+
+ @param  type
+         Record type of the record to be replaced.
+ @param  id
+         Channel (instance) number of the record to be replaced.
+ @return true when done.
+ */
+//-----------------------------------------------------------------------------
+bool ConfigStore::compact(uint8_t type, uint16_t id) {
+
+    uint8_t target_bank = active_bank ^ 1;
+    uint16_t start = bankStart(target_bank);
+
+    for (uint16_t address = start; address < start + CONFIG_BANK_SIZE; address++) {
+        if (EEPROM.read(address) != 0xFF) {
+            EEPROM.write(address, 0xFF);
+        }
+    }
+
+    active_bank = target_bank;
+    write_address = start;
+
+    // The old bank is left as is, it only holds older sequence numbers
+    uint16_t *replaced = indexEntry(type, id);
+    for (uint8_t cnt = 0; cnt < CONFIG_RECORD_TYPES; cnt++) {
+        for (uint16_t channel = 0; channel <= MAX_CHANNELS; channel++) {
+            uint16_t address = index_address[cnt][channel];
+            if (address != 0 && &index_address[cnt][channel] != replaced) {
+                ConfigRecordHeaderType_t Header;
+                EEPROM.get(address, Header);
+                appendRecord(Header.type, Header.id, nullptr, Header.length,
+                            address + sizeof(ConfigRecordHeaderType_t));
+            }
+        }
+    }
+
+    compaction_count++;
+    dirty_flag = true;
+
+#ifndef ARDUINO
+    PLOG_INFO << "EEPROM log compacted to bank " << (int) active_bank << ", used " << getUsedBytes();
+#endif
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Writes a record at the write address, and updates the index.
+
+ @param  type
+         Record type (ConfigRecordType_e).
+ @param  id
+         Channel (instance) number, or 0.
+ @param  data
+         The payload, or nullptr to copy it from 'src_address'.
+ @param  len
+         Payload size.
+ @param  src_address
+         EEPROM address of the payload, if 'data' is nullptr.
+ @return true when written.
+ */
+//-----------------------------------------------------------------------------
+bool ConfigStore::appendRecord(uint8_t type, uint16_t id, const void *data,
+                                    uint16_t len, uint16_t src_address) {
+
+    ConfigRecordHeaderType_t Header;
+    Header.magic = CONFIG_RECORD_MAGIC;
+    Header.type = type;
+    Header.id = id;
+    Header.length = len;
+    Header.reserved = 0;
+    Header.sequence = next_sequence++;
+    Header.crc32 = calculateRecordCRC32(Header, data, src_address);
+
+    uint16_t address = write_address;
+    EEPROM.put(address, Header);
+
+    uint16_t payload = address + sizeof(ConfigRecordHeaderType_t);
+    const uint8_t *u = static_cast<const uint8_t *>(data);
+    for (uint16_t cnt = 0; cnt < len; cnt++) {
+        EEPROM.write(payload + cnt, u ? u[cnt] : EEPROM.read(src_address + cnt));
+    }
+    write_address += getRecordSize(len);
+
+    uint16_t *entry = indexEntry(type, id);
+    if (*entry == 0) {
+        index_count++;
+    }
+    *entry = address;
+
+    dirty_flag = true;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  CRC32 of the header (without the crc32 field) and the payload.
+
+ @param  rHeader
+         The record header.
+ @param  data
+         The payload, or nullptr to read it from 'src_address'.
+ @param  src_address
+         EEPROM address of the payload, if 'data' is nullptr.
+ @return The calculated CRC32.
+ */
+//-----------------------------------------------------------------------------
+uint32_t ConfigStore::calculateRecordCRC32(ConfigRecordHeaderType_t const &rHeader,
+                                    const void *data, uint16_t src_address) {
+
+    uint32_t crc = SensorWLED::calculateCRC32(&rHeader, offsetof(ConfigRecordHeaderType_t, crc32));
+
+    if (data) {
+        return SensorWLED::calculateCRC32(data, rHeader.length, crc);
+    }
+
+    // Stored payload, in chunks
+    uint8_t chunk[32];
+    for (uint16_t done = 0; done < rHeader.length; ) {
+        uint16_t n = rHeader.length - done;
+        if (n > sizeof(chunk)) {
+            n = sizeof(chunk);
+        }
+        for (uint16_t cnt = 0; cnt < n; cnt++) {
+            chunk[cnt] = EEPROM.read(src_address + done + cnt);
+        }
+        crc = SensorWLED::calculateCRC32(chunk, n, crc);
+        done += n;
+    }
+    return crc;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  The index entry of a (type, id), i.e. the record address.
+ @return The entry, or nullptr if the type or id is out of range.
+ */
+//-----------------------------------------------------------------------------
+uint16_t *ConfigStore::indexEntry(uint8_t type, uint16_t id) {
+
+    if (type == 0 || type > CONFIG_RECORD_TYPES || id > MAX_CHANNELS) {
+        return nullptr;
+    }
+    return &index_address[type - 1][id];
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Writes all staged records to flash, in one EEPROM commit.
+ @return true if EEPROM committed.
+ */
+//-----------------------------------------------------------------------------
+bool ConfigStore::commit(void) {
+
+    if (dirty_flag == false) {
+        return false;
+    }
+
+#ifndef ARDUINO
+    PLOG_INFO << "EEPROM COMMIT, log bank " << (int) active_bank << ", used " << getUsedBytes();
+#endif
+
+    dirty_flag = false;
+    return EEPROM.commit();
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Checks for staged, not committed, records.
+ @return true if commit() is needed.
+ */
+//-----------------------------------------------------------------------------
+bool ConfigStore::isDirty(void) {
+    return dirty_flag;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Gets the bank where records are appended.
+ @return Bank number (0 or 1).
+ */
+//-----------------------------------------------------------------------------
+uint8_t ConfigStore::getActiveBank(void) {
+    return active_bank;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Gets the used size of the active bank.
+ @return Used bytes, of CONFIG_BANK_SIZE.
+ */
+//-----------------------------------------------------------------------------
+uint16_t ConfigStore::getUsedBytes(void) {
+    return write_address - bankStart(active_bank);
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Gets the number of live records, i.e. the used index entries.
+ @return Live records.
+ */
+//-----------------------------------------------------------------------------
+uint16_t ConfigStore::getRecordCount(void) {
+    return index_count;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Gets the sequence number of the next record.
+ @return Sequence number.
+ */
+//-----------------------------------------------------------------------------
+uint32_t ConfigStore::getSequence(void) {
+    return next_sequence;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Gets the number of compactions since boot.
+ @return Compactions.
+ */
+//-----------------------------------------------------------------------------
+uint32_t ConfigStore::getCompactionCount(void) {
+    return compaction_count;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  First EEPROM address of a bank.
+ @param  bank
+         Bank number (0 or 1).
+ @return EEPROM address.
+ */
+//-----------------------------------------------------------------------------
+uint16_t ConfigStore::bankStart(uint8_t bank) {
+    return CONFIG_STORE_START + bank * CONFIG_BANK_SIZE;
+}
@@ -0,0 +1,127 @@
+/*!
+ * @file ConfigStore.h
+ *
+ * This is part of SensorWLED library for the Arduino platform.
+ * Source: https://github.com/berrak/SensorWLED
+ *
+ * The MIT license.
+ *
+ */
+#ifndef CONFIGSTORE_H_
+#define CONFIGSTORE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/** First EEPROM address of the configuration record log */
+#if !defined(CONFIG_STORE_START)
+    #define CONFIG_STORE_START 0x100
+#endif
+
+/** Size of each of the two log banks (bytes) */
+#if !defined(CONFIG_BANK_SIZE)
+    #define CONFIG_BANK_SIZE 0x780
+#endif
+
+#define CONFIG_RECORD_MAGIC 0x5A    ///< Record start marker (never touch)
+#define CONFIG_RECORD_ALIGN 4       ///< Records start at multiples of this
+
+//-----------------------------------------------------------------------------
+/** Record types in the configuration log */
+typedef enum : uint8_t {
+    version_record = 1,         ///< EEPROM Id and program version (id 0)
+    calibration_record,         ///< CalibrationDataType_t, per channel
+    dynamic_record,             ///< DynamicDataType_t, per channel
+    integrator_record,          ///< IntegratorDataType_t checkpoint, per channel
+    calibration_points_record,  ///< CalibrationPointsType_t, per channel
+} ConfigRecordType_e;
+
+#define CONFIG_RECORD_TYPES 5   ///< Number of record types, sizes the index
+
+//-----------------------------------------------------------------------------
+/*!
+    @brief  Header before each record payload in the log.
+*/
+//-----------------------------------------------------------------------------
+typedef struct {
+    uint8_t magic;              ///< CONFIG_RECORD_MAGIC (0xFF: erased)
+    uint8_t type;               ///< ConfigRecordType_e
+    uint16_t id;                ///< Channel (instance) number, 0: common
+    uint16_t length;            ///< Payload size (bytes)
+    uint16_t reserved;          ///< Always zero
+    uint32_t sequence;          ///< Increases with each written record
+    uint32_t crc32;             ///< CRC32 of the fields above and the payload
+} ConfigRecordHeaderType_t;
+
+//-----------------------------------------------------------------------------
+/*!
+    @brief  Append-only, wear-leveled log of configuration records in the
+            (emulated) EEPROM.
+
+            A changed record is appended after the last one, rather than
+            rewritten in place, so repeated changes move over the flash.
+            Each record has a sequence number and a CRC32, and the newest
+            valid record of each (type, id) wins. The log is scanned once
+            at boot into a RAM index, addressed by (type, id), so reads
+            need no search. The id is 0..MAX_CHANNELS (from SensorWLED.h).
+
+            There are two banks. When the active bank is full, the live
+            records are copied (compacted) to the other bank, which then
+            becomes the active one. A torn or corrupted record ends the
+            scan of a bank, and is overwritten by the next record.
+*/
+//-----------------------------------------------------------------------------
+class ConfigStore {
+
+public:
+
+    ConfigStore(void);
+
+    // Opens the EEPROM and rebuilds the index (only the first call).
+    void begin(void);
+
+    bool read(uint8_t type, uint16_t id, void *data, uint16_t len);
+    bool write(uint8_t type, uint16_t id, const void *data, uint16_t len);
+
+    // Writes all staged records to flash in one EEPROM commit.
+    bool commit(void);
+    bool isDirty(void);
+
+    uint8_t getActiveBank(void);
+    uint16_t getUsedBytes(void);
+    uint16_t getRecordCount(void);
+    uint32_t getSequence(void);
+    uint32_t getCompactionCount(void);
+
+    // Log space used by a record with a 'len' bytes payload.
+    static uint16_t getRecordSize(uint16_t len);
+
+private:
+
+    void scanBank(uint8_t bank, uint16_t &rEndAddress);
+    bool compact(uint8_t type, uint16_t id);
+    uint16_t getLiveBytes(uint8_t type, uint16_t id);
+    bool appendRecord(uint8_t type, uint16_t id, const void *data,
+                            uint16_t len, uint16_t src_address);
+    uint16_t *indexEntry(uint8_t type, uint16_t id);
+    bool readHeader(uint16_t address, uint16_t bank_end,
+                            ConfigRecordHeaderType_t &rHeader);
+    uint32_t calculateRecordCRC32(ConfigRecordHeaderType_t const &rHeader,
+                            const void *data, uint16_t src_address);
+    uint16_t bankStart(uint8_t bank);
+
+    /** EEPROM address of the newest record per (type, id), 0: none */
+    uint16_t index_address[CONFIG_RECORD_TYPES][MAX_CHANNELS + 1];
+    uint16_t index_count;           ///< Used index entries
+
+    uint8_t active_bank;            ///< Bank (0 or 1) where records are appended
+    uint16_t write_address;         ///< Next record address in the active bank
+    uint32_t next_sequence;         ///< Sequence number of the next record
+    uint32_t compaction_count;      ///< Compactions since boot
+
+    bool open_flag;                 ///< EEPROM staged in RAM, index built
+    bool dirty_flag;                ///< Staged, not committed records
+};
+/* class ConfigStore */
+
+#endif /* CONFIGSTORE_H_ */
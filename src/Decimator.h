@@ -0,0 +1,187 @@
+/*!
+ * @file Decimator.h
+ *
+ * This is part of SensorWLED library for the Arduino platform.
+ * Source: https://github.com/berrak/SensorWLED
+ *
+ * The MIT license.
+ *
+ */
+#ifndef DECIMATOR_H_
+#define DECIMATOR_H_
+
+#include <stdint.h>
+
+//-----------------------------------------------------------------------------
+/*!
+    @brief  Decimating CIC (cascaded integrator-comb) filter, with a 3-tap
+            FIR droop compensator, on the raw ADC code stream. Integer
+            arithmetic only.
+
+            Every 2^log2_ratio codes give one output code, with
+            'extra_bits' more resolution than the ADC. Oversampling a
+            noisy (dithered) input gives about one effective bit per four
+            times the ratio. ORDER (1 to 4) stages give a steeper
+            stop-band than a boxcar average (ORDER 1).
+
+            The integrators wrap around (modular arithmetic), which is
+            exact while the ADC bits + ORDER * log2_ratio fit in 31 bits.
+            The compensator [-N, 24 + 2N, -N] / 24 flattens the CIC
+            passband droop, i.e. 1 - N (pi f)^2 / 6, to the second order.
+*/
+//-----------------------------------------------------------------------------
+template <uint8_t ORDER>
+class Decimator {
+
+    static_assert(ORDER >= 1 && ORDER <= 4, "Use 1 to 4 CIC stages");
+
+public:
+
+    Decimator(void) {
+        setup(0, 0, 0);
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Sets the ratio and the output resolution, and clears the state.
+             Too large values are reduced to what the 32-bit integrators,
+             and the 16-bit output codes, can hold.
+     @param  log2_ratio
+             Decimation ratio 2^log2_ratio, 0: disabled.
+     @param  extra_bits
+             Output resolution above the ADC bits.
+     @param  adc_bits
+             ADC resolution (bits).
+     */
+    //-------------------------------------------------------------------------
+    void setup(uint8_t log2_ratio, uint8_t extra_bits, uint8_t adc_bits) {
+
+        while (log2_ratio > 0 && adc_bits + ORDER * log2_ratio > 31) {
+            log2_ratio--;
+        }
+        if (adc_bits + extra_bits > 16) {
+            extra_bits = 16 - adc_bits;
+        }
+        if (extra_bits > ORDER * log2_ratio) {
+            extra_bits = ORDER * log2_ratio;
+        }
+
+        ratio_log2 = log2_ratio;
+        output_bits = extra_bits;
+        output_max = (adc_bits > 0) ? ((1UL << adc_bits) - 1) << extra_bits : 0;
+        reset();
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Clears the filter state.
+     */
+    //-------------------------------------------------------------------------
+    void reset(void) {
+
+        for (uint8_t stage = 0; stage < ORDER; stage++) {
+            integrator[stage] = 0;
+            comb_delay[stage] = 0;
+        }
+        fir_delay[0] = 0;
+        fir_delay[1] = 0;
+        phase = 0;
+        settle_count = 0;
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Filters a code.
+     @param  code
+             Raw ADC code.
+     @param  rOutput
+             Receives the output code, at the output resolution.
+     @return true every 2^log2_ratio codes, when 'rOutput' is set. The 
+             first output comes after ORDER * 2^log2_ratio codes.
+     */
+    //-------------------------------------------------------------------------
+    bool add(uint16_t code, uint16_t &rOutput) {
+
+        uint32_t value = code;
+        for (uint8_t stage = 0; stage < ORDER; stage++) {
+            integrator[stage] += value;
+            value = integrator[stage];
+        }
+        if (++phase < (1UL << ratio_log2)) {
+            return false;
+        }
+        phase = 0;
+
+        for (uint8_t stage = 0; stage < ORDER; stage++) {
+            uint32_t delayed = comb_delay[stage];
+            comb_delay[stage] = value;
+            value -= delayed;
+        }
+
+        // The first ORDER-1 outputs see the zero state, then the first
+        // settled output fills the compensator
+        if (settle_count < ORDER) {
+            if (++settle_count < ORDER) {
+                return false;
+            }
+            fir_delay[0] = fir_delay[1] = value;
+        }
+
+        int64_t fir_sum = (int64_t) (24 + 2 * ORDER) * fir_delay[0] -
+                    (int64_t) ORDER * ((int64_t) fir_delay[1] + value);
+        fir_delay[1] = fir_delay[0];
+        fir_delay[0] = value;
+
+        // Gain is 24 * 2^(ORDER * log2_ratio), keep 'output_bits' of it
+        uint8_t shift = ORDER * ratio_log2 - output_bits;
+        int64_t divisor = (int64_t) 24 << shift;
+        int64_t output = (fir_sum + divisor / 2) / divisor;
+
+        rOutput = (output < 0) ? 0 : (output > output_max) ? output_max : output;
+        return true;
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Checks if codes are decimated.
+     @return true if the ratio is at least 2.
+     */
+    //-------------------------------------------------------------------------
+    bool isEnabled(void) const {
+        return ratio_log2 > 0;
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Codes per output.
+     @return The decimation ratio.
+     */
+    //-------------------------------------------------------------------------
+    uint16_t getRatio(void) const {
+        return 1U << ratio_log2;
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Output resolution above the ADC bits.
+     @return The (possibly reduced) extra bits.
+     */
+    //-------------------------------------------------------------------------
+    uint8_t getExtraBits(void) const {
+        return output_bits;
+    }
+
+private:
+
+    uint32_t integrator[ORDER];         ///< Integrator stages (input rate)
+    uint32_t comb_delay[ORDER];         ///< Comb stage delays (output rate)
+    uint32_t fir_delay[2];              ///< Previous CIC outputs
+    uint32_t output_max;                ///< Largest output code
+    uint16_t phase;                     ///< Codes since the last output
+    uint8_t settle_count;               ///< CIC outputs since reset, up to ORDER
+    uint8_t ratio_log2;                 ///< Decimation ratio (log2), 0: off
+    uint8_t output_bits;                ///< Extra output resolution (bits)
+};
+/* class Decimator */
+
+#endif /* DECIMATOR_H_ */
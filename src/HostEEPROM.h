@@ -0,0 +1,225 @@
+/*!
+ * @file HostEEPROM.h
+ *
+ * This is part of SensorWLED library for the Arduino platform.
+ * Source: https://github.com/berrak/SensorWLED
+ *
+ * The MIT license.
+ *
+ */
+#ifndef HOSTEEPROM_H_
+#define HOSTEEPROM_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+/** Size of the host EEPROM stand-in, i.e. one ESP32/ESP8266 flash sector */
+#if !defined(HOST_EEPROM_SIZE)
+    #define HOST_EEPROM_SIZE 4096
+#endif
+
+/** Erase unit of the emulated flash */
+#if !defined(HOST_EEPROM_SECTOR_SIZE)
+    #define HOST_EEPROM_SECTOR_SIZE 256
+#endif
+
+#define HOST_EEPROM_SECTORS (HOST_EEPROM_SIZE / HOST_EEPROM_SECTOR_SIZE) ///< Sectors
+
+static_assert(HOST_EEPROM_SIZE % HOST_EEPROM_SECTOR_SIZE == 0, "Size must be whole sectors");
+
+//-----------------------------------------------------------------------------
+/*!
+    @brief  Host (non-Arduino) stand-in for the ESP32/ESP8266 EEPROM library.
+
+            Like the ESP cores, data is staged in RAM after begin(), and
+            only a commit() of changed data writes the (emulated) flash.
+            Accesses beyond the size given to begin() are ignored. The
+            counters make it possible to verify the number of commits.
+
+            The flash is modelled as sectors. A commit programs only the
+            changed sectors, and a sector is erased (and counted) only if
+            a bit must change from 0 to 1, as for NOR flash.
+*/
+//-----------------------------------------------------------------------------
+class HostEEPROMClass {
+
+public:
+
+    HostEEPROMClass(void) {
+        memset(flash, 0xFF, sizeof(flash));
+        memset(ram, 0xFF, sizeof(ram));
+        size = 0;
+        dirty_flag = false;
+        begin_count = 0;
+        commit_count = 0;
+        flash_write_count = 0;
+        memset(erase_count, 0, sizeof(erase_count));
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Loads 'len' bytes from flash into RAM.
+     @param  len
+             Size of the used EEPROM area.
+     */
+    //-------------------------------------------------------------------------
+    void begin(size_t len) {
+        size = (len > HOST_EEPROM_SIZE) ? HOST_EEPROM_SIZE : len;
+        memcpy(ram, flash, size);
+        dirty_flag = false;
+        begin_count++;
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Writes changed RAM data to flash.
+     @return True when successful.
+     */
+    //-------------------------------------------------------------------------
+    bool commit(void) {
+        commit_count++;
+        if (size == 0) {
+            return false;
+        }
+        if (dirty_flag) {
+            for (size_t start = 0; start < size; start += HOST_EEPROM_SECTOR_SIZE) {
+                programSector(start);
+            }
+            dirty_flag = false;
+            flash_write_count++;
+        }
+        return true;
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Commits, and releases the RAM copy.
+     */
+    //-------------------------------------------------------------------------
+    void end(void) {
+        commit();
+        size = 0;
+    }
+
+    uint8_t read(int address) {
+        return (address >= 0 && (size_t) address < size) ? ram[address] : 0;
+    }
+
+    void write(int address, uint8_t value) {
+        if (address >= 0 && (size_t) address < size && ram[address] != value) {
+            ram[address] = value;
+            dirty_flag = true;
+        }
+    }
+
+    template<typename T> T &get(int address, T &t) {
+        if (address >= 0 && address + sizeof(T) <= size) {
+            memcpy((uint8_t *) &t, ram + address, sizeof(T));
+        }
+        return t;
+    }
+
+    template<typename T> const T &put(int address, const T &t) {
+        if (address >= 0 && address + sizeof(T) <= size) {
+            if (memcmp(ram + address, (const uint8_t *) &t, sizeof(T)) != 0) {
+                memcpy(ram + address, (const uint8_t *) &t, sizeof(T));
+                dirty_flag = true;
+            }
+        }
+        return t;
+    }
+
+    size_t length(void) {
+        return size;
+    }
+
+    /*!
+     @brief  Replaces the flash contents, e.g. with the EEPROM dump of a
+             board, so a replay begins with the same stored records.
+     @param  image
+             Flash contents, the rest is erased (0xFF).
+     @param  len
+             Image size (bytes), up to HOST_EEPROM_SIZE.
+     */
+    void setImage(const uint8_t *image, size_t len) {
+        memset(flash, 0xFF, sizeof(flash));
+        memcpy(flash, image, (len > HOST_EEPROM_SIZE) ? HOST_EEPROM_SIZE : len);
+        size = 0;
+        dirty_flag = false;
+    }
+
+    /*!
+     @brief  The flash contents, e.g. to save after a run.
+     @return HOST_EEPROM_SIZE bytes of flash.
+     */
+    const uint8_t *getImage(void) {
+        return flash;
+    }
+
+    uint32_t getBeginCount(void) { return begin_count; }     ///< Calls to begin()
+    uint32_t getCommitCount(void) { return commit_count; }   ///< Calls to commit()
+    uint32_t getFlashWriteCount(void) { return flash_write_count; } ///< Flash writes
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Number of erase cycles of a flash sector.
+     @param  sector
+             Sector number, address / HOST_EEPROM_SECTOR_SIZE.
+     @return Erase cycles since start.
+     */
+    //-------------------------------------------------------------------------
+    uint32_t getEraseCount(uint16_t sector) {
+        return (sector < HOST_EEPROM_SECTORS) ? erase_count[sector] : 0;
+    }
+
+private:
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Programs the sector at 'start' if changed, with an erase first
+             if any bit changes from 0 to 1.
+     @param  start
+             First address of the sector.
+     */
+    //-------------------------------------------------------------------------
+    void programSector(size_t start) {
+
+        size_t end = start + HOST_EEPROM_SECTOR_SIZE;
+        if (end > size) {
+            end = size;
+        }
+        if (memcmp(flash + start, ram + start, end - start) == 0) {
+            return;
+        }
+
+        bool erase_flag = false;
+        for (size_t address = start; address < end; address++) {
+            if ((flash[address] & ram[address]) != ram[address]) {
+                erase_flag = true;
+                break;
+            }
+        }
+        if (erase_flag) {
+            // The part beyond 'size' is erased too, as on real flash
+            size_t sector_end = start + HOST_EEPROM_SECTOR_SIZE;
+            memset(flash + end, 0xFF, sector_end - end);
+            erase_count[start / HOST_EEPROM_SECTOR_SIZE]++;
+        }
+        memcpy(flash + start, ram + start, end - start);
+    }
+
+    uint8_t flash[HOST_EEPROM_SIZE];    ///< Emulated flash sector
+    uint8_t ram[HOST_EEPROM_SIZE];      ///< Staged data, after begin()
+    size_t size;                        ///< Size given to begin()
+    bool dirty_flag;                    ///< RAM data differs from flash
+    uint32_t begin_count;               ///< Number of begin() calls
+    uint32_t commit_count;              ///< Number of commit() calls
+    uint32_t flash_write_count;         ///< Commits that wrote the flash
+    uint32_t erase_count[HOST_EEPROM_SECTORS]; ///< Erase cycles per sector
+};
+/* class HostEEPROMClass */
+
+inline HostEEPROMClass EEPROM;  ///< Same name as the Arduino EEPROM object
+
+#endif /* HOSTEEPROM_H_ */
@@ -0,0 +1,172 @@
+/*!
+ * @file HostPlatform.h
+ *
+ * This is part of SensorWLED library for the Arduino platform.
+ * Source: https://github.com/berrak/SensorWLED
+ *
+ * The MIT license.
+ *
+ */
+#ifndef HOSTPLATFORM_H_
+#define HOSTPLATFORM_H_
+
+#include <cstdint>
+#include <cstddef>
+
+/** Number of analog pins with a default (settable) value on the host */
+#if !defined(HOST_ANALOG_PINS)
+    #define HOST_ANALOG_PINS 64
+#endif
+
+#if !defined(INPUT)
+    #define INPUT 0x01      ///< Same pin mode value as the ESP32 core
+#endif
+#if !defined(OUTPUT)
+    #define OUTPUT 0x03     ///< Same pin mode value as the ESP32 core
+#endif
+
+//-----------------------------------------------------------------------------
+/*!
+    @brief  Host (non-Arduino) stand-in for the Arduino core functions the
+            library uses: analogRead(), millis(), micros(), delay(), and
+            delayMicroseconds().
+
+            By default, time is virtual. It starts at 0, and only moves
+            with delays and setTime()/advanceTime(), i.e. runs are
+            deterministic and as fast as the CPU. analogRead() returns the
+            value set per pin. Each function can be replaced by a provider,
+            e.g. a trace replay (HostReplay.h) or a simulated signal.
+
+            The clock has 64 bits of microseconds, so millis() and micros()
+            wrap around like on the boards, after 49.7 days and 71.6
+            minutes.
+*/
+//-----------------------------------------------------------------------------
+class HostPlatformClass {
+
+public:
+
+    /** Returns the code of an analog read */
+    typedef uint16_t (*AnalogReadProvider)(uint8_t pin, void *context);
+    /** Returns the time (microseconds, 64 bits) */
+    typedef uint64_t (*ClockProvider)(void *context);
+    /** Waits, or advances a clock (microseconds) */
+    typedef void (*DelayProvider)(uint32_t us_delay, void *context);
+
+    HostPlatformClass(void) {
+        reset();
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Removes the providers, and clears the time, the pin values, and
+             the counters.
+     */
+    //-------------------------------------------------------------------------
+    void reset(void) {
+        analog_read_provider = nullptr;
+        analog_read_context = nullptr;
+        clock_provider = nullptr;
+        clock_context = nullptr;
+        delay_provider = nullptr;
+        delay_context = nullptr;
+        us_virtual_time = 0;
+        analog_read_count = 0;
+        for (uint16_t pin = 0; pin < HOST_ANALOG_PINS; pin++) {
+            analog_value[pin] = 0;
+        }
+    }
+
+    /*!
+     @brief  Replaces analogRead(), nullptr for the pin values.
+     */
+    void setAnalogReadProvider(AnalogReadProvider provider, void *context) {
+        analog_read_provider = provider;
+        analog_read_context = context;
+    }
+
+    /*!
+     @brief  Replaces the virtual clock, nullptr for the virtual clock.
+     */
+    void setClockProvider(ClockProvider provider, void *context) {
+        clock_provider = provider;
+        clock_context = context;
+    }
+
+    /*!
+     @brief  Replaces the delays, nullptr to advance the virtual clock.
+     */
+    void setDelayProvider(DelayProvider provider, void *context) {
+        delay_provider = provider;
+        delay_context = context;
+    }
+
+    /*!
+     @brief  Sets the code that analogRead() returns without a provider.
+     */
+    void setAnalogValue(uint8_t pin, uint16_t code) {
+        if (pin < HOST_ANALOG_PINS) {
+            analog_value[pin] = code;
+        }
+    }
+
+    void setTime(uint64_t us_time) { us_virtual_time = us_time; }    ///< Sets the virtual clock
+    void advanceTime(uint64_t us_time) { us_virtual_time += us_time; } ///< Moves the virtual clock
+    uint64_t getVirtualTime(void) { return us_virtual_time; }        ///< The virtual clock
+
+    /*!
+     @brief  The current time, of the clock provider or the virtual clock.
+     @return Microseconds (64 bits, no wraparound).
+     */
+    uint64_t getTime(void) {
+        return (clock_provider != nullptr) ? clock_provider(clock_context) : us_virtual_time;
+    }
+
+    uint16_t analogRead(uint8_t pin) {
+        analog_read_count++;
+        if (analog_read_provider != nullptr) {
+            return analog_read_provider(pin, analog_read_context);
+        }
+        return (pin < HOST_ANALOG_PINS) ? analog_value[pin] : 0;
+    }
+
+    void delayMicroseconds(uint32_t us_delay) {
+        if (delay_provider != nullptr) {
+            delay_provider(us_delay, delay_context);
+        } else {
+            us_virtual_time += us_delay;
+        }
+    }
+
+    uint32_t getAnalogReadCount(void) { return analog_read_count; }  ///< Calls to analogRead()
+
+private:
+
+    AnalogReadProvider analog_read_provider;    ///< analogRead() replacement
+    void *analog_read_context;                  ///< Passed to the provider
+    ClockProvider clock_provider;               ///< Clock replacement
+    void *clock_context;                        ///< Passed to the provider
+    DelayProvider delay_provider;               ///< Delay replacement
+    void *delay_context;                        ///< Passed to the provider
+
+    uint64_t us_virtual_time;                   ///< Virtual clock (microseconds)
+    uint32_t analog_read_count;                 ///< Number of analogRead() calls
+    uint16_t analog_value[HOST_ANALOG_PINS];    ///< Codes without a provider
+};
+/* class HostPlatformClass */
+
+inline HostPlatformClass HostPlatform;  ///< The host back end
+
+// The Arduino core functions, as used by the library
+inline uint32_t millis(void) { return HostPlatform.getTime() / 1000; }
+inline uint32_t micros(void) { return HostPlatform.getTime(); }
+inline void delayMicroseconds(uint32_t us) { HostPlatform.delayMicroseconds(us); }
+inline void delay(uint32_t ms) { HostPlatform.delayMicroseconds(ms * 1000UL); }
+inline uint16_t analogRead(uint8_t pin) { return HostPlatform.analogRead(pin); }
+inline void pinMode(uint8_t pin, uint8_t mode) { (void) pin; (void) mode; }
+
+inline long map(long x, long in_min, long in_max, long out_min, long out_max) {
+    return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+#endif /* HOSTPLATFORM_H_ */
@@ -0,0 +1,358 @@
+/*!
+ * @file HostReplay.h
+ *
+ * This is part of SensorWLED library for the Arduino platform.
+ * Source: https://github.com/berrak/SensorWLED
+ *
+ * The MIT license.
+ *
+ */
+#ifndef HOSTREPLAY_H_
+#define HOSTREPLAY_H_
+
+#ifndef ARDUINO     // Host (POSIX) only, the trace is memory-mapped
+
+#include "SensorWLED.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TRACE_MAGIC "SWTR"      ///< First bytes of a trace file
+#define TRACE_FORMAT 1          ///< Trace file format version
+
+//-----------------------------------------------------------------------------
+/** Trace file header, followed by the records (little-endian) */
+typedef struct {
+    char magic[4];              ///< TRACE_MAGIC
+    uint16_t format;            ///< TRACE_FORMAT
+    uint16_t record_size;       ///< sizeof(TraceRecordType_t)
+} TraceHeaderType_t;
+
+/** One ADC reading of the trace, in time order */
+typedef struct {
+    uint32_t us_time;           ///< Time of the reading (micros(), wraps around)
+    uint16_t code;              ///< Raw ADC code
+    uint8_t pin;                ///< Analog pin
+    uint8_t reserved;           ///< Zero
+} TraceRecordType_t;
+
+static_assert(sizeof(TraceHeaderType_t) == 8 && sizeof(TraceRecordType_t) == 8,
+                                                    "The trace layout is fixed");
+
+//-----------------------------------------------------------------------------
+/*!
+    @brief  Writes a trace file, e.g. from field data, or to record a
+            simulated signal.
+*/
+//-----------------------------------------------------------------------------
+class TraceWriter {
+
+public:
+
+    TraceWriter(void) {
+        file = nullptr;
+    }
+
+    ~TraceWriter(void) {
+        close();
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Creates the trace file, and writes the header.
+     @param  path
+             File name.
+     @return true if created.
+     */
+    //-------------------------------------------------------------------------
+    bool open(const char *path) {
+
+        close();
+        file = fopen(path, "wb");
+        if (file == nullptr) {
+            return false;
+        }
+        TraceHeaderType_t header = {};
+        memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+        header.format = TRACE_FORMAT;
+        header.record_size = sizeof(TraceRecordType_t);
+        return fwrite(&header, sizeof(header), 1, file) == 1;
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Appends a reading.
+     @return true if written.
+     */
+    //-------------------------------------------------------------------------
+    bool add(uint32_t us_time, uint8_t pin, uint16_t code) {
+
+        TraceRecordType_t record = {us_time, code, pin, 0};
+        return file != nullptr && fwrite(&record, sizeof(record), 1, file) == 1;
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Flushes and closes the file.
+     @return true if all data was written.
+     */
+    //-------------------------------------------------------------------------
+    bool close(void) {
+
+        bool ok_flag = true;
+        if (file != nullptr) {
+            ok_flag = (fclose(file) == 0);
+            file = nullptr;
+        }
+        return ok_flag;
+    }
+
+private:
+
+    FILE *file;                     ///< The open trace file
+};
+/* class TraceWriter */
+
+//-----------------------------------------------------------------------------
+/*!
+    @brief  Replays a recorded ADC trace through all SensorWLED instances,
+            on the virtual clock of the host back end (HostPlatform.h).
+
+            The trace is memory-mapped, i.e. hours of data are not loaded
+            into RAM. Each step moves the clock to the next reading, and
+            calls updateAnalogRead() of every instance (channel). An
+            analogRead() returns the last reading of the pin at the current
+            time, so the polling, the averaging and the delays behave as on
+            the board, only faster. The same trace and library version
+            always give the same output.
+
+            The 32-bit trace times are unwrapped, i.e. any gap below 71.6
+            minutes is allowed.
+*/
+//-----------------------------------------------------------------------------
+class TraceReplay {
+
+public:
+
+    TraceReplay(void) {
+        map_address = nullptr;
+        map_size = 0;
+        records = nullptr;
+        record_count = 0;
+        rewind();
+    }
+
+    ~TraceReplay(void) {
+        close();
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Maps a trace file, installs the analogRead() provider, and sets
+             the virtual clock to the first reading. Call before the
+             begin() of the instances, so their timers start there.
+     @param  path
+             Trace file name.
+     @return true if the file is a valid trace.
+     */
+    //-------------------------------------------------------------------------
+    bool open(const char *path) {
+
+        close();
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat file_stat;
+        if (fstat(fd, &file_stat) != 0 || file_stat.st_size < (off_t) sizeof(TraceHeaderType_t)) {
+            ::close(fd);
+            return false;
+        }
+        map_size = file_stat.st_size;
+        void *address = mmap(nullptr, map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (address == MAP_FAILED) {
+            map_size = 0;
+            return false;
+        }
+        map_address = address;
+
+        const TraceHeaderType_t *header = (const TraceHeaderType_t *) map_address;
+        if (memcmp(header->magic, TRACE_MAGIC, sizeof(header->magic)) != 0 ||
+                header->format != TRACE_FORMAT ||
+                header->record_size != sizeof(TraceRecordType_t)) {
+            close();
+            return false;
+        }
+        records = (const TraceRecordType_t *) ((const uint8_t *) map_address + sizeof(*header));
+        record_count = (map_size - sizeof(*header)) / sizeof(TraceRecordType_t);
+        madvise(map_address, map_size, MADV_SEQUENTIAL);
+
+        rewind();
+        HostPlatform.setClockProvider(nullptr, nullptr);
+        HostPlatform.setDelayProvider(nullptr, nullptr);
+        HostPlatform.setAnalogReadProvider(&TraceReplay::analogReadProvider, this);
+        if (record_count > 0) {
+            HostPlatform.setTime(records[0].us_time);
+        }
+        return true;
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Unmaps the trace, and removes the analogRead() provider.
+     */
+    //-------------------------------------------------------------------------
+    void close(void) {
+
+        if (map_address != nullptr) {
+            HostPlatform.setAnalogReadProvider(nullptr, nullptr);
+            munmap(map_address, map_size);
+        }
+        map_address = nullptr;
+        map_size = 0;
+        records = nullptr;
+        record_count = 0;
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Starts over at the first reading (the clock is not moved).
+     */
+    //-------------------------------------------------------------------------
+    void rewind(void) {
+        position = 0;
+        us_time_base = 0;
+        previous_us_time = 0;
+        memset(pin_code, 0, sizeof(pin_code));
+        memset(updated_flag, 0, sizeof(updated_flag));
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Moves the clock to the next reading (unless a delay already
+             passed it), and updates all instances.
+     @return false at the end of the trace.
+     */
+    //-------------------------------------------------------------------------
+    bool step(void) {
+
+        if (position >= record_count) {
+            return false;
+        }
+        uint64_t us_next_time = unwrapTime(records[position].us_time);
+        if (us_next_time > HostPlatform.getVirtualTime()) {
+            HostPlatform.setTime(us_next_time);
+        }
+        consume();
+
+        for (uint16_t id = 1; id <= MAX_CHANNELS; id++) {
+            SensorWLED *pSensor = SensorWLED::getChannel(id);
+            updated_flag[id] = (pSensor != nullptr) && pSensor->updateAnalogRead();
+        }
+        return true;
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Replays the rest of the trace.
+     @param  on_step
+             Called after each step (e.g. to log the outputs), or nullptr.
+     @param  context
+             Passed to 'on_step'.
+     @return Number of steps.
+     */
+    //-------------------------------------------------------------------------
+    uint32_t run(void (*on_step)(void *context) = nullptr, void *context = nullptr) {
+
+        uint32_t step_count = 0;
+        while (step()) {
+            step_count++;
+            if (on_step != nullptr) {
+                on_step(context);
+            }
+        }
+        return step_count;
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Checks if an instance has a new value after the last step.
+     @param  id
+             Channel id of the instance.
+     @return true if updateAnalogRead() returned true.
+     */
+    //-------------------------------------------------------------------------
+    bool isUpdated(uint16_t id) {
+        return (id <= MAX_CHANNELS) ? updated_flag[id] : false;
+    }
+
+    size_t getRecordCount(void) { return record_count; }   ///< Readings in the trace
+    size_t getPosition(void) { return position; }          ///< Readings replayed
+
+private:
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  The 64-bit time of a trace time, after the last consumed one.
+     */
+    //-------------------------------------------------------------------------
+    uint64_t unwrapTime(uint32_t us_time) {
+        uint64_t us_base = us_time_base;
+        if (position > 0 && us_time < previous_us_time) {
+            us_base += 1ULL << 32;
+        }
+        return us_base + us_time;
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Applies all readings up to the current time to the pins.
+     */
+    //-------------------------------------------------------------------------
+    void consume(void) {
+
+        uint64_t us_now = HostPlatform.getVirtualTime();
+        while (position < record_count) {
+            const TraceRecordType_t &rRecord = records[position];
+            uint64_t us_time = unwrapTime(rRecord.us_time);
+            if (us_time > us_now) {
+                break;
+            }
+            us_time_base = us_time - rRecord.us_time;
+            previous_us_time = rRecord.us_time;
+            pin_code[rRecord.pin] = rRecord.code;
+            position++;
+        }
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Called by analogRead(), after any delays moved the clock.
+     */
+    //-------------------------------------------------------------------------
+    static uint16_t analogReadProvider(uint8_t pin, void *context) {
+        TraceReplay *pReplay = static_cast<TraceReplay *>(context);
+        pReplay->consume();
+        return pReplay->pin_code[pin];
+    }
+
+    void *map_address;                  ///< Mapped trace file
+    size_t map_size;                    ///< Mapped size (bytes)
+    const TraceRecordType_t *records;   ///< First reading
+    size_t record_count;                ///< Readings in the trace
+    size_t position;                    ///< Next reading to apply
+    uint64_t us_time_base;              ///< Unwrapped time of the 32-bit zero
+    uint32_t previous_us_time;          ///< Trace time of the last reading
+    uint16_t pin_code[256];             ///< Last reading per pin
+    bool updated_flag[MAX_CHANNELS + 1];///< New value per channel id, last step
+};
+/* class TraceReplay */
+
+#endif  // ARDUINO
+
+#endif /* HOSTREPLAY_H_ */
@@ -0,0 +1,224 @@
+/*!
+ * @file HostSignal.h
+ *
+ * This is part of SensorWLED library for the Arduino platform.
+ * Source: https://github.com/berrak/SensorWLED
+ *
+ * The MIT license.
+ *
+ */
+#ifndef HOSTSIGNAL_H_
+#define HOSTSIGNAL_H_
+
+#ifndef ARDUINO     // Host only, an analogRead() provider of HostPlatform.h
+
+#include "SensorWLED.h"
+
+//-----------------------------------------------------------------------------
+/*!
+    @brief  The shape of a synthetic LED strip current signal, as the
+            voltage (mV) at the ADC pin, e.g. of a shunt amplifier.
+*/
+//-----------------------------------------------------------------------------
+typedef struct {
+    float mv_idle;              ///< Quiescent current of the pixels (mV)
+    float mv_full;              ///< All pixels white at full brightness (mV)
+    uint16_t ms_effect_time;    ///< Effect frame time, a new level each frame
+    float effect_depth;         ///< Effect level spread, 0: steady, 1: 0 to full
+    uint16_t ms_ramp_time;      ///< Brightness ramp up and down time, 0: none
+    float hz_pwm;               ///< Pixel PWM frequency (e.g. 400 to 2000 Hz)
+    float pwm_ripple;           ///< PWM ripple, part of the level (0 to 1)
+    float spike_rate;           ///< Current spikes per second (e.g. data bursts)
+    float mv_spike;             ///< Spike height (mV)
+    uint16_t us_spike_time;     ///< Spike width (microseconds)
+    float mv_noise;             ///< Noise, RMS (mV)
+    float hz_tone;              ///< Sine tone frequency, e.g. an ADC test signal
+    float mv_tone;              ///< Sine tone amplitude (mV), 0: none
+} SignalDataType_t;
+
+//-----------------------------------------------------------------------------
+/*!
+    @brief  Synthetic WLED strip current signal, for tuning the poll, hold
+            and decay parameters, and for benchmarks, without a strip.
+
+            The signal is a function of the time and the pin, i.e. no
+            state. The same seed and time always give the same code, the
+            channels (pins) differ by their own random effect levels and
+            noise. The signal is the sum of:
+
+            - the idle level, plus the effect level times the brightness,
+            - effect steps, a random level each effect frame,
+            - a triangular brightness ramp,
+            - PWM ripple, a square wave around the level,
+            - short spikes at random times,
+            - a sine tone, e.g. to measure the effective bits,
+            - noise (approximately Gaussian).
+
+            The voltage is converted to a code of the ADC resolution, and
+            clipped, as by a real ADC.
+*/
+//-----------------------------------------------------------------------------
+class SignalGenerator {
+
+public:
+
+    SignalGenerator(void) {
+        SignalParams = {};
+        mv_maxvoltage_adc = mv_vcc_3v3;
+        bits_resolution_adc = bits12;
+        random_seed = 0;
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Sets the signal shape and the ADC to simulate.
+     @param  rSignalParams
+             The signal shape.
+     @param  bits
+             ADC resolution (max code).
+     @param  mv_vcc
+             ADC maximum input voltage (mV).
+     @param  seed
+             Random seed, different seeds give different signals.
+     */
+    //-------------------------------------------------------------------------
+    void begin(SignalDataType_t const &rSignalParams, AdcResolutionType_e bits,
+                                    VoltageVccType_e mv_vcc, uint32_t seed = 1) {
+        SignalParams = rSignalParams;
+        bits_resolution_adc = bits;
+        mv_maxvoltage_adc = mv_vcc;
+        random_seed = seed;
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Makes this signal the analogRead() of all pins, on the host
+             clock.
+     */
+    //-------------------------------------------------------------------------
+    void install(void) {
+        HostPlatform.setAnalogReadProvider(&SignalGenerator::analogReadProvider, this);
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  The signal voltage of a pin.
+     @param  us_time
+             Time (microseconds).
+     @param  pin
+             Analog pin, each pin has its own random levels and noise.
+     @return Voltage (mV), not clipped.
+     */
+    //-------------------------------------------------------------------------
+    float getVoltage(uint64_t us_time, uint8_t pin = 0) {
+
+        uint32_t seed = random_seed ^ (pin * 0x9E3779B9UL);
+        float level = 1.0f;
+
+        // Effect steps, a new random level each frame
+        if (SignalParams.ms_effect_time > 0) {
+            uint64_t frame = us_time / (SignalParams.ms_effect_time * 1000ULL);
+            level -= SignalParams.effect_depth * uniform(seed, frame, 1);
+        }
+
+        // Brightness ramps up, and down
+        if (SignalParams.ms_ramp_time > 0) {
+            uint64_t us_ramp_time = SignalParams.ms_ramp_time * 1000ULL;
+            uint64_t us_phase = us_time % (2 * us_ramp_time);
+            if (us_phase >= us_ramp_time) {
+                us_phase = 2 * us_ramp_time - us_phase;
+            }
+            level *= (float) us_phase / us_ramp_time;
+        }
+
+        // PWM ripple, the pixels are on part of each period
+        if (SignalParams.hz_pwm > 0) {
+            double cycles = us_time * (SignalParams.hz_pwm / 1e6);
+            float duty = (level < 1.0f) ? level : 1.0f;
+            float phase = cycles - (uint64_t) cycles;
+            level *= 1.0f + SignalParams.pwm_ripple * ((phase < duty) ? 1 - duty : -duty);
+        }
+
+        float mv_value = SignalParams.mv_idle + level * (SignalParams.mv_full - SignalParams.mv_idle);
+
+        // Spikes, each spike-wide time slot has the same chance of a spike
+        if (SignalParams.spike_rate > 0 && SignalParams.us_spike_time > 0) {
+            uint64_t slot = us_time / SignalParams.us_spike_time;
+            float chance = SignalParams.spike_rate * SignalParams.us_spike_time / 1e6f;
+            if (uniform(seed, slot, 2) < chance) {
+                mv_value += SignalParams.mv_spike;
+            }
+        }
+
+        // Sine tone, the phase in double for long runs
+        if (SignalParams.mv_tone > 0) {
+            mv_value += SignalParams.mv_tone * sin(2 * M_PI * SignalParams.hz_tone * (us_time / 1e6));
+        }
+
+        // Noise, the sum of four uniform values (Irwin-Hall), RMS scaled
+        if (SignalParams.mv_noise > 0) {
+            float sum = uniform(seed, us_time, 3) + uniform(seed, us_time, 4) +
+                            uniform(seed, us_time, 5) + uniform(seed, us_time, 6);
+            mv_value += (sum - 2.0f) * 1.7320508f * SignalParams.mv_noise;
+        }
+        return mv_value;
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  The signal as a raw ADC code.
+     @param  us_time
+             Time (microseconds).
+     @param  pin
+             Analog pin.
+     @return Code, 0 to the ADC resolution.
+     */
+    //-------------------------------------------------------------------------
+    uint16_t getCode(uint64_t us_time, uint8_t pin = 0) {
+
+        float code = getVoltage(us_time, pin) * bits_resolution_adc / mv_maxvoltage_adc;
+        if (code <= 0) {
+            return 0;
+        }
+        return (code >= bits_resolution_adc) ? (uint16_t) bits_resolution_adc : (uint16_t) (code + 0.5f);
+    }
+
+    SignalDataType_t SignalParams;      ///< The signal shape
+
+private:
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Called by analogRead(), at the host time.
+     */
+    //-------------------------------------------------------------------------
+    static uint16_t analogReadProvider(uint8_t pin, void *context) {
+        return static_cast<SignalGenerator *>(context)->getCode(HostPlatform.getTime(), pin);
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  A random value from a hash (splitmix64) of the seed, the
+             index, and the stream, i.e. no generator state.
+     @return Uniform random value, 0 to 1.
+     */
+    //-------------------------------------------------------------------------
+    static float uniform(uint32_t seed, uint64_t index, uint32_t stream) {
+
+        uint64_t x = index + ((uint64_t) seed << 32) + stream * 0xD1B54A32D192ED03ULL;
+        x += 0x9E3779B97F4A7C15ULL;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        x ^= x >> 31;
+        return (x >> 40) * (1.0f / (1UL << 24));
+    }
+
+    AdcResolutionType_e bits_resolution_adc;    ///< Max code of the ADC
+    VoltageVccType_e mv_maxvoltage_adc;         ///< ADC maximum input voltage
+    uint32_t random_seed;                       ///< Seed of all random parts
+};
+/* class SignalGenerator */
+
+#endif  // ARDUINO
+
+#endif /* HOSTSIGNAL_H_ */
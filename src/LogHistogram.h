@@ -0,0 +1,153 @@
+/*!
+ * @file LogHistogram.h
+ *
+ * This is part of SensorWLED library for the Arduino platform.
+ * Source: https://github.com/berrak/SensorWLED
+ *
+ * The MIT license.
+ *
+ */
+#ifndef LOGHISTOGRAM_H_
+#define LOGHISTOGRAM_H_
+
+#include <stdint.h>
+#include <string.h>
+
+//-----------------------------------------------------------------------------
+/*!
+    @brief  Fixed-memory histogram of 16-bit raw ADC codes, with
+            logarithmic buckets, for quantile estimates.
+
+            Codes below 2^SUB_BITS have one bucket each. Above, each
+            power-of-two range is split into 2^SUB_BITS buckets, i.e. the
+            bucket width is at most 1/2^SUB_BITS of the code. Adding a code
+            is constant work. When a bucket count would overflow, all
+            counts are halved, so old readings fade out.
+*/
+//-----------------------------------------------------------------------------
+template <uint8_t SUB_BITS>
+class LogHistogram {
+
+    static_assert(SUB_BITS >= 1 && SUB_BITS <= 8, "Use 1 to 8 sub-bucket bits");
+
+public:
+
+    /** Number of buckets, for all 16-bit codes */
+    static constexpr uint16_t BUCKETS = (16 - SUB_BITS + 1) << SUB_BITS;
+
+    LogHistogram(void) {
+        reset();
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Removes all counts.
+     */
+    //-------------------------------------------------------------------------
+    void reset(void) {
+        memset(counts, 0, sizeof(counts));
+        total_count = 0;
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Counts a code.
+     @param  code
+             Raw ADC code.
+     */
+    //-------------------------------------------------------------------------
+    void add(uint16_t code) {
+
+        uint16_t bucket = bucketIndex(code);
+        if (counts[bucket] == UINT16_MAX) {
+            halve();
+        }
+        counts[bucket]++;
+        total_count++;
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Estimates a quantile, with linear interpolation in the bucket.
+     @param  q
+             Quantile, 0.0 to 1.0 (e.g. 0.95).
+     @return The code at the quantile, or 0 without counts.
+     */
+    //-------------------------------------------------------------------------
+    double quantile(double q) {
+
+        if (total_count == 0) {
+            return 0;
+        }
+        q = (q < 0) ? 0 : (q > 1) ? 1 : q;
+
+        double rank = q * total_count;
+        uint32_t below = 0;
+        for (uint16_t bucket = 0; bucket < BUCKETS; bucket++) {
+            if (counts[bucket] > 0 && below + counts[bucket] >= rank) {
+                double fraction = (rank - below) / counts[bucket];
+                return bucketStart(bucket) + fraction * bucketWidth(bucket);
+            }
+            below += counts[bucket];
+        }
+        return bucketStart(BUCKETS - 1) + bucketWidth(BUCKETS - 1);
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Number of counted codes (after halving, if any).
+     @return Counts in all buckets.
+     */
+    //-------------------------------------------------------------------------
+    uint32_t getCount(void) const {
+        return total_count;
+    }
+
+private:
+
+    /** The bucket of a code */
+    static uint16_t bucketIndex(uint16_t code) {
+
+        if (code < (1U << SUB_BITS)) {
+            return code;
+        }
+        uint8_t msb = 31 - __builtin_clz(code);
+        uint8_t shift = msb - SUB_BITS;
+        return ((shift + 1) << SUB_BITS) + ((code >> shift) & ((1U << SUB_BITS) - 1));
+    }
+
+    /** The first code of a bucket */
+    static uint32_t bucketStart(uint16_t bucket) {
+
+        if (bucket < (1U << SUB_BITS)) {
+            return bucket;
+        }
+        uint8_t shift = (bucket >> SUB_BITS) - 1;
+        return ((1U << SUB_BITS) + (bucket & ((1U << SUB_BITS) - 1))) << shift;
+    }
+
+    /** The number of codes in a bucket */
+    static uint32_t bucketWidth(uint16_t bucket) {
+
+        if (bucket < (1U << SUB_BITS)) {
+            return 1;
+        }
+        return 1U << ((bucket >> SUB_BITS) - 1);
+    }
+
+    /** Halves all counts, keeps the distribution shape */
+    void halve(void) {
+
+        total_count = 0;
+        for (uint16_t bucket = 0; bucket < BUCKETS; bucket++) {
+            counts[bucket] >>= 1;
+            total_count += counts[bucket];
+        }
+    }
+
+    uint16_t counts[BUCKETS];           ///< Codes per bucket
+    uint32_t total_count;               ///< Sum of all bucket counts
+};
+/* class LogHistogram */
+
+#endif /* LOGHISTOGRAM_H_ */
@@ -0,0 +1,137 @@
+/*!
+ * @file SampleQueue.h
+ *
+ * This is part of SensorWLED library for the Arduino platform.
+ * Source: https://github.com/berrak/SensorWLED
+ *
+ * The MIT license.
+ *
+ */
+#ifndef SAMPLEQUEUE_H_
+#define SAMPLEQUEUE_H_
+
+#include <atomic>
+#include <stdint.h>
+
+//-----------------------------------------------------------------------------
+/*!
+    @brief  Lock-free single-producer/single-consumer ring buffer of raw
+            ADC codes.
+
+            The producer (e.g. a timer ISR) calls push(), and the consumer
+            (the loop()) calls pop(). Each index is written by one side
+            only, so no locks or interrupt masking are needed. A sample
+            pushed into a full queue is dropped and counted.
+
+            push() is always inlined, so on the ESP32/ESP8266 its code is
+            in IRAM when the calling ISR is IRAM_ATTR (as pushSample()),
+            i.e. it runs while the flash cache is disabled. Call it only
+            from an IRAM_ATTR function there.
+*/
+//-----------------------------------------------------------------------------
+template <uint16_t SIZE>
+class SampleQueue {
+
+    static_assert(SIZE > 1 && (SIZE & (SIZE - 1)) == 0, "Size must be a power of two");
+
+public:
+
+    SampleQueue(void) : head_index(0), tail_index(0), overflow_count(0) {}
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Copies the queued samples and the counter, e.g. when a sensor
+             instance is copied. Not while the producer or consumer runs.
+     */
+    //-------------------------------------------------------------------------
+    SampleQueue(SampleQueue const &rOther) : SampleQueue() {
+        *this = rOther;
+    }
+
+    SampleQueue &operator=(SampleQueue const &rOther) {
+
+        for (uint16_t cnt = 0; cnt < SIZE; cnt++) {
+            buffer[cnt] = rOther.buffer[cnt];
+        }
+        head_index.store(rOther.head_index.load(std::memory_order_acquire), std::memory_order_relaxed);
+        tail_index.store(rOther.tail_index.load(std::memory_order_acquire), std::memory_order_relaxed);
+        overflow_count.store(rOther.getOverflowCount(), std::memory_order_relaxed);
+        return *this;
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Adds a sample (producer side only), inlined into the caller.
+     @param  code
+             Raw ADC code.
+     @return False if the queue is full, and the sample is dropped.
+     */
+    //-------------------------------------------------------------------------
+    __attribute__((always_inline)) bool push(uint16_t code) {
+
+        uint32_t head = head_index.load(std::memory_order_relaxed);
+        uint32_t tail = tail_index.load(std::memory_order_acquire);
+
+        if (head - tail >= SIZE) {
+            // Only the producer writes the counter
+            overflow_count.store(overflow_count.load(std::memory_order_relaxed) + 1,
+                                                    std::memory_order_relaxed);
+            return false;
+        }
+        buffer[head & (SIZE - 1)] = code;
+        head_index.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Removes the oldest sample (consumer side only).
+     @param  code
+             Receives the raw ADC code.
+     @return False if the queue is empty.
+     */
+    //-------------------------------------------------------------------------
+    bool pop(uint16_t &code) {
+
+        uint32_t tail = tail_index.load(std::memory_order_relaxed);
+        uint32_t head = head_index.load(std::memory_order_acquire);
+
+        if (head == tail) {
+            return false;
+        }
+        code = buffer[tail & (SIZE - 1)];
+        tail_index.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Number of queued samples (a snapshot).
+     @return Samples in the queue.
+     */
+    //-------------------------------------------------------------------------
+    uint16_t available(void) const {
+        return head_index.load(std::memory_order_acquire) -
+                            tail_index.load(std::memory_order_acquire);
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Number of samples dropped since start, since the queue was full.
+     @return Dropped samples.
+     */
+    //-------------------------------------------------------------------------
+    uint32_t getOverflowCount(void) const {
+        return overflow_count.load(std::memory_order_relaxed);
+    }
+
+private:
+
+    uint16_t buffer[SIZE];                  ///< Raw ADC codes
+    std::atomic<uint32_t> head_index;       ///< Next write (producer)
+    std::atomic<uint32_t> tail_index;       ///< Next read (consumer)
+    std::atomic<uint32_t> overflow_count;   ///< Dropped samples (producer)
+};
+/* class SampleQueue */
+
+#endif /* SAMPLEQUEUE_H_ */
@@ -0,0 +1,272 @@
+/*!
+ * @file SensorArray.h
+ *
+ * This is part of SensorWLED library for the Arduino platform.
+ * Source: https://github.com/berrak/SensorWLED
+ *
+ * The MIT license.
+ *
+ */
+#ifndef SENSORARRAY_H_
+#define SENSORARRAY_H_
+
+#include "SensorWLED.h"
+
+//-----------------------------------------------------------------------------
+/*!
+    @brief  Track instant and peak values for many ADC channels.
+
+            Each channel has the same peak and decay behavior as a
+            SensorWLED instance, but all state is kept in contiguous arrays
+            (structure-of-arrays). One update() call reads the time once,
+            decays the peaks of all channels, and makes at most one ADC
+            conversion, for the next due channel in round-robin order.
+
+            Calibration uses integer (Q16.16) math, with the scale and the
+            slope folded into one factor per channel. The values are not
+            truncated to whole millivolts, as with map() in SensorWLED.
+            Averaging, storage in EEPROM, and the envelope follower
+            (envelope_decay) are not supported.
+*/
+//-----------------------------------------------------------------------------
+template <uint8_t CHANNELS>
+class SensorArray {
+
+    static_assert(CHANNELS > 0 && CHANNELS <= 32, "Use 1 to 32 channels");
+
+public:
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Creates an array without channels.
+     */
+    //-------------------------------------------------------------------------
+    SensorArray(void) {
+        channel_count = 0;
+        next_channel = 0;
+        previous_decay_millis_tm = 0;
+        zero_hold_flag = false;
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Adds an ADC channel, and sets its pin to INPUT.
+
+     @param  analog_pin
+             ADC analog input pin
+     @param  rDynamicParams
+             Takes a DynamicDataType_t' structure with the channel parameters.
+     @param  mv_offset
+             ADC zero offset compensation (mV)
+     @param  slope
+             Adjust deviation of read ADC value
+     @return The channel index, or -1 if all channels are used, or the
+             decay model is envelope_decay.
+     */
+    //-------------------------------------------------------------------------
+    int16_t addChannel(uint16_t analog_pin, DynamicDataType_t const &rDynamicParams,
+                                        float mv_offset = 0.0, float slope = 1.0) {
+
+        if (channel_count >= CHANNELS) {
+            return -1;
+        }
+
+        // Only the hold-time models, the decay table of envelope_decay is 1.0
+        if (rDynamicParams.decay_model == envelope_decay) {
+#ifndef ARDUINO
+            PLOG_WARNING << "SensorArray has no envelope_decay, pin: " << analog_pin;
+#endif
+            return -1;
+        }
+        uint8_t ch = channel_count++;
+
+        if (slope <= 0) {
+            slope = 1.0;
+        }
+        if (mv_offset < 0) {
+            mv_offset = 0.0;
+        }
+
+        pin[ch] = analog_pin;
+        ms_poll_time[ch] = rDynamicParams.ms_poll_time;
+        ms_hold_time[ch] = rDynamicParams.ms_hold_time;
+        zero_hold_flag |= (rDynamicParams.ms_hold_time == 0);
+
+        // Scale (mV per ADC code) and slope, folded into one factor
+        q16_gain[ch] = lround((double) rDynamicParams.mv_maxvoltage_adc /
+                        rDynamicParams.bits_resolution_adc * slope * Q16_ONE);
+        q16_cal_zero_offset[ch] = lround(mv_offset * Q16_ONE);
+
+        float decay_rate = SensorWLED::validateDecayRate(rDynamicParams.decay_model,
+                                                        rDynamicParams.decay_rate);
+        SensorWLED::generateDecayTable(q16_decay_table[ch],
+                                        rDynamicParams.decay_model, decay_rate);
+
+        previous_poll_millis_tm[ch] = 0;
+        previous_hold_millis_tm[ch] = 0;
+        raw_input_value[ch] = 0;
+        pk_raw_input_value[ch] = 0;
+        mapped_input_value[ch] = 0;
+        pk_mapped_input_value[ch] = 0;
+
+        pinMode(analog_pin, INPUT);
+        return ch;
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Call continously (in loop()) for updated values.
+     @return Bit mask of the channels with a new value (bit 0 is channel 0).
+     */
+    //-------------------------------------------------------------------------
+    uint32_t update(void) {
+
+        // One timestamp for all channels
+        uint32_t current_millis = millis();
+
+        // Decay the peak values, depending on the hold time. The hold times
+        // are whole milliseconds, so once per millisecond (unless zero).
+        uint8_t decay_count = channel_count;
+        if (current_millis == previous_decay_millis_tm && !zero_hold_flag) {
+            decay_count = 0;
+        }
+        previous_decay_millis_tm = current_millis;
+
+        for (uint8_t ch = 0; ch < decay_count; ch++) {
+            uint32_t elapsed_millis = current_millis - previous_hold_millis_tm[ch];
+            if (elapsed_millis >= ms_hold_time[ch]) {
+                uint32_t hold_periods = 1;
+                if (ms_hold_time[ch] > 0) {
+                    hold_periods = elapsed_millis / ms_hold_time[ch];
+                }
+                previous_hold_millis_tm[ch] += hold_periods * ms_hold_time[ch];
+                pk_raw_input_value[ch] = SensorWLED::applyDecayTable(q16_decay_table[ch],
+                                            pk_raw_input_value[ch], hold_periods);
+            }
+        }
+
+        // Round-robin, convert the first due channel
+        for (uint8_t cnt = 0; cnt < channel_count; cnt++) {
+            uint8_t ch = next_channel;
+            next_channel = (next_channel + 1 == channel_count) ? 0 : next_channel + 1;
+
+            if (current_millis - previous_poll_millis_tm[ch] >= ms_poll_time[ch]) {
+                previous_poll_millis_tm[ch] = current_millis;
+                readChannel(ch);
+                return (uint32_t) 1 << ch;
+            }
+        }
+        return 0;
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Copies all instant values (mV) into 'values'.
+     @param  values
+             Array with room for getChannelCount() values.
+     */
+    //-------------------------------------------------------------------------
+    void getMappedValues(double *values) {
+        for (uint8_t ch = 0; ch < channel_count; ch++) {
+            values[ch] = (double) mapped_input_value[ch] / Q16_ONE;
+        }
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Copies all peak values (mV) into 'values'.
+     @param  values
+             Array with room for getChannelCount() values.
+     */
+    //-------------------------------------------------------------------------
+    void getMappedPeakValues(double *values) {
+        for (uint8_t ch = 0; ch < channel_count; ch++) {
+            values[ch] = (double) pk_mapped_input_value[ch] / Q16_ONE;
+        }
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  The instant value of one channel.
+     @param  ch
+             Channel index.
+     @return The mapped instantanous analog value (mV).
+     */
+    //-------------------------------------------------------------------------
+    double getMappedValue(uint8_t ch) {
+        return (double) mapped_input_value[ch] / Q16_ONE;
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  The peak value of one channel.
+     @param  ch
+             Channel index.
+     @return The mapped peak analog value (mV).
+     */
+    //-------------------------------------------------------------------------
+    double getMappedPeakValue(uint8_t ch) {
+        return (double) pk_mapped_input_value[ch] / Q16_ONE;
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Gets the number of added channels.
+     @return Channels added.
+     */
+    //-------------------------------------------------------------------------
+    uint8_t getChannelCount(void) {
+        return channel_count;
+    }
+
+private:
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Reads, calibrates, and updates the peak value for one channel.
+     @param  ch
+             Channel index.
+     */
+    //-------------------------------------------------------------------------
+    void readChannel(uint8_t ch) {
+
+        uint32_t raw_value = analogRead(pin[ch]);
+        raw_input_value[ch] = raw_value;
+
+        int64_t mv_value = (int64_t) raw_value * q16_gain[ch] - q16_cal_zero_offset[ch];
+        if (mv_value < 0) {
+            mv_value = 0;
+        }
+        mapped_input_value[ch] = (int32_t) mv_value;
+
+        if (raw_value >= pk_raw_input_value[ch]) {
+            pk_raw_input_value[ch] = raw_value;
+            pk_mapped_input_value[ch] = mapped_input_value[ch];
+        }
+    }
+
+    uint8_t channel_count;                      ///< Number of added channels
+    uint8_t next_channel;                       ///< Next round-robin channel
+    uint32_t previous_decay_millis_tm;          ///< Time of the last decay check
+    bool zero_hold_flag;                        ///< A channel decays each update()
+
+    // Channel state, structure-of-arrays
+    uint32_t previous_poll_millis_tm[CHANNELS]; ///< Holds previous ADC poll time
+    uint32_t previous_hold_millis_tm[CHANNELS]; ///< Holds previous ADC hold time
+    uint32_t raw_input_value[CHANNELS];         ///< ADC raw input at bits capability
+    uint32_t pk_raw_input_value[CHANNELS];      ///< ADC peak input at bits capability
+    int32_t mapped_input_value[CHANNELS];       ///< ADC values mapped (Q16.16 mV)
+    int32_t pk_mapped_input_value[CHANNELS];    ///< ADC peak mapped (Q16.16 mV)
+
+    // Channel setup, structure-of-arrays
+    uint16_t pin[CHANNELS];                     ///< ADC microcontroller input pin
+    uint16_t ms_poll_time[CHANNELS];            ///< Instant poll time (milliseconds)
+    uint16_t ms_hold_time[CHANNELS];            ///< Sample hold time (milliseconds)
+    int32_t q16_gain[CHANNELS];                 ///< mV per ADC code times slope (Q16.16)
+    int32_t q16_cal_zero_offset[CHANNELS];      ///< ADC zero offset (Q16.16 mV)
+    uint32_t q16_decay_table[CHANNELS][DECAY_TABLE_SIZE]; ///< Decay factor^n (Q16.16)
+
+};
+/* class SensorArray */
+
+#endif /* SENSORARRAY_H_ */
@@ -27,6 +27,60 @@
 // Secondly, include required declarations for this class interface (only).
 #include "SensorWLED.h"
 
+
+#if !defined(PROGMEM)
+    #define PROGMEM
+#endif
+#if !defined(pgm_read_dword)
+    #define pgm_read_dword(addr) (*(const uint32_t *)(addr))
+#endif
+
+//-----------------------------------------------------------------------------
+/*!
+    @brief  CRC32 tables for slicing-by-8, generated at compile time.
+            Table 0 is the byte-wise table, table k is table 0 advanced
+            by k zero bytes.
+*/
+//-----------------------------------------------------------------------------
+struct CRC32TableType_t {
+
+    uint32_t table[CRC32_SLICES][CRC32_TABLE_SIZE];  ///< Tables, one per slice
+
+    constexpr CRC32TableType_t() : table() {
+        for (uint32_t i = 0; i < CRC32_TABLE_SIZE; i++) {
+            uint32_t c = i;
+            for (size_t j = 0; j < 8; j++) {
+                c = (c & 1) ? (0xEDB88320 ^ (c >> 1)) : (c >> 1);
+            }
+            table[0][i] = c;
+        }
+        for (uint32_t i = 0; i < CRC32_TABLE_SIZE; i++) {
+            for (size_t k = 1; k < CRC32_SLICES; k++) {
+                uint32_t c = table[k-1][i];
+                table[k][i] = (c >> 8) ^ table[0][c & 0xFF];
+            }
+        }
+    }
+};
+
+// Placed in flash (PROGMEM on ESP8266), not generated on the stack
+static const CRC32TableType_t crc32_tables PROGMEM = CRC32TableType_t();
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Reads one CRC32 table entry from flash.
+
+ @param  slice
+         The slicing-by-8 table (0..7).
+ @param  index
+         Table index (0..255).
+ @return The table entry.
+ */
+//-----------------------------------------------------------------------------
+static inline uint32_t crc32Table(size_t slice, uint32_t index) {
+    return pgm_read_dword(&crc32_tables.table[slice][index]);
+}
+
 //-----------------------------------------------------------------------------
 /*!
  @brief  Sets up the static 'eeprom_offset'-array which hold each instance
@@ -39,24 +93,101 @@
  Adjust deviation of read ADC value
  @param samples
  Number of samples for smoothing ADC values
+ @param window
+ Number of polls in the moving average (max 'MAX_WINDOW_SIZE')
  */
 //-----------------------------------------------------------------------------
-SensorWLED::SensorWLED(uint16_t analog_pin, float mv_offset, float slope, uint16_t samples ){
+SensorWLED::SensorWLED(uint16_t analog_pin, float mv_offset, float slope, 
+                                            uint16_t samples, uint16_t window ){
 
     float tmp_slope = 1.0;
     float tmp_mv_offset = 0.0;
 
     previous_poll_millis_tm = 0;
     previous_hold_millis_tm = 0;
+    previous_sample_micros_tm = 0;
+
+    accumulated_raw_value = 0;
+    accumulated_count = 0;
 
     raw_input_value = 0;
     mapped_input_value = 0;
     pk_raw_input_value = 0; 
     pk_mapped_input_value = 0;
 
+    q16_cal_slope = Q16_ONE;
+    q16_cal_zero_offset = 0;
+    for (uint16_t cnt = 0; cnt < DECAY_TABLE_SIZE; cnt++) {
+        q16_decay_table[cnt] = 0;
+    }
+    for (uint16_t cnt = 0; cnt < ENVELOPE_TABLE_SIZE; cnt++) {
+        q30_attack_table[cnt] = 0;
+        q30_release_table[cnt] = 0;
+    }
+    q16_envelope_value = 0;
+    previous_envelope_us_tm = 0;
+    envelope_started_flag = false;
+
+    decimation_log2_ratio = 0;
+    decimation_extra_bits = 0;
+
+    reading_tap = nullptr;
+    reading_tap_context = nullptr;
+
+#if SENSOR_MOVING_WINDOW
+    window_sum = 0;
+    window_sq_sum = 0;
+    window_head = 0;
+    window_fill = 0;
+    window_max_first = 0;
+    window_max_count = 0;
+    window_min_first = 0;
+    window_min_count = 0;
+#endif
+
+    stats_sums = {0, 0, 0, UINT16_MAX, 0, 0, 0};
+    stats_last_sums = {0, 0, 0, 0, 0, 0, 0};
+
+    trigger_count = 0;
+#if SENSOR_TRIGGERS
+    trigger_previous_flag = false;
+    trigger_event_first = 0;
+    trigger_event_count = 0;
+#endif
+
+#if SENSOR_CAPTURE
+    capture_trigger = -1;
+    capture_fill = -1;
+    capture_ready = -1;
+    capture_read = -1;
+    capture_sequence = 0;
+    capture_overrun_count = 0;
+#endif
+
+    Integral = {0, 0};
+    previous_integral_millis_tm = 0;
+    previous_integral_value = 0;
+    integral_started_flag = false;
+    checkpoint_minutes = 0;
+    previous_checkpoint_millis_tm = 0;
+
+    block_us_tm = 0;
+    previous_block_t0_us = 0;
+    block_started_flag = false;
+
     cal_crc32 = 0;
     dyn_crc32 = 0;
 
+    channel_id = 0;
+    mux_select = nullptr;
+    mux_channel = 0;
+
+    CalibrationPoints = {};
+    cal_table_status = cal_table_none;
+    us_cal_table_build_time = 0;
+
+    resetInstrumentation();
+
     DynamicParams = {};
 
     if(slope > 0) {
@@ -67,7 +198,15 @@ SensorWLED::SensorWLED(uint16_t analog_pin, float mv_offset, float slope, uint16
         tmp_mv_offset = mv_offset;
     }
 
-    CalibrationData = {analog_pin, samples, US_ADC_CONVERSION_TIME, tmp_mv_offset, tmp_slope};
+    if (window > MAX_WINDOW_SIZE) {
+        window = MAX_WINDOW_SIZE;
+    }
+#if !SENSOR_MOVING_WINDOW
+    window = 0;
+#endif
+
+    CalibrationData = {analog_pin, samples, US_ADC_CONVERSION_TIME, 
+                                            tmp_mv_offset, tmp_slope, window};
 
 }
 
@@ -78,6 +217,14 @@ SensorWLED::SensorWLED(uint16_t analog_pin, float mv_offset, float slope, uint16
 //-----------------------------------------------------------------------------
 SensorWLED::~SensorWLED(void) {
     pinMode(CalibrationData.analog_pin, INPUT);
+
+    // Frees the channel id, by address, as a copy has the id of the original
+    for (uint16_t id = 1; id <= MAX_CHANNELS; id++) {
+        if (channel_registry[id] == this) {
+            channel_registry[id] = nullptr;
+            instance_counter--;
+        }
+    }
 }
 
 
@@ -101,456 +248,2550 @@ SensorWLED::~SensorWLED(void) {
 //-----------------------------------------------------------------------------
 void SensorWLED::begin(DynamicDataType_t const &UserDynamicParams){
 
-float tmp_decay_rate = 1.0;
+    INSTRUMENT(uint32_t us_start_time = micros());
 
     DynamicParams.bits_resolution_adc = UserDynamicParams.bits_resolution_adc;
     DynamicParams.mv_maxvoltage_adc = UserDynamicParams.mv_maxvoltage_adc;
     DynamicParams.ms_poll_time = UserDynamicParams.ms_poll_time;
     DynamicParams.ms_hold_time = UserDynamicParams.ms_hold_time;
     DynamicParams.decay_model = UserDynamicParams.decay_model;
+    DynamicParams.acquisition_mode = UserDynamicParams.acquisition_mode;
+    DynamicParams.ms_attack_time = UserDynamicParams.ms_attack_time;
+    DynamicParams.ms_release_time = UserDynamicParams.ms_release_time;
 
-    if (UserDynamicParams.decay_rate > 0) {
-        tmp_decay_rate = UserDynamicParams.decay_rate;
-    }
-    DynamicParams.decay_rate = tmp_decay_rate;
+    DynamicParams.decay_rate = validateDecayRate(UserDynamicParams.decay_model,
+                                                UserDynamicParams.decay_rate);
 
     setAnalogPin(CalibrationData.analog_pin, INPUT); // analog input to ADC
 
     // Common for all instances - changes only with revison changes
-    VersionType_t TmpVersion = readVersionEEPROM();
     if (eeprom_version_written_flag == false) {
-        writeVersionEEPROM();
+        VersionType_t TmpVersion = readVersionEEPROM();
+        if (TmpVersion.magic_id != EEPROM_ID || TmpVersion.major_version != VERSION_MAJOR || 
+            TmpVersion.minor_version != VERSION_MINOR || TmpVersion.patch_version != VERSION_PATCH) {
+            writeVersionEEPROM();
+        }
         eeprom_version_written_flag = true;
-    } else if (TmpVersion.magic_id != EEPROM_ID || TmpVersion.major_version != VERSION_MAJOR || 
-        TmpVersion.minor_version != VERSION_MINOR || TmpVersion.patch_version != VERSION_PATCH) {
-        writeVersionEEPROM();
     }
     
     // CRC32 checks minimize flash writes (i.e. emulated EEPROM).
-    uint32_t table[CRC32_TABLE_SIZE];
-    generateTableCRC32(table);
+    cal_crc32 = calculateCalibrationDataCRC32(CalibrationData);
+    dyn_crc32 = calculateDynamicParamsCRC32(DynamicParams);
 
 
-    // CRC32 for 'CalibrationData'
-    char *ptrcal = (char *) &CalibrationData;
-    uint16_t slen1 = sizeof(CalibrationData);
-    uint32_t crc1 = 0;
-    // Step bytewise, piece-meal through the members in the structure
-    for (uint16_t cnt = 0; cnt < slen1; cnt++) {
-        crc1 = updateCRC32(table, crc1, ptrcal, 1);
-        ptrcal++;
-    }
-    cal_crc32 = crc1;
-
-    // CRC32 for 'DynamicParams'
-    char *ptrdyn = (char *) &DynamicParams;
-    uint16_t slen2 = sizeof(DynamicParams);
-    uint32_t crc2 = 0;
-    // Step bytewise, piece-meal through the members in the structure
-    for (uint16_t cnt = 0; cnt < slen2; cnt++) {
-        crc2 = updateCRC32(table, crc2, ptrdyn, 1);
-        ptrdyn++;
+    // The channel id is kept if begin() is called again, a copy gets its own
+    if (channel_registry[channel_id] != this && registerChannel()) {
+        // Continues a checkpointed energy/charge integral
+        config_store.read(integrator_record, channel_id, &Integral, sizeof(Integral));
+        INSTRUMENT(Instrumentation.eeprom_read_count++);
     }
-    dyn_crc32 = crc2;
 
+    // Each instance (ADC channel) has it own EEPROM records for calibration data
+    // Each instance (ADC channel) has it own EEPROM records for static/dynamic data
+    // Changes are staged, and committed (once for all instances) with 
+    // commitEEPROM() or at the first updateAnalogRead() call.
+    writeCalibrationEEPROM(channel_id, cal_crc32);
+    writeDynamicEEPROM(channel_id, dyn_crc32);
+    writeCalibrationPointsEEPROM(channel_id, calculateCalibrationPointsCRC32(CalibrationPoints));
+
+    // The decimated codes have more bits, for the mapping and the triggers
+    uint8_t adc_bits = 32 - __builtin_clz(DynamicParams.bits_resolution_adc);
+    decimator.setup(decimation_log2_ratio, decimation_extra_bits, adc_bits);
+    accumulated_raw_value = 0;
+    accumulated_count = 0;
+
+    // At the decimated code scale, and before the trigger codes
+    buildCalibrationTable();
+
+    setFixedPointParams();
+    setDecayTable();
+    setEnvelopeTables();
+#if SENSOR_TRIGGERS
+    setTriggerCodes();
+#endif
 
-    // Each instance (ADC channel) has it own EEPROM area for calibration data
-    // Each instance (ADC channel) has it own EEPROM area for static/dynamic data
-    instance_counter++;
-    writeCalibrationEEPROM(instance_counter, cal_crc32);
-    writeDynamicEEPROM(instance_counter, dyn_crc32);
+    INSTRUMENT(Instrumentation.us_begin_time = micros() - us_start_time);
 }
 
 //-----------------------------------------------------------------------------
 /*!
- @brief  Call continously (in loop()) for updated values.
- @return Returns true when a new value is available.
+ @brief  Converts the calibration parameters to Q16.16 once, so that 
+         polls (with 'FIXED_POINT_MATH') use integer math only.
  */
 //-----------------------------------------------------------------------------
-bool SensorWLED::updateAnalogRead(void) {
+void SensorWLED::setFixedPointParams(void) {
 
-    // Check to see if it's time to read from the analog input
-    uint32_t current_millis = millis();
+    q16_cal_slope = lround(CalibrationData.cal_slope * Q16_ONE);
+    q16_cal_zero_offset = lround(CalibrationData.cal_zero_offset * Q16_ONE);
+}
 
-    //
-    // Decay the peak value, depending on the hold time (not the poll time)
-    //
-    if (current_millis - previous_hold_millis_tm >= DynamicParams.ms_hold_time) {
-        pk_raw_input_value = applyDecay(pk_raw_input_value);
-        // Remember the time
-        previous_hold_millis_tm = current_millis; 
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Sets a piecewise-linear calibration, i.e. the true input voltage
+         at some ADC readings, e.g. to correct the nonlinear ESP32 ADC near
+         the rails. It replaces the slope and zero offset calibration. 
+         begin() stores the points, and expands them into a table with 
+         the value of each code, so a mapping is one indexed load.
+
+ @param  pPoints
+         Reference points, in any order.
+ @param  count
+         Number of points, 2 to MAX_CAL_POINTS, or 0 to remove them.
+ @return true if set, false if the codes are not unique, or the voltages
+         decrease with the codes.
+ */
+//-----------------------------------------------------------------------------
+bool SensorWLED::setCalibrationPoints(const CalibrationPointType_t *pPoints, uint8_t count) {
 
+    if (count == 0) {
+        CalibrationPoints = {};
+        return true;
+    }
+    if (pPoints == nullptr || count < 2 || count > MAX_CAL_POINTS) {
+        return false;
     }
 
-    //
-    // Get a new input value (poll time)
-    //
-    if (current_millis - previous_poll_millis_tm >= DynamicParams.ms_poll_time) {
-        // Remember the time
-        previous_poll_millis_tm = current_millis;           
-
-        // The first ADC reading
-        raw_input_value = analogRead(CalibrationData.analog_pin);  
-
-        // Map raw input value to resolution range (without smoothing)
-        if (CalibrationData.sample_count == 0) {
-        mapped_input_value = (double) map(raw_input_value, 0,
-                DynamicParams.bits_resolution_adc, 0, DynamicParams.mv_maxvoltage_adc);
-        
-        // or apply smooting with a fixed rate not to jeopardize the ADC conversion cycle          
-        } else {
-
-            // Initial short delay before additional ADC inpt readings
-            delayMicroseconds(CalibrationData.sample_period);
-
-            for (int cnt=1; cnt < CalibrationData.sample_count; cnt++) {
-                    raw_input_value += analogRead(CalibrationData.analog_pin);
-                    delayMicroseconds(CalibrationData.sample_period);
-            }
-            
-            mapped_input_value = (double) map(raw_input_value/CalibrationData.sample_count, 0,
-                               DynamicParams.bits_resolution_adc, 0, DynamicParams.mv_maxvoltage_adc);
-        }
-        
-        // Apply slope calibration compensation -----
-        mapped_input_value *= CalibrationData.cal_slope ;
-
-        // Apply zero offset compensation -----
-        if (CalibrationData.cal_zero_offset <= mapped_input_value) {
-        	mapped_input_value -= CalibrationData.cal_zero_offset;
-        } else {
-        	mapped_input_value = 0;
+    // Insertion sort by the code
+    CalibrationPointsType_t SortedPoints = {};
+    for (uint8_t cnt = 0; cnt < count; cnt++) {
+        CalibrationPointType_t Point = {pPoints[cnt].mv_value, pPoints[cnt].raw_value, 0};
+        uint8_t pos = cnt;
+        while (pos > 0 && SortedPoints.Points[pos - 1].raw_value > Point.raw_value) {
+            SortedPoints.Points[pos] = SortedPoints.Points[pos - 1];
+            pos--;
         }
+        SortedPoints.Points[pos] = Point;
+    }
 
-        // Updates our peak values, if greater than last time
-        if (raw_input_value >= pk_raw_input_value) {
-            pk_raw_input_value = raw_input_value;
-            pk_mapped_input_value = mapped_input_value;
+    // A monotonic mapping, as the triggers search for threshold codes
+    for (uint8_t cnt = 1; cnt < count; cnt++) {
+        if (SortedPoints.Points[cnt].raw_value <= SortedPoints.Points[cnt - 1].raw_value ||
+                SortedPoints.Points[cnt].mv_value < SortedPoints.Points[cnt - 1].mv_value) {
+            return false;
         }
-        return true;
     }
-    return false;
+
+    SortedPoints.point_count = count;
+    CalibrationPoints = SortedPoints;
+    return true;
 }
 
 //-----------------------------------------------------------------------------
 /*!
- @brief  Map the input analog value to a value optimized for actual
- capability of the controllers ADC and suppl voltage.
+ @brief  Expands the calibration points into a table of the mapped value 
+         of each native ADC code, or shares the table of another channel
+         with the same points and resolution. Without points, the table is
+         released. Above MAX_CAL_TABLE_BITS, or without memory for the 
+         table, each mapping interpolates the points.
+ */
+//-----------------------------------------------------------------------------
+void SensorWLED::buildCalibrationTable(void) {
+
+    uint32_t us_start_time = micros();
+    calibration_table.release();
+
+    if (CalibrationPoints.point_count < 2) {
+        cal_table_status = cal_table_none;
+    } else if (DynamicParams.bits_resolution_adc > (1UL << MAX_CAL_TABLE_BITS) - 1) {
+        cal_table_status = cal_table_interpolated;
+    } else if (!calibration_table.build(CalibrationPoints, DynamicParams.bits_resolution_adc)) {
+        cal_table_status = cal_table_no_memory;
+#ifndef ARDUINO
+        PLOG_WARNING << "No memory for the calibration table, instance: " << channel_id;
+#endif
+    } else {
+        cal_table_status = calibration_table.isShared() ? cal_table_shared : cal_table_built;
+    }
+    us_cal_table_build_time = micros() - us_start_time;
+}
 
- @return The mapped instantanous analog value.
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Gets the memory of the multi-point calibration table.
 
+ @return Table size (bytes), 0 without calibration points.
  */
 //-----------------------------------------------------------------------------
-double SensorWLED::getMappedValue(void) {
-    return mapped_input_value;
-
+size_t SensorWLED::getCalibrationTableSize(void) {
+    return calibration_table.getSize();
 }
 
 //-----------------------------------------------------------------------------
 /*!
- @brief  Map the input analog value to a value optimized for actual
- capability of the controllers ADc and suppl voltage.
-
- @return The mapped peak analog value.
+ @brief  Gets the time begin() took to build the calibration table.
 
+ @return Build time (microseconds).
  */
 //-----------------------------------------------------------------------------
-double SensorWLED::getMappedPeakValue(void) {
-    return pk_mapped_input_value;
+uint32_t SensorWLED::getCalibrationTableBuildTime(void) {
+    return us_cal_table_build_time;
 }
 
 //-----------------------------------------------------------------------------
 /*!
- @brief  Applies the decay model to peak value.
+ @brief  Gets how begin() set up the multi-point calibration, e.g. to 
+         check that the table fit in memory.
 
- @param  peak_value
- Value to decay with set model, rate and times.
- @return The reduced, decayed input peak value.
+ @return The table status, cal_table_none without calibration points.
+ */
+//-----------------------------------------------------------------------------
+CalibrationTableStatusType_e SensorWLED::getCalibrationTableStatus(void) {
+    return cal_table_status;
+}
 
+//-----------------------------------------------------------------------------
+/*!
+ @brief  The largest raw code, i.e. the ADC resolution, with the extra 
+         decimation bits if any. A code scaled by the extra bits maps to
+         the same voltage.
+ @return The full scale code.
  */
 //-----------------------------------------------------------------------------
-uint32_t SensorWLED::applyDecay(uint32_t peak_value) {
+uint32_t SensorWLED::getCodeMax(void) {
+    return (uint32_t) DynamicParams.bits_resolution_adc << decimator.getExtraBits();
+}
 
-    // FIXME: sanity checks, in particular linear must be < 1!
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Precomputes the decay factor for 0..DECAY_TABLE_SIZE-1 elapsed 
+         hold periods in Q16.16, i.e. no exp() calls when polling.
+ */
+//-----------------------------------------------------------------------------
+void SensorWLED::setDecayTable(void) {
+    generateDecayTable(q16_decay_table, DynamicParams.decay_model, DynamicParams.decay_rate);
+}
 
-    if (DynamicParams.decay_model == linear_decay) {
-        return (peak_value * DynamicParams.decay_rate);
-    }
-    else if (DynamicParams.decay_model == exponential_decay) {
-        return (peak_value * exp(-DynamicParams.decay_rate));
-    }
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Precomputes the envelope attack and release factors, i.e. no 
+         exp() calls per reading.
+ */
+//-----------------------------------------------------------------------------
+void SensorWLED::setEnvelopeTables(void) {
+    generateEnvelopeTable(q30_attack_table, DynamicParams.ms_attack_time);
+    generateEnvelopeTable(q30_release_table, DynamicParams.ms_release_time);
+}
 
-    return 0;
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Call continously (in loop()) for updated values.
+ @return Returns true when a new value is available.
+ */
+//-----------------------------------------------------------------------------
+bool SensorWLED::updateAnalogRead(void) {
+
+    return pollAnalogRead(
+        [this](uint32_t raw_value) { return mapRawValue(raw_value); },
+        [this](uint32_t peak_value, uint32_t hold_periods) {
+            return applyDecay(peak_value, hold_periods);
+        });
 }
 
 //-----------------------------------------------------------------------------
 /*!
- @brief  Saves static 'Version' struct to EEPROM.
-         Writes to fixed EEPROM address, common for all instances.
+ @brief  Reads the ADC input according to the set acquisition mode.
 
- @return true if EEPROM written.
+ @param  current_millis
+         The time of this call, used for the poll time.
+ @return Returns true when a new (averaged) 'raw_input_value' is available.
+         This includes the moving average, if 'window_size' is set.
  */
 //-----------------------------------------------------------------------------
-bool SensorWLED::writeVersionEEPROM(void)
-{
-    bool is_written = false;
+bool SensorWLED::acquireRawValue(uint32_t current_millis) {
 
-// The check to 'require' a new write to Version EEPROM is done in the call
-#ifdef ARDUINO
-        EEPROM.begin(sizeof(Version));
-        EEPROM.put(EEPROM_IDSTART, Version);
-        EEPROM.commit();
-        EEPROM.end();
-        is_written = true;
+    bool is_acquired = false;
 
+    // Samples are pushed by an ISR, drain them (includes moving average)
+    if (DynamicParams.acquisition_mode == interrupt_driven) {
+#if SENSOR_SAMPLE_QUEUE
+        return acquireQueuedSamples();
 #else
-    PLOG_INFO << "EEPROM Version (common) WRITE at: " << EEPROM_IDSTART;
-    is_written = true;
+        return false;
 #endif
+    }
 
-    return is_written;
+    // An incremental averaging window, once started, runs to completion
+    if ((CalibrationData.sample_count > 1 || decimator.isEnabled()) &&
+                DynamicParams.acquisition_mode == incremental_average) {
+        is_acquired = acquireIncrementalAverage(current_millis);
+
+    } else if (current_millis - previous_poll_millis_tm >= DynamicParams.ms_poll_time) {
+        // Remember the time
+        previous_poll_millis_tm = current_millis;
+
+        // Use the raw input value (without smoothing)
+        if (CalibrationData.sample_count == 0 && decimator.isEnabled() == false) {
+            raw_input_value = readADC();
+            is_acquired = true;
+        } else {
+            is_acquired = acquireBlockingAverage();
+        }
+    }
+
+    // Statistics and triggers, the moving average, the peak, and the quantiles
+    if (is_acquired) {
+        trackReading(current_millis);
+    }
+
+    return is_acquired;
 }
 
 //-----------------------------------------------------------------------------
 /*!
- @brief  Memory load of EEPROM Id and Pgm version, and returns the information.
-         This use a fixed EEPROM address, common for all instances.
-
- @return The Version struct data.         
+ @brief  Reads all 'sample_count' ADC samples in one call. Apply smoothing 
+         with a fixed rate not to jeopardize the ADC conversion cycle.
 
+ @return Returns true when 'raw_input_value' is updated.
  */
 //-----------------------------------------------------------------------------
-VersionType_t SensorWLED::readVersionEEPROM(void) {
+bool SensorWLED::acquireBlockingAverage(void) {
 
-#ifdef ARDUINO
-    EEPROM.begin(sizeof(Version));
-    EEPROM.get(EEPROM_IDSTART, Version);
-    EEPROM.end();
-#else
-    PLOG_INFO << "EEPROM Version (common) READ at: " << EEPROM_IDSTART;
-#endif
+    // A decimation ratio of samples, for the next filter output
+    if (decimator.isEnabled()) {
+        bool is_acquired = false;
+        for (uint16_t cnt = 0; cnt < decimator.getRatio(); cnt++) {
+            is_acquired = accumulateSample(readADC());
+            delayMicroseconds(CalibrationData.sample_period);
+        }
+        return is_acquired;
+    }
+
+    // The first ADC reading
+    uint32_t sum_input_value = readADC();
 
-return Version;
+    // Initial short delay before additional ADC inpt readings
+    delayMicroseconds(CalibrationData.sample_period);
+
+    for (int cnt=1; cnt < CalibrationData.sample_count; cnt++) {
+            sum_input_value += readADC();
+            delayMicroseconds(CalibrationData.sample_period);
+    }
+
+    raw_input_value = sum_input_value / CalibrationData.sample_count;
+    return true;
 }
 
 //-----------------------------------------------------------------------------
 /*!
-@brief  Saves static 'CalibrationData' struct to EEPROM.
-
-@param instance  
-       The actual instance (ADC channel) for which the data belongs to.      
-
-@param crc32  
-       The calculated CRC32 sum for the struct to be written. 
+ @brief  Takes at most one ADC sample per call, spaced at least 
+         'sample_period' apart, and accumulates into a running sum. The
+         averaging window starts at the poll time.
 
-@return Boolean (true) value when data is written.
+ @param  current_millis
+         The time of this call, used for the poll time.
+ @return Returns true when all 'sample_count' samples are averaged.
  */
 //-----------------------------------------------------------------------------
-bool SensorWLED::writeCalibrationEEPROM(uint16_t instance, uint32_t crc32)
-{
-    bool is_written = false;
+bool SensorWLED::acquireIncrementalAverage(uint32_t current_millis) {
 
-    // CRC32 checks minimize flash writes (i.e. emulated EEPROM).
-    uint32_t table[CRC32_TABLE_SIZE];
-    generateTableCRC32(table);
-    CalibrationDataType_t StoredCalibrationData = readCalibrationEEPROM(instance);
-    
-    // CRC32 for existing 'CalibrationData'
-    char *ptrcal = (char *) &StoredCalibrationData;
-    uint16_t slen1 = sizeof(StoredCalibrationData);
-    uint32_t oldcrc = 0;
-    // Step bytewise, piece-meal through the members in the structure
-    for (uint16_t cnt = 0; cnt < slen1; cnt++) {
-        oldcrc = updateCRC32(table, oldcrc, ptrcal, 1);
-        ptrcal++;
+    // Start a new averaging window at the poll time
+    if (accumulated_count == 0) {
+        if (current_millis - previous_poll_millis_tm < DynamicParams.ms_poll_time) {
+            return false;
+        }
+        previous_poll_millis_tm = current_millis;
+
+        bool is_acquired = accumulateSample(readADC());
+        previous_sample_micros_tm = micros();
+        return is_acquired;
     }
-    
-    if(oldcrc != crc32) {
 
-        #ifdef ARDUINO                                                       
-                EEPROM.begin(sizeof(CalibrationData));
-                EEPROM.put(eeprom_area[instance], CalibrationData);
-                EEPROM.commit();
-                EEPROM.end();
-                is_written = true;
-        #else
-            PLOG_INFO << "EEPROM CalibrationData WRITE at: " << eeprom_area[instance];
-            is_written = true;
-        #endif
+    // Not to jeopardize the ADC conversion cycle
+    uint32_t current_micros = micros();
+    if (current_micros - previous_sample_micros_tm < CalibrationData.sample_period) {
+        return false;
     }
+    previous_sample_micros_tm = current_micros;
 
-    return is_written;
+    return accumulateSample(readADC());
 }
 
+#if SENSOR_SAMPLE_QUEUE
 //-----------------------------------------------------------------------------
 /*!
- @brief  Memory load of EEPROM 'CalibrationData', and returns the struct.
+ @brief  Drains the samples pushed by the ISR. Every 'sample_count' 
+         samples (or each sample, without averaging) make one reading. 
+         The peak value tracks all readings, while 'raw_input_value' 
+         holds the last one.
 
- @param instance
- The specified instance for the EEPROM read
-
- @return The CalibrationData struct data.   
+ @return Returns true when at least one new reading is available.
  */
 //-----------------------------------------------------------------------------
-CalibrationDataType_t SensorWLED::readCalibrationEEPROM(uint16_t instance) {
+bool SensorWLED::acquireQueuedSamples(void) {
 
-#ifdef ARDUINO
-    EEPROM.begin(sizeof(CalibrationData));
-    EEPROM.get(eeprom_area[instance], CalibrationData);
-    EEPROM.end();
-#else
-    PLOG_INFO << "EEPROM CalibrationDataREAD at: " << eeprom_area[instance];
-#endif
+    bool is_acquired = false;
+    uint16_t code;
+
+    // The samples have no timestamps, use the drain time
+    uint32_t current_millis = millis();
+
+    while (sample_queue.pop(code)) {
+        if (accumulateSample(code)) {
+            trackReading(current_millis);
+            is_acquired = true;
+        }
+    }
 
-return CalibrationData;
+    return is_acquired;
 }
+#endif
 
 //-----------------------------------------------------------------------------
 /*!
-@brief  Saves static 'DynamicData' struct to EEPROM.
-        
-@param instance  
-       The actual instance (ADC channel) for which the data belongs to.      
-
-@param crc32  
-       The calculated CRC32 sum for the struct to be written. 
-
-@return Boolean (true) value when data is written.
+ @brief  Adds an already converted ADC sample to the running sum. Every
+         'sample_count' samples (or each sample, without averaging) make 
+         one reading. With decimation, every ratio samples make one 
+         filtered reading, with the extra bits.
+
+ @param  code
+         Raw ADC value at bits capability.
+ @return Returns true when 'raw_input_value' holds a new reading.
  */
 //-----------------------------------------------------------------------------
-bool SensorWLED::writeDynamicEEPROM(uint16_t instance, uint32_t crc32)
-{
-    bool is_written = false;
+bool SensorWLED::accumulateSample(uint16_t code) {
 
-    // CRC32 checks minimize flash writes (i.e. emulated EEPROM).
-    uint32_t table[CRC32_TABLE_SIZE];
-    generateTableCRC32(table);
-    DynamicDataType_t StoredDynamicParams = readDynamicEEPROM(instance);
-    
-    // CRC32 for existing 'DynamicParams'
-    char *ptrcal = (char *) &StoredDynamicParams;
-    uint16_t slen1 = sizeof(StoredDynamicParams);
-    uint32_t oldcrc = 0;
-    // Step bytewise, piece-meal through the members in the structure
-    for (uint16_t cnt = 0; cnt < slen1; cnt++) {
-        oldcrc = updateCRC32(table, oldcrc, ptrcal, 1);
-        ptrcal++;
+    if (decimator.isEnabled()) {
+        uint16_t output;
+        // The count follows the filter phase, i.e. it starts a new window
+        if (++accumulated_count >= decimator.getRatio()) {
+            accumulated_count = 0;
+        }
+        if (decimator.add(code, output) == false) {
+            return false;
+        }
+        raw_input_value = output;
+        return true;
     }
-    
-    if(oldcrc != crc32) {    
 
-        #ifdef ARDUINO
-                EEPROM.begin(sizeof(DynamicParams));
-                EEPROM.put(eeprom_area[instance]+sizeof(CalibrationData), DynamicParams);
-                EEPROM.commit();
-                EEPROM.end();
-                is_written = true;
-        #else
-            PLOG_INFO << "EEPROM CalibrationData WRITE at: " << eeprom_area[instance]+sizeof(CalibrationData);
-            is_written = true;
-        #endif
+    if (CalibrationData.sample_count <= 1) {
+        raw_input_value = code;
+        return true;
+    }
 
+    accumulated_raw_value += code;
+    if (++accumulated_count < CalibrationData.sample_count) {
+        return false;
     }
 
-    return is_written;
+    raw_input_value = accumulated_raw_value / CalibrationData.sample_count;
+    accumulated_raw_value = 0;
+    accumulated_count = 0;
+    return true;
 }
 
 //-----------------------------------------------------------------------------
 /*!
- @brief  Memory load of EEPROM 'DynamicData', and returns the struct.
- @param instance
- The specified instance for the EEPROM read
- @return The DynamicData struct data.   
+ @brief  Applies the moving average to a new 'raw_input_value' reading,
+         and updates the peak value, and the quantile histograms. The 
+         per-reading path of all acquisition modes.
+
+ @param  reading_millis
+         The time of the reading.
+ @param  reading_frac_us
+         Microseconds after 'reading_millis', for the envelope follower.
  */
 //-----------------------------------------------------------------------------
-DynamicDataType_t SensorWLED::readDynamicEEPROM(uint16_t instance) {
+void SensorWLED::trackReading(uint32_t reading_millis, uint16_t reading_frac_us) {
 
-#ifdef ARDUINO
-    EEPROM.begin(sizeof(DynamicParams));
-    EEPROM.get(eeprom_area[instance]+sizeof(CalibrationData), DynamicParams);
-    EEPROM.end();
-#else
-    PLOG_INFO << "EEPROM CalibrationData READ at: " << eeprom_area[instance]+sizeof(CalibrationData);
+    processReading(raw_input_value, reading_millis);
+
+#if SENSOR_MOVING_WINDOW
+    if (CalibrationData.window_size > 0) {
+        updateWindow(raw_input_value);
+        raw_input_value = window_sum / window_fill;
+    }
 #endif
 
-return DynamicParams;
+    if (DynamicParams.decay_model == envelope_decay) {
+        updateEnvelope(raw_input_value, reading_millis * 1000 + reading_frac_us);
+    } else if (raw_input_value >= pk_raw_input_value) {
+        pk_raw_input_value = raw_input_value;
+        pk_mapped_input_value = mapRawValue(raw_input_value);
+    }
+
+#if SENSOR_QUANTILES
+    updateHistograms();
+#endif
 }
 
 //-----------------------------------------------------------------------------
 /*!
- @brief  Sets the analog pin for ADC input on the microcontroller.
-
- @param  a_pin
-         Pin number for analog readings on the microcontroller.
- @param  mode
-         Arduino pin mode for analog input.
+ @brief  Processes a block of already converted ADC samples, e.g. from 
+         the ESP32 continuous (DMA) ADC mode, in one call. The result is 
+         the same as for one call per sample. The samples are taken at
+         t0_us, t0_us + dt_us, and so on. The peak decays with the hold 
+         time on this time line (in milliseconds, i.e. t/1000). The block
+         times may wrap, as micros(), and the hold time and the integral
+         continue across.
+
+ @param  codes
+         Raw ADC values at bits capability.
+ @param  n
+         Number of samples.
+ @param  t0_us
+         Time of the first sample (microseconds).
+ @param  dt_us
+         Time between samples (microseconds).
+ @return Returns true when at least one new reading is available.
  */
 //-----------------------------------------------------------------------------
-void SensorWLED::setAnalogPin(uint16_t a_pin, uint16_t mode) {
-    pinMode(a_pin, mode);
+bool SensorWLED::processBlock(const uint16_t* codes, size_t n, uint32_t t0_us, 
+                                                                uint32_t dt_us) {
+    bool is_acquired = false;
+    // Milliseconds of the unwrapped time, i.e. they wrap as millis()
+    uint64_t block_us = unwrapBlockTime(t0_us);
+    uint32_t t0_millis = (uint32_t) (block_us / 1000);
+    uint32_t t0_frac_us = block_us % 1000;
+    size_t cnt = 0;
+
+    while (cnt < n) {
+
+        // Decay the peak value, at the time of this sample
+        uint32_t current_millis = t0_millis + 
+                        (uint32_t) ((t0_frac_us + (uint64_t) cnt * dt_us) / 1000);
+        uint32_t hold_periods = elapsedHoldPeriods(current_millis);
+        if (hold_periods > 0) {
+            pk_raw_input_value = applyDecay(pk_raw_input_value, hold_periods);
+        }
+
+        // The samples up to the next decay make one segment
+        size_t end = n;
+        if (DynamicParams.ms_hold_time == 0) {
+            end = cnt + 1;
+        } else if (dt_us > 0) {
+            uint32_t next_hold_millis = previous_hold_millis_tm + DynamicParams.ms_hold_time;
+            int64_t next_hold_us = (int64_t) (next_hold_millis - t0_millis) * 1000 - t0_frac_us;
+            uint64_t next_cnt = (next_hold_us > 0) ? (next_hold_us + dt_us - 1) / dt_us : 0;
+            if (next_cnt < end) {
+                end = (next_cnt > cnt) ? next_cnt : cnt + 1;
+            }
+        }
+
+        is_acquired |= processSegment(codes + cnt, end - cnt, t0_millis,
+                                    t0_frac_us + (uint64_t) cnt * dt_us, dt_us);
+        cnt = end;
+    }
+
+    if (is_acquired) {
+        updateMappedValues();
+
+        // Integrated at the time of the last sample, on the unwrapped time line
+        uint64_t t_last_us = block_us + (uint64_t) (n - 1) * dt_us;
+        integrateValue((uint32_t) (t_last_us / 1000));
+    }
+    return is_acquired;
 }
 
 //-----------------------------------------------------------------------------
 /*!
-@brief Gets the total number of created instances.
-
-@return Instances created.
+ @brief  Maps a block start time, from the 32-bit micros() that wraps every
+         71.6 minutes, to a 64-bit time line. The unsigned difference to the
+         previous block start is exact across the wraparound, for blocks 
+         less than 71.6 minutes apart. The first block starts at t0_us.
+
+ @param  t0_us
+         Time of the first sample of the block (microseconds).
+ @return The unwrapped time (microseconds).
  */
 //-----------------------------------------------------------------------------
-uint16_t SensorWLED::getInstanceNumber(void) {
-    return instance_counter;
+uint64_t SensorWLED::unwrapBlockTime(uint32_t t0_us) {
+
+    if (block_started_flag) {
+        block_us_tm += (uint32_t) (t0_us - previous_block_t0_us);
+    } else {
+        block_us_tm = t0_us;
+        block_started_flag = true;
+    }
+    previous_block_t0_us = t0_us;
+    return block_us_tm;
 }
 
 //-----------------------------------------------------------------------------
 /*!
- @brief  Generate 32 bit CRC table.
-
- @param  table
-         The table that will be populated for CRC32 calculations.
+ @brief  Processes samples without a decay between them. Without averaging,
+         moving average, or triggers, only the max and the last sample 
+         matter, i.e. a tight loop the compiler can vectorize.
+
+ @param  codes
+         Raw ADC values at bits capability.
+ @param  n
+         Number of samples (> 0).
+ @param  t0_millis
+         Block start time (milliseconds).
+ @param  t_us
+         Time of the first sample, after 't0_millis' (microseconds).
+ @param  dt_us
+         Time between samples (microseconds).
+ @return Returns true when at least one new reading is available.
  */
 //-----------------------------------------------------------------------------
-void SensorWLED::generateTableCRC32(uint32_t(&table)[CRC32_TABLE_SIZE]) {
-
-    uint32_t polynomial = 0xEDB88320;
-    for (uint32_t i = 0; i < CRC32_TABLE_SIZE; i++)
-    {
-        uint32_t c = i;
-        for (size_t j = 0; j < 8; j++)
-        {
-            if (c & 1) {
-                c = polynomial ^ (c >> 1);
-            }
-            else {
-                c >>= 1;
+bool SensorWLED::processSegment(const uint16_t* codes, size_t n, uint32_t t0_millis,
+                                                    uint64_t t_us, uint32_t dt_us) {
+
+    if (CalibrationData.sample_count > 1 || CalibrationData.window_size > 0 ||
+            trigger_count > 0 || DynamicParams.decay_model == envelope_decay ||
+            decimator.isEnabled() || reading_tap != nullptr) {
+        bool is_acquired = false;
+        for (size_t cnt = 0; cnt < n; cnt++) {
+            if (accumulateSample(codes[cnt])) {
+                uint64_t sample_us = t_us + (uint64_t) cnt * dt_us;
+                trackReading(t0_millis + (uint32_t) (sample_us / 1000), sample_us % 1000);
+                is_acquired = true;
             }
         }
-        table[i] = c;
+        return is_acquired;
+    }
+
+    uint16_t max_code = 0;
+    for (size_t cnt = 0; cnt < n; cnt++) {
+        max_code = (codes[cnt] > max_code) ? codes[cnt] : max_code;
+    }
+
+    updateStatistics(codes, n);
+#if SENSOR_QUANTILES
+    updateHistograms(codes, n);
+#endif
+
+    raw_input_value = codes[n-1];
+    if (max_code >= pk_raw_input_value) {
+        pk_raw_input_value = max_code;
+        pk_mapped_input_value = mapRawValue(max_code);
     }
+    return true;
 }
 
 //-----------------------------------------------------------------------------
 /*!
- @brief  Calculate 32 bit CRC.
-
+ @brief  Maps 'raw_input_value' to the resolution range, and applies the
+         slope and zero offset calibration.
+ */
+//-----------------------------------------------------------------------------
+void SensorWLED::updateMappedValues(void) {
+    mapped_input_value = mapRawValue(raw_input_value);
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Maps a raw ADC value to the resolution range, and applies the
+         slope and zero offset calibration, or the multi-point calibration.
+
+ @param  raw_value
+         Raw ADC value at bits capability.
+ @return The calibrated value (mV) in Q16.16.
+ */
+//-----------------------------------------------------------------------------
+int32_t SensorWLED::mapRawValue(uint32_t raw_value) {
+
+    // Multi-point calibration, one load from the table of begin()
+    if (calibration_table.isValid()) {
+        return calibration_table.map(raw_value, decimator.getExtraBits());
+    }
+    if (CalibrationPoints.point_count >= 2) {
+        double native_value = (double) raw_value / (1UL << decimator.getExtraBits());
+        return (int32_t) lround(CalibrationTable::interpolate(CalibrationPoints, native_value) * Q16_ONE);
+    }
+
+#if FIXED_POINT_MATH
+    int64_t mv_value;
+    if (decimator.getExtraBits() == 0) {
+        // Same integer result as map() with zero lower bounds
+        mv_value = (int64_t) raw_value * DynamicParams.mv_maxvoltage_adc
+                                                / DynamicParams.bits_resolution_adc;
+        // Apply slope calibration compensation -----
+        mv_value *= q16_cal_slope;
+    } else {
+        // Keeps the fraction (mV) of the extra resolution bits
+        mv_value = ((int64_t) raw_value * DynamicParams.mv_maxvoltage_adc 
+                                                << Q16_SHIFT) / getCodeMax();
+        mv_value = (mv_value * q16_cal_slope) >> Q16_SHIFT;
+    }
+
+    // Apply zero offset compensation -----
+    if (q16_cal_zero_offset <= mv_value) {
+        mv_value -= q16_cal_zero_offset;
+    } else {
+        mv_value = 0;
+    }
+    return (int32_t) mv_value;
+#else
+    double mv_value;
+    if (decimator.getExtraBits() == 0) {
+        mv_value = (double) map(raw_value, 0,
+            DynamicParams.bits_resolution_adc, 0, DynamicParams.mv_maxvoltage_adc);
+    } else {
+        mv_value = (double) raw_value * DynamicParams.mv_maxvoltage_adc / getCodeMax();
+    }
+
+    // Apply slope calibration compensation -----
+    mv_value *= CalibrationData.cal_slope ;
+
+    // Apply zero offset compensation -----
+    if (CalibrationData.cal_zero_offset <= mv_value) {
+        mv_value -= CalibrationData.cal_zero_offset;
+    } else {
+        mv_value = 0;
+    }
+    return (int32_t) lround(mv_value * Q16_ONE);
+#endif
+}
+
+#if SENSOR_MOVING_WINDOW
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Adds a raw reading to the moving average ring buffer, and updates
+         the running sum and moving max queue. Constant work per call 
+         (the max queue is amortized constant).
+
+ @param  raw_value
+         Raw ADC value at bits capability.
+ */
+//-----------------------------------------------------------------------------
+void SensorWLED::updateWindow(uint16_t raw_value) {
+
+    uint16_t size = CalibrationData.window_size;
+
+    // Remove the oldest reading when the window is full
+    if (window_fill == size) {
+        uint16_t oldest = window_buffer[window_head];
+        window_sum -= oldest;
+        window_sq_sum -= (uint32_t) oldest * oldest;
+        if (window_max_count > 0 && window_max_queue[window_max_first] == window_head) {
+            window_max_first = (window_max_first + 1 == size) ? 0 : window_max_first + 1;
+            window_max_count--;
+        }
+        if (window_min_count > 0 && window_min_queue[window_min_first] == window_head) {
+            window_min_first = (window_min_first + 1 == size) ? 0 : window_min_first + 1;
+            window_min_count--;
+        }
+    } else {
+        window_fill++;
+    }
+
+    window_buffer[window_head] = raw_value;
+    window_sum += raw_value;
+    window_sq_sum += (uint32_t) raw_value * raw_value;
+
+    updateWindowQueue(window_max_queue, window_max_first, window_max_count, raw_value, true);
+    updateWindowQueue(window_min_queue, window_min_first, window_min_count, raw_value, false);
+
+    window_head = (window_head + 1 == size) ? 0 : window_head + 1;
+}
+#endif
+
+#if SENSOR_MOVING_WINDOW
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Adds the new reading (at 'window_head') to a moving max, or min, 
+         queue. Readings that can never be the max (min) are dropped, so 
+         the first entry is always the max (min) of the window.
+
+ @param  queue
+         Ring buffer positions, in decreasing (increasing) value order.
+ @param  rFirst
+         First queue entry.
+ @param  rCount
+         Number of queue entries.
+ @param  raw_value
+         The new reading.
+ @param  is_max
+         True for the moving max, false for the moving min.
+ */
+//-----------------------------------------------------------------------------
+void SensorWLED::updateWindowQueue(uint16_t *queue, uint16_t &rFirst, uint16_t &rCount,
+                                            uint16_t raw_value, bool is_max) {
+
+    uint16_t size = CalibrationData.window_size;
+
+    while (rCount > 0) {
+        uint16_t last = rFirst + rCount - 1;
+        if (last >= size) {
+            last -= size;
+        }
+        uint16_t value = window_buffer[queue[last]];
+        if (is_max ? value > raw_value : value < raw_value) {
+            break;
+        }
+        rCount--;
+    }
+    uint16_t next = rFirst + rCount;
+    if (next >= size) {
+        next -= size;
+    }
+    queue[next] = window_head;
+    rCount++;
+}
+#endif
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Adds the trapezoid between the previous and this reading to the
+         integral. The unsigned time difference is exact across the 
+         millis() wraparound. Twice the area is kept, so no bit is lost.
+
+ @param  current_millis
+         The time of this reading.
+ */
+//-----------------------------------------------------------------------------
+void SensorWLED::integrateValue(uint32_t current_millis) {
+
+    if (integral_started_flag) {
+        uint32_t elapsed_millis = current_millis - previous_integral_millis_tm;
+        Integral.q16_area += (uint64_t) ((int64_t) previous_integral_value + 
+                                        mapped_input_value) * elapsed_millis;
+        Integral.ms_elapsed += elapsed_millis;
+    }
+    integral_started_flag = true;
+    previous_integral_millis_tm = current_millis;
+    previous_integral_value = mapped_input_value;
+
+    // Bounded EEPROM write rate, committed by the next updateAnalogRead()
+    if (checkpoint_minutes > 0 && current_millis - previous_checkpoint_millis_tm >= 
+                                            checkpoint_minutes * 60000UL) {
+        previous_checkpoint_millis_tm = current_millis;
+        writeCheckpoint();
+    }
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Stages the integral as a record in the EEPROM log.
+ */
+//-----------------------------------------------------------------------------
+void SensorWLED::writeCheckpoint(void) {
+
+    if (channel_id != 0) {
+        config_store.write(integrator_record, channel_id, &Integral, sizeof(Integral));
+        INSTRUMENT(Instrumentation.eeprom_write_count++);
+    }
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  The integral of the mapped value over time, in value-hours. With
+         the slope calibrated to give mA, this is the charge in mAh.
+
+ @return The integral (mV x h, or mAh).
+ */
+//-----------------------------------------------------------------------------
+double SensorWLED::getCharge(void) {
+    return (double) Integral.q16_area / (2.0 * Q16_ONE * 3600000.0);
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  The energy at a constant supply voltage, i.e. getCharge() times 
+         the voltage. With the slope calibrated to give mA, this is mWh.
+
+ @param  mv_supply
+         The supply voltage (mV).
+ @return The energy (mWh).
+ */
+//-----------------------------------------------------------------------------
+double SensorWLED::getEnergy(float mv_supply) {
+    return getCharge() * mv_supply / 1000.0;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  The integrated time.
+
+ @return Seconds since start, or reset.
+ */
+//-----------------------------------------------------------------------------
+double SensorWLED::getIntegratedSeconds(void) {
+    return Integral.ms_elapsed / 1000.0;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Restarts the integral from zero, also the checkpoint (if enabled).
+ */
+//-----------------------------------------------------------------------------
+void SensorWLED::resetIntegral(void) {
+
+    Integral = {0, 0};
+    if (checkpoint_minutes > 0) {
+        writeCheckpoint();
+    }
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Saves the integral to the EEPROM log every 'minutes', and it is
+         restored by begin() after a restart. Each checkpoint is a flash 
+         commit, so use a long interval (e.g. 60 minutes).
+
+ @param  minutes
+         Checkpoint interval, 0 (default) disables the checkpoints.
+ */
+//-----------------------------------------------------------------------------
+void SensorWLED::setCheckpointInterval(uint16_t minutes) {
+
+    checkpoint_minutes = minutes;
+    previous_checkpoint_millis_tm = millis();
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  The work for each reading, before the moving average: statistics
+         and triggers.
+
+ @param  raw_value
+         Raw ADC value at bits capability.
+ @param  reading_millis
+         The time of the reading.
+ */
+//-----------------------------------------------------------------------------
+void SensorWLED::processReading(uint16_t raw_value, uint32_t reading_millis) {
+
+    updateStatistics(raw_value);
+
+    if (reading_tap != nullptr) {
+        reading_tap(raw_value, reading_millis, reading_tap_context);
+    }
+#if SENSOR_CAPTURE
+    if (capture_trigger >= 0) {
+        captureReading(raw_value, reading_millis);
+    }
+#endif
+#if SENSOR_TRIGGERS
+    if (trigger_count > 0) {
+        evaluateTriggers(raw_value, reading_millis);
+    }
+#endif
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Replaces the averaging ('sample_count') with a CIC filter, 
+         'CIC_ORDER' stages, and a droop compensating FIR. Every 
+         2^log2_ratio samples make one reading, with 'extra_bits' more 
+         resolution, e.g. 14-bit codes from a 12-bit ADC. A noisy input 
+         gives about one more effective bit per four times the ratio. 
+         Call before begin(), which limits the values to 16-bit codes.
+
+ @param  log2_ratio
+         Decimation ratio 2^log2_ratio (e.g. 4: 16 samples), 0: off.
+ @param  extra_bits
+         Resolution above the ADC bits (e.g. 2).
+ */
+//-----------------------------------------------------------------------------
+void SensorWLED::setDecimation(uint8_t log2_ratio, uint8_t extra_bits) {
+
+    decimation_log2_ratio = log2_ratio;
+    decimation_extra_bits = extra_bits;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Passes each reading, before the moving average, to a consumer, 
+         e.g. the BandAnalyzer. Called at the sampling rate, keep it short.
+
+ @param  tap
+         Called with the raw reading, its time, and 'context'. nullptr: off.
+ @param  context
+         Passed to 'tap', e.g. the consumer object.
+ */
+//-----------------------------------------------------------------------------
+void SensorWLED::setReadingTap(void (*tap)(uint16_t raw_value, uint32_t reading_millis,
+                                                    void *context), void *context) {
+    reading_tap = tap;
+    reading_tap_context = context;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Adds a trigger. The thresholds (mV) are converted to raw codes, 
+         so each reading costs a few integer compares per trigger. A 
+         trigger fires when its condition holds for 'ms_min_duration', 
+         and is released when the reading is back inside the hysteresis
+         band. Add the triggers after begin().
+
+ @param  rTrigger
+         Takes a TriggerDataType_t structure with the trigger setup.
+ @return The trigger index, or -1 if MAX_TRIGGERS are used (always 
+         without 'SENSOR_TRIGGERS').
+ */
+//-----------------------------------------------------------------------------
+int16_t SensorWLED::addTrigger(TriggerDataType_t const &rTrigger) {
+#if SENSOR_TRIGGERS
+    if (trigger_count >= MAX_TRIGGERS) {
+        return -1;
+    }
+    uint8_t trigger = trigger_count;
+
+    Triggers[trigger] = rTrigger;
+    if (Triggers[trigger].mv_hysteresis < 0) {
+        Triggers[trigger].mv_hysteresis = 0;
+    }
+    trigger_state[trigger] = trigger_idle;
+    trigger_since_millis_tm[trigger] = 0;
+
+    trigger_count++;
+    setTriggerCodes();
+    return trigger;
+#else
+    (void) rTrigger;
+    return -1;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Removes all triggers, and queued events.
+ */
+//-----------------------------------------------------------------------------
+void SensorWLED::clearTriggers(void) {
+
+    disarmCapture();
+    trigger_count = 0;
+#if SENSOR_TRIGGERS
+    trigger_previous_flag = false;
+    trigger_event_first = 0;
+    trigger_event_count = 0;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Checks if a trigger has fired, and is not released.
+
+ @param  trigger
+         Trigger index.
+ @return true if active.
+ */
+//-----------------------------------------------------------------------------
+bool SensorWLED::isTriggerActive(uint8_t trigger) {
+#if SENSOR_TRIGGERS
+    return trigger < trigger_count && trigger_state[trigger] == trigger_active;
+#else
+    (void) trigger;
+    return false;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Takes the oldest queued event, of the triggers without a callback.
+         A full queue drops new events.
+
+ @param  rEvent
+         Receives the event.
+ @return true if an event was queued.
+ */
+//-----------------------------------------------------------------------------
+bool SensorWLED::readTriggerEvent(TriggerEventType_t &rEvent) {
+#if SENSOR_TRIGGERS
+    if (trigger_event_count == 0) {
+        return false;
+    }
+    rEvent = trigger_events[trigger_event_first];
+    trigger_event_first = (trigger_event_first + 1) % TRIGGER_QUEUE_SIZE;
+    trigger_event_count--;
+    return true;
+#else
+    (void) rEvent;
+    return false;
+#endif
+}
+
+#if SENSOR_TRIGGERS
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Converts the trigger thresholds to raw codes, with the current 
+         resolution and calibration.
+ */
+//-----------------------------------------------------------------------------
+void SensorWLED::setTriggerCodes(void) {
+
+    for (uint8_t trigger = 0; trigger < trigger_count; trigger++) {
+        TriggerDataType_t const &rTrigger = Triggers[trigger];
+
+        if (rTrigger.type == slope_trigger) {
+            // Steps, i.e. raw code differences, from the gain only. The zero
+            // offset cancels in a difference (and mapRawValue() clamps at 0).
+            float mv_per_code = (float) DynamicParams.mv_maxvoltage_adc / 
+                                        getCodeMax() * CalibrationData.cal_slope;
+            if (calibration_table.isValid() || CalibrationPoints.point_count >= 2) {
+                // The mean gain of the multi-point calibration
+                mv_per_code = (float) (mapRawValue(getCodeMax()) - mapRawValue(0)) / 
+                                                        Q16_ONE / getCodeMax();
+            }
+            float mv_step = fabsf(rTrigger.mv_threshold);
+            float mv_release = (mv_step > rTrigger.mv_hysteresis) ? 
+                                    mv_step - rTrigger.mv_hysteresis : 0;
+            if (mv_per_code > 0) {
+                trigger_on_code[trigger] = (uint32_t) ceilf(mv_step / mv_per_code);
+                trigger_off_code[trigger] = (uint32_t) ceilf(mv_release / mv_per_code);
+            } else {
+                trigger_on_code[trigger] = getCodeMax() + 1;
+                trigger_off_code[trigger] = getCodeMax() + 1;
+            }
+            continue;
+        }
+
+        trigger_on_code[trigger] = thresholdCode(rTrigger.mv_threshold);
+        if (rTrigger.type == falling_trigger) {
+            trigger_off_code[trigger] = thresholdCode(rTrigger.mv_threshold + rTrigger.mv_hysteresis);
+        } else if (rTrigger.type == rising_trigger) {
+            trigger_off_code[trigger] = thresholdCode(rTrigger.mv_threshold - rTrigger.mv_hysteresis);
+        } else {
+            trigger_off_code[trigger] = thresholdCode(rTrigger.mv_threshold + rTrigger.mv_hysteresis);
+            trigger_high_on_code[trigger] = thresholdCode(rTrigger.mv_threshold_high);
+            trigger_high_off_code[trigger] = thresholdCode(rTrigger.mv_threshold_high - 
+                                                            rTrigger.mv_hysteresis);
+        }
+    }
+}
+#endif
+
+#if SENSOR_TRIGGERS
+//-----------------------------------------------------------------------------
+/*!
+ @brief  The smallest raw code that maps to at least 'mv_value', i.e. the
+         same result as comparing mapped values.
+
+ @param  mv_value
+         Threshold (mV).
+ @return Raw code, or the largest code + 1 if above the range.
+ */
+//-----------------------------------------------------------------------------
+uint32_t SensorWLED::thresholdCode(float mv_value) {
+
+    int32_t q16_threshold = lround(mv_value * Q16_ONE);
+    uint32_t low = 0;
+    uint32_t high = getCodeMax() + 1;
+
+    // The mapping is monotonic, binary search
+    while (low < high) {
+        uint32_t mid = (low + high) / 2;
+        if (mapRawValue(mid) >= q16_threshold) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+    return low;
+}
+#endif
+
+#if SENSOR_TRIGGERS
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Runs the trigger state machines for a reading.
+
+ @param  raw_value
+         Raw ADC value at bits capability.
+ @param  reading_millis
+         The time of the reading.
+ */
+//-----------------------------------------------------------------------------
+void SensorWLED::evaluateTriggers(uint16_t raw_value, uint32_t reading_millis) {
+
+    uint16_t previous_value = trigger_previous_flag ? trigger_previous_value : raw_value;
+    trigger_previous_value = raw_value;
+    trigger_previous_flag = true;
+
+    for (uint8_t trigger = 0; trigger < trigger_count; trigger++) {
+
+        bool is_on;
+        bool is_off;
+        if (Triggers[trigger].type == rising_trigger) {
+            is_on = raw_value >= trigger_on_code[trigger];
+            is_off = raw_value < trigger_off_code[trigger];
+        } else if (Triggers[trigger].type == falling_trigger) {
+            is_on = raw_value < trigger_on_code[trigger];
+            is_off = raw_value >= trigger_off_code[trigger];
+        } else if (Triggers[trigger].type == slope_trigger) {
+            int32_t step = (Triggers[trigger].mv_threshold < 0) ? 
+                                (int32_t) previous_value - raw_value :
+                                (int32_t) raw_value - previous_value;
+            is_on = step >= (int32_t) trigger_on_code[trigger];
+            is_off = step < (int32_t) trigger_off_code[trigger];
+        } else {
+            is_on = raw_value < trigger_on_code[trigger] || 
+                            raw_value >= trigger_high_on_code[trigger];
+            is_off = raw_value >= trigger_off_code[trigger] && 
+                            raw_value < trigger_high_off_code[trigger];
+        }
+
+        switch (trigger_state[trigger]) {
+        case trigger_idle:
+            if (is_on == false) {
+                break;
+            }
+            trigger_state[trigger] = trigger_pending;
+            trigger_since_millis_tm[trigger] = reading_millis;
+            // No min duration fires at once
+            [[fallthrough]];
+        case trigger_pending:
+            if (is_on == false) {
+                trigger_state[trigger] = trigger_idle;
+            } else if (reading_millis - trigger_since_millis_tm[trigger] >= 
+                                        Triggers[trigger].ms_min_duration) {
+                trigger_state[trigger] = trigger_active;
+                fireTrigger(trigger, true, raw_value, reading_millis);
+            }
+            break;
+        case trigger_active:
+            if (is_off) {
+                trigger_state[trigger] = trigger_idle;
+                fireTrigger(trigger, false, raw_value, reading_millis);
+            }
+            break;
+        }
+    }
+}
+#endif
+
+#if SENSOR_TRIGGERS
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Calls the trigger callback, or queues the event.
+
+ @param  trigger
+         Trigger index.
+ @param  is_active
+         True when fired, false when released.
+ @param  raw_value
+         The reading.
+ @param  reading_millis
+         The time of the reading.
+ */
+//-----------------------------------------------------------------------------
+void SensorWLED::fireTrigger(uint8_t trigger, bool is_active, uint16_t raw_value, 
+                                                        uint32_t reading_millis) {
+
+#if SENSOR_CAPTURE
+    if (is_active && trigger == capture_trigger && capture_fill < 0) {
+        startCapture(trigger);
+    }
+#endif
+
+    TriggerEventType_t Event;
+    Event.ms_time = reading_millis;
+    Event.mv_value = (double) mapRawValue(raw_value) / Q16_ONE;
+    Event.raw_value = raw_value;
+    Event.trigger = trigger;
+    Event.is_active = is_active;
+
+    if (Triggers[trigger].callback != nullptr) {
+        Triggers[trigger].callback(Event);
+    } else if (trigger_event_count < TRIGGER_QUEUE_SIZE) {
+        uint8_t next = (trigger_event_first + trigger_event_count) % TRIGGER_QUEUE_SIZE;
+        trigger_events[next] = Event;
+        trigger_event_count++;
+    }
+}
+#endif
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Arms the capture of the readings around a trigger, like a 
+         (normal mode) oscilloscope: CAPTURE_PRE_SAMPLES readings before 
+         the trigger fires, and CAPTURE_POST_SAMPLES after. Each fired 
+         trigger gives a new snapshot, once the previous one is complete.
+
+ @param  trigger
+         Trigger index, from addTrigger().
+ @return true if armed, false without 'SENSOR_CAPTURE'.
+ */
+//-----------------------------------------------------------------------------
+bool SensorWLED::armCapture(uint8_t trigger) {
+#if SENSOR_CAPTURE
+    if (trigger >= trigger_count) {
+        return false;
+    }
+    capture_pre_head = 0;
+    capture_pre_fill = 0;
+    capture_fill = -1;
+    capture_trigger = trigger;
+    return true;
+#else
+    (void) trigger;
+    return false;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Stops the capture. A completed snapshot can still be read.
+ */
+//-----------------------------------------------------------------------------
+void SensorWLED::disarmCapture(void) {
+#if SENSOR_CAPTURE
+    capture_trigger = -1;
+    capture_fill = -1;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Takes the newest completed snapshot. It is not overwritten until
+         the next call, while new captures fill the other snapshot buffer,
+         i.e. read it without stopping the acquisition.
+
+ @return The snapshot, or nullptr if there is no new one.
+ */
+//-----------------------------------------------------------------------------
+const CaptureType_t *SensorWLED::readCapture(void) {
+#if SENSOR_CAPTURE
+    capture_read = capture_ready;
+    capture_ready = -1;
+    return (capture_read < 0) ? nullptr : &Captures[capture_read];
+#else
+    return nullptr;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Number of completed snapshots overwritten before they were read.
+
+ @return Overrun count.
+ */
+//-----------------------------------------------------------------------------
+uint32_t SensorWLED::getCaptureOverrunCount(void) {
+#if SENSOR_CAPTURE
+    return capture_overrun_count;
+#else
+    return 0;
+#endif
+}
+
+#if SENSOR_CAPTURE
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Starts a snapshot with the pre-trigger readings, i.e. up to the
+         trigger reading. Copies at most CAPTURE_PRE_SAMPLES readings.
+
+ @param  trigger
+         The fired trigger.
+ */
+//-----------------------------------------------------------------------------
+void SensorWLED::startCapture(uint8_t trigger) {
+
+    // Not the buffer held by the reader, and rather not the unread one
+    int8_t buffer = (capture_read >= 0) ? 1 - capture_read : 
+                        (capture_ready == 0) ? 1 : 0;
+    if (buffer == capture_ready) {
+        capture_ready = -1;
+        capture_overrun_count++;
+    }
+
+    CaptureType_t &rCapture = Captures[buffer];
+    uint16_t first = (capture_pre_head + CAPTURE_PRE_SAMPLES - capture_pre_fill) % 
+                                                            CAPTURE_PRE_SAMPLES;
+    rCapture.pk_raw_value = 0;
+    for (uint16_t cnt = 0; cnt < capture_pre_fill; cnt++) {
+        uint16_t pos = (first + cnt) % CAPTURE_PRE_SAMPLES;
+        rCapture.raw_value[cnt] = capture_pre_raw[pos];
+        rCapture.ms_time[cnt] = capture_pre_ms[pos];
+        if (capture_pre_raw[pos] > rCapture.pk_raw_value) {
+            rCapture.pk_raw_value = capture_pre_raw[pos];
+        }
+    }
+    rCapture.count = capture_pre_fill;
+    rCapture.trigger_position = capture_pre_fill - 1;
+    rCapture.trigger = trigger;
+
+    capture_fill = buffer;
+}
+#endif
+
+#if SENSOR_CAPTURE
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Records a reading in the pre-trigger ring, or in the snapshot
+         being filled. Only copies, no allocation.
+
+ @param  raw_value
+         Raw ADC value at bits capability.
+ @param  reading_millis
+         The time of the reading.
+ */
+//-----------------------------------------------------------------------------
+void SensorWLED::captureReading(uint16_t raw_value, uint32_t reading_millis) {
+
+    if (capture_fill < 0) {
+        capture_pre_raw[capture_pre_head] = raw_value;
+        capture_pre_ms[capture_pre_head] = reading_millis;
+        capture_pre_head = (capture_pre_head + 1) % CAPTURE_PRE_SAMPLES;
+        if (capture_pre_fill < CAPTURE_PRE_SAMPLES) {
+            capture_pre_fill++;
+        }
+        return;
+    }
+
+    CaptureType_t &rCapture = Captures[capture_fill];
+    rCapture.raw_value[rCapture.count] = raw_value;
+    rCapture.ms_time[rCapture.count] = reading_millis;
+    if (raw_value > rCapture.pk_raw_value) {
+        rCapture.pk_raw_value = raw_value;
+    }
+    rCapture.count++;
+
+    // Completed, the readings after the trigger are the next pre-trigger ones
+    if (rCapture.count - rCapture.trigger_position > CAPTURE_POST_SAMPLES) {
+        rCapture.sequence = ++capture_sequence;
+        capture_ready = capture_fill;
+        capture_fill = -1;
+        capture_pre_head = 0;
+        capture_pre_fill = 0;
+    }
+}
+#endif
+
+#if SENSOR_QUANTILES
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Counts the instant and peak values of a reading in the histograms
+         (constant work per call).
+ */
+//-----------------------------------------------------------------------------
+void SensorWLED::updateHistograms(void) {
+
+    instant_histogram.add(raw_input_value);
+    peak_histogram.add(pk_raw_input_value);
+}
+#endif
+
+#if SENSOR_QUANTILES
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Counts a block of readings in the histograms, without a decay 
+         between them, i.e. each peak value is the max up to the reading.
+         Call before the peak value is updated with the block.
+
+ @param  codes
+         Raw ADC values at bits capability.
+ @param  n
+         Number of readings.
+ */
+//-----------------------------------------------------------------------------
+void SensorWLED::updateHistograms(const uint16_t* codes, size_t n) {
+
+    uint32_t pk_value = pk_raw_input_value;
+    for (size_t cnt = 0; cnt < n; cnt++) {
+        pk_value = (codes[cnt] > pk_value) ? codes[cnt] : pk_value;
+        instant_histogram.add(codes[cnt]);
+        peak_histogram.add(pk_value);
+    }
+}
+#endif
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Estimates a quantile of the instant values, from a histogram with
+         a bucket width of at most 1/2^HISTOGRAM_SUB_BITS of the value.
+
+ @param  q
+         Quantile, 0.0 to 1.0 (e.g. 0.95 for the 95th percentile).
+ @return The mapped value (mV) at the quantile, 0 without 'SENSOR_QUANTILES'.
+ */
+//-----------------------------------------------------------------------------
+double SensorWLED::getQuantile(double q) {
+#if SENSOR_QUANTILES
+    return (double) mapRawValue(lround(instant_histogram.quantile(q))) / Q16_ONE;
+#else
+    (void) q;
+    return 0;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Estimates a quantile of the (decaying) peak values.
+
+ @param  q
+         Quantile, 0.0 to 1.0 (e.g. 0.99 for the 99th percentile).
+ @return The mapped value (mV) at the quantile, 0 without 'SENSOR_QUANTILES'.
+ */
+//-----------------------------------------------------------------------------
+double SensorWLED::getPeakQuantile(double q) {
+#if SENSOR_QUANTILES
+    return (double) mapRawValue(lround(peak_histogram.quantile(q))) / Q16_ONE;
+#else
+    (void) q;
+    return 0;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Clears the quantile histograms, and the current tumbling window.
+ */
+//-----------------------------------------------------------------------------
+void SensorWLED::resetStatistics(void) {
+
+#if SENSOR_QUANTILES
+    instant_histogram.reset();
+    peak_histogram.reset();
+#endif
+    stats_sums = {0, 0, 0, UINT16_MAX, 0, 0, 0};
+    stats_last_sums = {0, 0, 0, 0, 0, 0, 0};
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Adds a reading to the tumbling window sums. Integer math only, 
+         every STATS_WINDOW_SIZE readings the sums are kept as the last 
+         completed window.
+
+ @param  raw_value
+         Raw ADC value at bits capability.
+ */
+//-----------------------------------------------------------------------------
+void SensorWLED::updateStatistics(uint16_t raw_value) {
+
+    stats_sums.sum += raw_value;
+    stats_sums.sq_sum += (uint32_t) raw_value * raw_value;
+    if (raw_value < stats_sums.min) {
+        stats_sums.min = raw_value;
+    }
+    if (raw_value > stats_sums.max) {
+        stats_sums.max = raw_value;
+    }
+    if (CalibrationPoints.point_count >= 2) {
+        addMappedStatistics(stats_sums, raw_value);
+    }
+
+    if (++stats_sums.count == STATS_WINDOW_SIZE) {
+        stats_last_sums = stats_sums;
+        stats_sums = {0, 0, 0, UINT16_MAX, 0, 0, 0};
+    }
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Adds a block of readings to the tumbling window sums, in tight 
+         loops up to each window end.
+
+ @param  codes
+         Raw ADC values at bits capability.
+ @param  n
+         Number of readings.
+ */
+//-----------------------------------------------------------------------------
+void SensorWLED::updateStatistics(const uint16_t* codes, size_t n) {
+
+    static_assert(STATS_WINDOW_SIZE <= 65536, "The chunk sum is 32 bits");
+
+    while (n > 0) {
+        size_t chunk = STATS_WINDOW_SIZE - stats_sums.count;
+        if (chunk > n) {
+            chunk = n;
+        }
+
+        uint32_t sum = 0;
+        uint64_t sq_sum = 0;
+        uint16_t min_value = stats_sums.min;
+        uint16_t max_value = stats_sums.max;
+        for (size_t cnt = 0; cnt < chunk; cnt++) {
+            uint16_t code = codes[cnt];
+            sum += code;
+            sq_sum += (uint32_t) code * code;
+            min_value = (code < min_value) ? code : min_value;
+            max_value = (code > max_value) ? code : max_value;
+        }
+
+        stats_sums.sum += sum;
+        stats_sums.sq_sum += sq_sum;
+        stats_sums.min = min_value;
+        stats_sums.max = max_value;
+        stats_sums.count += chunk;
+
+        // The multi-point calibration is not linear, i.e. sums of the mapped values
+        if (CalibrationPoints.point_count >= 2) {
+            for (size_t cnt = 0; cnt < chunk; cnt++) {
+                addMappedStatistics(stats_sums, codes[cnt]);
+            }
+        }
+
+        if (stats_sums.count == STATS_WINDOW_SIZE) {
+            stats_last_sums = stats_sums;
+            stats_sums = {0, 0, 0, UINT16_MAX, 0, 0, 0};
+        }
+        codes += chunk;
+        n -= chunk;
+    }
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Adds the mapped value of a reading to the sums, with a multi-point
+         calibration. The values are rounded to 1/256 mV, so the sums of a 
+         full window (up to 65535 readings) fit 64 bits.
+
+ @param  rSums
+         The sums to update.
+ @param  raw_value
+         Raw ADC value at bits capability.
+ */
+//-----------------------------------------------------------------------------
+void SensorWLED::addMappedStatistics(StatisticsSumType_t &rSums, uint16_t raw_value) {
+
+    int64_t mapped_value = (mapRawValue(raw_value) + (1 << 7)) >> 8;
+    rSums.mapped_sum += mapped_value;
+    rSums.mapped_sq_sum += (uint64_t) (mapped_value * mapped_value);
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Converts raw reading sums to statistics in mV. The slope and zero
+         offset calibration is linear, i.e. mV = gain * raw - offset, so 
+         the mean, RMS, and variance follow from the sums. The variance 
+         numerator is exact (integer), i.e. no Welford update is needed. 
+         Values below the zero offset are not clamped to zero, as for 
+         single readings. A multi-point calibration uses the sums of the
+         mapped values instead, i.e. as getMappedValue().
+
+ @param  rSums
+         The integer sums.
+ @return The statistics (mV), all zero without readings.
+ */
+//-----------------------------------------------------------------------------
+StatisticsType_t SensorWLED::calculateStatistics(StatisticsSumType_t const &rSums) {
+
+    StatisticsType_t Statistics = {};
+
+    if (rSums.count == 0) {
+        return Statistics;
+    }
+
+    Statistics.min = (double) mapRawValue(rSums.min) / Q16_ONE;
+    Statistics.max = (double) mapRawValue(rSums.max) / Q16_ONE;
+    Statistics.count = rSums.count;
+
+    if (CalibrationPoints.point_count >= 2) {
+        double mean = rSums.mapped_sum / (256.0 * rSums.count);
+        double mean_sq = rSums.mapped_sq_sum / (65536.0 * rSums.count);
+        Statistics.mean = mean;
+        Statistics.rms = sqrt(mean_sq);
+        Statistics.variance = (mean_sq > mean * mean) ? mean_sq - mean * mean : 0;
+        return Statistics;
+    }
+
+    double gain = (double) DynamicParams.mv_maxvoltage_adc / 
+                        getCodeMax() * CalibrationData.cal_slope;
+    double offset = CalibrationData.cal_zero_offset;
+    double n = rSums.count;
+
+    // n * sum(x^2) - sum(x)^2 fits 64 bits for up to 65535 readings
+    uint64_t variance_num = rSums.count * rSums.sq_sum - rSums.sum * rSums.sum;
+
+    double mean_raw = rSums.sum / n;
+    double mean_sq_raw = rSums.sq_sum / n;
+    double mean_sq = gain * gain * mean_sq_raw - 2 * gain * offset * mean_raw + offset * offset;
+
+    Statistics.mean = gain * mean_raw - offset;
+    Statistics.rms = sqrt(mean_sq > 0 ? mean_sq : 0);
+    Statistics.variance = gain * gain * variance_num / (n * n);
+
+    return Statistics;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Statistics of the last completed tumbling window, i.e. each 
+         STATS_WINDOW_SIZE readings (before the moving average).
+
+ @return Mean, RMS, min, max, variance (mV), and number of readings.
+ */
+//-----------------------------------------------------------------------------
+StatisticsType_t SensorWLED::getWindowStatistics(void) {
+    return calculateStatistics(stats_last_sums);
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Statistics of the moving window, i.e. the last 'window_size' 
+         readings, updated with each reading. Requires a 'window' in the
+         constructor.
+
+ @return Mean, RMS, min, max, variance (mV), and number of readings, all
+         zero without 'SENSOR_MOVING_WINDOW'.
+ */
+//-----------------------------------------------------------------------------
+StatisticsType_t SensorWLED::getSlidingStatistics(void) {
+#if SENSOR_MOVING_WINDOW
+    StatisticsSumType_t Sums = {window_sum, window_sq_sum, window_fill, 0, 0, 0, 0};
+
+    if (window_fill > 0) {
+        Sums.min = window_buffer[window_min_queue[window_min_first]];
+        Sums.max = window_buffer[window_max_queue[window_max_first]];
+    }
+    // The readings of the window are in the first 'window_fill' entries
+    if (CalibrationPoints.point_count >= 2) {
+        for (uint16_t cnt = 0; cnt < window_fill; cnt++) {
+            addMappedStatistics(Sums, window_buffer[cnt]);
+        }
+    }
+    return calculateStatistics(Sums);
+#else
+    return {};
+#endif
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Map the input analog value to a value optimized for actual
+ capability of the controllers ADC and suppl voltage.
+
+ @return The mapped instantanous analog value.
+
+ */
+//-----------------------------------------------------------------------------
+double SensorWLED::getMappedValue(void) {
+    return (double) mapped_input_value / Q16_ONE;
+
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Map the input analog value to a value optimized for actual
+ capability of the controllers ADc and suppl voltage.
+
+ @return The mapped peak analog value.
+
+ */
+//-----------------------------------------------------------------------------
+double SensorWLED::getMappedPeakValue(void) {
+    return (double) pk_mapped_input_value / Q16_ONE;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Gets the last reading as a raw code, i.e. not mapped to mV.
+
+ @return Raw code, 0 to getCodeMax().
+ */
+//-----------------------------------------------------------------------------
+uint16_t SensorWLED::getRawValue(void) {
+    return raw_input_value;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Gets the peak value as a raw code, i.e. not mapped to mV.
+
+ @return Raw peak code, 0 to getCodeMax().
+ */
+//-----------------------------------------------------------------------------
+uint16_t SensorWLED::getRawPeakValue(void) {
+    return pk_raw_input_value;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Adds a raw ADC sample to the lock-free queue. Safe to call from
+         a timer ISR, or another thread, in 'interrupt_driven' mode. The
+         samples are processed in updateAnalogRead().
+
+ @param  code
+         Raw ADC value at bits capability.
+ */
+//-----------------------------------------------------------------------------
+void IRAM_ATTR SensorWLED::pushSample(uint16_t code) {
+#if SENSOR_SAMPLE_QUEUE
+    sample_queue.push(code);
+#else
+    (void) code;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Gets the number of dropped ISR samples, i.e. when the queue was 
+         full since updateAnalogRead() was not called often enough.
+
+ @return Dropped samples.
+ */
+//-----------------------------------------------------------------------------
+uint32_t SensorWLED::getSampleOverflowCount(void) {
+#if SENSOR_SAMPLE_QUEUE
+    return sample_queue.getOverflowCount();
+#else
+    return 0;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  The largest reading in the moving average window, i.e., the last
+         'window_size' polls (without decay).
+
+ @return The mapped moving max analog value, 0 without 'SENSOR_MOVING_WINDOW'.
+
+ */
+//-----------------------------------------------------------------------------
+double SensorWLED::getMappedWindowPeakValue(void) {
+#if SENSOR_MOVING_WINDOW
+    if (window_max_count == 0) {
+        return 0;
+    }
+    return (double) mapRawValue(window_buffer[window_max_queue[window_max_first]]) / Q16_ONE;
+#else
+    return 0;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Counts the whole hold periods elapsed since the last decay, and 
+         advances the hold time by these periods (keeping its phase).
+
+ @param  current_millis
+         The time of this call.
+ @return The number of elapsed hold periods, or zero.
+ */
+//-----------------------------------------------------------------------------
+uint32_t SensorWLED::elapsedHoldPeriods(uint32_t current_millis) {
+
+    uint32_t elapsed_millis = current_millis - previous_hold_millis_tm;
+
+    if (elapsed_millis < DynamicParams.ms_hold_time) {
+        return 0;
+    }
+
+    // Zero hold time decays once per call
+    if (DynamicParams.ms_hold_time == 0) {
+        previous_hold_millis_tm = current_millis;
+        INSTRUMENT(Instrumentation.decay_tick_count++);
+        return 1;
+    }
+
+    uint32_t hold_periods = elapsed_millis / DynamicParams.ms_hold_time;
+    previous_hold_millis_tm += hold_periods * DynamicParams.ms_hold_time;
+    INSTRUMENT(Instrumentation.decay_tick_count += hold_periods);
+    return hold_periods;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Applies the decay model to peak value, in proportion to the 
+         elapsed hold periods, with the precomputed decay table.
+
+ @param  peak_value
+ Value to decay with set model, rate and times.
+ @param  hold_periods
+ Number of elapsed hold periods.
+ @return The reduced, decayed input peak value.
+
+ */
+//-----------------------------------------------------------------------------
+uint32_t SensorWLED::applyDecay(uint32_t peak_value, uint32_t hold_periods) {
+    return applyDecayTable(q16_decay_table, peak_value, hold_periods);
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Writes all staged EEPROM changes, of all instances, to flash in 
+         one commit. Call after the last begin(), or let the first 
+         updateAnalogRead() call do it.
+
+ @return true if EEPROM committed.
+ */
+//-----------------------------------------------------------------------------
+bool SensorWLED::commitEEPROM(void) {
+
+#if SENSOR_INSTRUMENTATION
+    uint32_t us_start_time = micros();
+    bool is_committed = config_store.commit();
+    uint32_t us_commit_time = micros() - us_start_time;
+
+    SharedInstrumentation.eeprom_commit_count++;
+    SharedInstrumentation.us_commit_sum += us_commit_time;
+    if (us_commit_time > SharedInstrumentation.us_commit_max) {
+        SharedInstrumentation.us_commit_max = us_commit_time;
+    }
+    return is_committed;
+#else
+    return config_store.commit();
+#endif
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Stages static 'Version' struct to EEPROM.
+         Appended as a common record (id 0) for all instances.
+
+ @return true if EEPROM written.
+ */
+//-----------------------------------------------------------------------------
+bool SensorWLED::writeVersionEEPROM(void)
+{
+    // The check to 'require' a new write to Version EEPROM is done in the call
+    bool is_written = config_store.write(version_record, 0, &Version, sizeof(Version));
+    INSTRUMENT(SharedInstrumentation.eeprom_write_count++);
+
+#ifndef ARDUINO
+    PLOG_INFO << "EEPROM Version (common) WRITE, sequence: " << config_store.getSequence() - 1;
+#endif
+
+    return is_written;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Memory load of EEPROM Id and Pgm version, and returns the information.
+         This is a common record for all instances.
+
+ @return The Version struct data (zero if never written).
+
+ */
+//-----------------------------------------------------------------------------
+VersionType_t SensorWLED::readVersionEEPROM(void) {
+
+    VersionType_t StoredVersion = {};
+    config_store.read(version_record, 0, &StoredVersion, sizeof(StoredVersion));
+    INSTRUMENT(Instrumentation.eeprom_read_count++);
+
+#ifndef ARDUINO
+    PLOG_INFO << "EEPROM Version (common) READ";
+#endif
+
+return StoredVersion;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+@brief  Stages static 'CalibrationData' struct to EEPROM.
+
+@param instance  
+       The actual instance (ADC channel) for which the data belongs to.      
+
+@param crc32  
+       The calculated CRC32 sum for the struct to be written. 
+
+@return Boolean (true) value when data is written.
+ */
+//-----------------------------------------------------------------------------
+bool SensorWLED::writeCalibrationEEPROM(uint16_t instance, uint32_t crc32)
+{
+    bool is_written = false;
+
+    if (instance == 0 || instance > MAX_CHANNELS) {
+        return false;
+    }
+
+    // CRC32 checks minimize flash writes (i.e. emulated EEPROM).
+    CalibrationDataType_t StoredCalibrationData = readCalibrationEEPROM(instance);
+    uint32_t oldcrc = calculateCalibrationDataCRC32(StoredCalibrationData);
+    
+    if(oldcrc != crc32) {
+        is_written = config_store.write(calibration_record, instance,
+                                    &CalibrationData, sizeof(CalibrationData));
+        INSTRUMENT(Instrumentation.eeprom_write_count++);
+
+        #ifndef ARDUINO
+            PLOG_INFO << "EEPROM CalibrationData WRITE, instance: " << instance;
+        #endif
+    }
+
+    return is_written;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Memory load of EEPROM 'CalibrationData', and returns the struct.
+
+ @param instance
+ The specified instance for the EEPROM read
+
+ @return The CalibrationData struct data (zero if never written).
+ */
+//-----------------------------------------------------------------------------
+CalibrationDataType_t SensorWLED::readCalibrationEEPROM(uint16_t instance) {
+
+    CalibrationDataType_t StoredCalibrationData = {};
+    config_store.read(calibration_record, instance, 
+                        &StoredCalibrationData, sizeof(StoredCalibrationData));
+    INSTRUMENT(Instrumentation.eeprom_read_count++);
+
+#ifndef ARDUINO
+    PLOG_INFO << "EEPROM CalibrationData READ, instance: " << instance;
+#endif
+
+return StoredCalibrationData;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+@brief  Stages static 'DynamicData' struct to EEPROM.
+        
+@param instance  
+       The actual instance (ADC channel) for which the data belongs to.      
+
+@param crc32  
+       The calculated CRC32 sum for the struct to be written. 
+
+@return Boolean (true) value when data is written.
+ */
+//-----------------------------------------------------------------------------
+bool SensorWLED::writeDynamicEEPROM(uint16_t instance, uint32_t crc32)
+{
+    bool is_written = false;
+
+    if (instance == 0 || instance > MAX_CHANNELS) {
+        return false;
+    }
+
+    // CRC32 checks minimize flash writes (i.e. emulated EEPROM).
+    DynamicDataType_t StoredDynamicParams = readDynamicEEPROM(instance);
+    uint32_t oldcrc = calculateDynamicParamsCRC32(StoredDynamicParams);
+    
+    if(oldcrc != crc32) {    
+        is_written = config_store.write(dynamic_record, instance,
+                                    &DynamicParams, sizeof(DynamicParams));
+        INSTRUMENT(Instrumentation.eeprom_write_count++);
+
+        #ifndef ARDUINO
+            PLOG_INFO << "EEPROM DynamicData WRITE, instance: " << instance;
+        #endif
+    }
+
+    return is_written;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Memory load of EEPROM 'DynamicData', and returns the struct.
+ @param instance
+ The specified instance for the EEPROM read
+ @return The DynamicData struct data (zero if never written).
+ */
+//-----------------------------------------------------------------------------
+DynamicDataType_t SensorWLED::readDynamicEEPROM(uint16_t instance) {
+
+    DynamicDataType_t StoredDynamicParams = {};
+    config_store.read(dynamic_record, instance,
+                        &StoredDynamicParams, sizeof(StoredDynamicParams));
+    INSTRUMENT(Instrumentation.eeprom_read_count++);
+
+#ifndef ARDUINO
+    PLOG_INFO << "EEPROM DynamicData READ, instance: " << instance;
+#endif
+
+return StoredDynamicParams;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+@brief  Stages the 'CalibrationPoints' struct to EEPROM.
+
+@param instance  
+       The actual instance (ADC channel) for which the data belongs to.      
+
+@param crc32  
+       The calculated CRC32 sum for the struct to be written. 
+
+@return Boolean (true) value when data is written.
+ */
+//-----------------------------------------------------------------------------
+bool SensorWLED::writeCalibrationPointsEEPROM(uint16_t instance, uint32_t crc32)
+{
+    bool is_written = false;
+
+    if (instance == 0 || instance > MAX_CHANNELS) {
+        return false;
+    }
+
+    // CRC32 checks minimize flash writes, no points and no record are equal
+    CalibrationPointsType_t StoredCalibrationPoints = readCalibrationPointsEEPROM(instance);
+    uint32_t oldcrc = calculateCalibrationPointsCRC32(StoredCalibrationPoints);
+
+    if(oldcrc != crc32) {
+        is_written = config_store.write(calibration_points_record, instance,
+                                    &CalibrationPoints, sizeof(CalibrationPoints));
+        INSTRUMENT(Instrumentation.eeprom_write_count++);
+
+        #ifndef ARDUINO
+            PLOG_INFO << "EEPROM CalibrationPoints WRITE, instance: " << instance;
+        #endif
+    }
+
+    return is_written;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Memory load of EEPROM 'CalibrationPoints', and returns the struct.
+         Pass the points to setCalibrationPoints() to use them.
+ @param instance
+ The specified instance for the EEPROM read
+ @return The CalibrationPoints struct data (zero if never written).
+ */
+//-----------------------------------------------------------------------------
+CalibrationPointsType_t SensorWLED::readCalibrationPointsEEPROM(uint16_t instance) {
+
+    CalibrationPointsType_t StoredCalibrationPoints = {};
+    config_store.read(calibration_points_record, instance,
+                        &StoredCalibrationPoints, sizeof(StoredCalibrationPoints));
+    INSTRUMENT(Instrumentation.eeprom_read_count++);
+
+#ifndef ARDUINO
+    PLOG_INFO << "EEPROM CalibrationPoints READ, instance: " << instance;
+#endif
+
+return StoredCalibrationPoints;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Sets the analog pin for ADC input on the microcontroller.
+
+ @param  a_pin
+         Pin number for analog readings on the microcontroller.
+ @param  mode
+         Arduino pin mode for analog input.
+ */
+//-----------------------------------------------------------------------------
+void SensorWLED::setAnalogPin(uint16_t a_pin, uint16_t mode) {
+    pinMode(a_pin, mode);
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Assigns the lowest free channel id, i.e. the same id each boot 
+         for the same begin() order.
+
+ @return true if registered, false if all MAX_CHANNELS ids are used, or
+         the instance already has an id.
+ */
+//-----------------------------------------------------------------------------
+bool SensorWLED::registerChannel(void) {
+
+    // Assigned from another instance, keeps its own id
+    for (uint16_t id = 1; id <= MAX_CHANNELS; id++) {
+        if (channel_registry[id] == this) {
+            channel_id = id;
+            return false;
+        }
+    }
+
+    for (uint16_t id = 1; id <= MAX_CHANNELS; id++) {
+        if (channel_registry[id] == nullptr) {
+            channel_registry[id] = this;
+            channel_id = id;
+            instance_counter++;
+            return true;
+        }
+    }
+
+#ifndef ARDUINO
+    PLOG_WARNING << "No free channel id, max channels: " << MAX_CHANNELS;
+#endif
+
+    return false;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  One ADC conversion, with the analog multiplexer selected first.
+
+ @return Raw ADC value at bits capability.
+ */
+//-----------------------------------------------------------------------------
+uint16_t SensorWLED::readADC(void) {
+
+    if (mux_select != nullptr) {
+        mux_select(mux_channel);
+    }
+    INSTRUMENT(Instrumentation.adc_conversion_count++);
+    return analogRead(CalibrationData.analog_pin);
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Makes this a virtual channel, behind an analog multiplexer. The
+         'select' function is called before each ADC conversion, and 
+         must set the mux address lines (and wait for settling).
+
+ @param  select
+         Function that selects a mux input, or nullptr.
+ @param  mux_channel
+         The mux input of this channel.
+ */
+//-----------------------------------------------------------------------------
+void SensorWLED::setMuxSelect(void (*select)(uint16_t mux_channel), uint16_t mux_channel) {
+
+    this->mux_select = select;
+    this->mux_channel = mux_channel;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+@brief Gets the channel id, used for the EEPROM records.
+
+@return Channel id (1..MAX_CHANNELS), 0 before begin().
+ */
+//-----------------------------------------------------------------------------
+uint16_t SensorWLED::getChannelId(void) {
+    return channel_id;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+@brief Gets the total number of registered instances (channels).
+
+@return Instances registered.
+ */
+//-----------------------------------------------------------------------------
+uint16_t SensorWLED::getInstanceNumber(void) {
+    return instance_counter;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+@brief Looks up a channel by id.
+
+@param id
+       Channel id (1..MAX_CHANNELS).
+
+@return The instance, or nullptr if not registered.
+ */
+//-----------------------------------------------------------------------------
+SensorWLED *SensorWLED::getChannel(uint16_t id) {
+    return (id <= MAX_CHANNELS) ? channel_registry[id] : nullptr;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+@brief Gets the RAM used per channel, i.e. the instance, its registry
+       slot, and its record log index entries.
+
+@return Bytes per channel.
+ */
+//-----------------------------------------------------------------------------
+size_t SensorWLED::getChannelRAMSize(void) {
+    return sizeof(SensorWLED) + sizeof(SensorWLED *) + CONFIG_RECORD_TYPES * sizeof(uint16_t);
+}
+
+//-----------------------------------------------------------------------------
+/*!
+@brief Gets the EEPROM log space per channel, i.e. one calibration and 
+       one dynamic record.
+
+@return Bytes per channel.
+ */
+//-----------------------------------------------------------------------------
+size_t SensorWLED::getChannelStorageSize(void) {
+    return ConfigStore::getRecordSize(sizeof(CalibrationDataType_t)) +
+                        ConfigStore::getRecordSize(sizeof(DynamicDataType_t));
+}
+
+//-----------------------------------------------------------------------------
+/*!
+@brief Gets a snapshot of the counters of all instances, e.g. the EEPROM 
+       commits ('SENSOR_INSTRUMENTATION').
+
+@return Shared counters, all zero without instrumentation.
+ */
+//-----------------------------------------------------------------------------
+SharedInstrumentationType_t SensorWLED::getSharedInstrumentation(void) {
+#if SENSOR_INSTRUMENTATION
+    return SharedInstrumentation;
+#else
+    return {};
+#endif
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Gets a snapshot of the counters of this instance, i.e. the poll 
+         jitter and missed deadlines, the update times, ADC conversions, 
+         decays, and EEPROM accesses ('SENSOR_INSTRUMENTATION').
+
+ @return Counters, all zero without instrumentation.
+ */
+//-----------------------------------------------------------------------------
+InstrumentationType_t SensorWLED::getInstrumentation(void) {
+#if SENSOR_INSTRUMENTATION
+    return Instrumentation;
+#else
+    return {};
+#endif
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Clears the counters of this instance.
+ */
+//-----------------------------------------------------------------------------
+void SensorWLED::resetInstrumentation(void) {
+#if SENSOR_INSTRUMENTATION
+    Instrumentation = {};
+    previous_reading_millis_tm = 0;
+#endif
+}
+
+#if SENSOR_INSTRUMENTATION
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Counts an updateAnalogRead() call, and its time in the histogram.
+
+ @param  us_start_time
+         micros() at the start of the call.
+ */
+//-----------------------------------------------------------------------------
+void SensorWLED::countUpdate(uint32_t us_start_time) {
+
+    uint32_t us_update_time = micros() - us_start_time;
+
+    Instrumentation.update_count++;
+    Instrumentation.us_update_sum += us_update_time;
+    if (us_update_time > Instrumentation.us_update_max) {
+        Instrumentation.us_update_max = us_update_time;
+    }
+
+    // Bucket n holds 2^(n-1) to 2^n - 1 us, the last one all longer times
+    uint8_t bucket = (us_update_time == 0) ? 0 : 32 - __builtin_clz(us_update_time);
+    if (bucket >= INSTRUMENT_BUCKETS) {
+        bucket = INSTRUMENT_BUCKETS - 1;
+    }
+    Instrumentation.update_histogram[bucket]++;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Counts a reading, and its lateness against the poll time. A 
+         reading a whole poll time late missed its deadline.
+
+ @param  reading_millis
+         The time of the reading.
+ */
+//-----------------------------------------------------------------------------
+void SensorWLED::countReading(uint32_t reading_millis) {
+
+    uint32_t ms_poll_time = DynamicParams.ms_poll_time;
+
+    if (Instrumentation.reading_count > 0 && ms_poll_time > 0) {
+        uint32_t ms_interval = reading_millis - previous_reading_millis_tm;
+        uint32_t ms_jitter = (ms_interval > ms_poll_time) ? ms_interval - ms_poll_time : 0;
+
+        Instrumentation.ms_jitter_sum += ms_jitter;
+        if (ms_jitter > Instrumentation.ms_jitter_max) {
+            Instrumentation.ms_jitter_max = ms_jitter;
+        }
+        if (ms_jitter >= ms_poll_time) {
+            Instrumentation.missed_deadline_count++;
+        }
+    }
+    previous_reading_millis_tm = reading_millis;
+    Instrumentation.reading_count++;
+}
+#endif
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Checks the decay rate for the decay model. A linear decay rate 
+         must be less than one, or the peak never decays.
+
+ @param  decay_model
+         Linear or exponential decay model.
+ @param  decay_rate
+         The user decay rate.
+ @return The decay rate to use.
+ */
+//-----------------------------------------------------------------------------
+float SensorWLED::validateDecayRate(DecayModelType_e decay_model, float decay_rate) {
+
+    float tmp_decay_rate = 1.0;
+
+    if (decay_rate > 0) {
+        tmp_decay_rate = decay_rate;
+    }
+    if (decay_model == linear_decay && tmp_decay_rate >= 1.0) {
+        tmp_decay_rate = LINEAR_DECAY_RATE;
+    }
+    return tmp_decay_rate;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Precomputes the decay factor for 0..DECAY_TABLE_SIZE-1 elapsed 
+         hold periods in Q16.16, i.e. no exp() calls when polling.
+
  @param  table
-         CRC32 table required for calculations.
- @param  initial
-         Initial CRC32 value. 0 if first update, can be called repetingly.
+         The table that will be populated with factor^n.
+ @param  decay_model
+         Linear or exponential decay model.
+ @param  decay_rate
+         The (validated) decay rate.
+ */
+//-----------------------------------------------------------------------------
+void SensorWLED::generateDecayTable(uint32_t (&table)[DECAY_TABLE_SIZE],
+                            DecayModelType_e decay_model, float decay_rate) {
+
+    double decay_factor = 0;
+
+    if (decay_model == linear_decay) {
+        decay_factor = decay_rate;
+    } else if (decay_model == exponential_decay) {
+        decay_factor = exp(-decay_rate);
+    } else if (decay_model == envelope_decay) {
+        // No hold time decay, the envelope falls with each reading
+        decay_factor = 1.0;
+    }
+
+    double factor = 1.0;
+    for (uint16_t cnt = 0; cnt < DECAY_TABLE_SIZE; cnt++) {
+        table[cnt] = lround(factor * Q16_ONE);
+        factor *= decay_factor;
+    }
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Decays a peak value in proportion to the elapsed hold periods, 
+         with one multiplication from the precomputed decay table.
+
+ @param  table
+         The decay factor^n table.
+ @param  peak_value
+         Value to decay.
+ @param  hold_periods
+         Number of elapsed hold periods.
+ @return The reduced, decayed input peak value.
+ */
+//-----------------------------------------------------------------------------
+uint32_t SensorWLED::applyDecayTable(const uint32_t (&table)[DECAY_TABLE_SIZE],
+                                    uint32_t peak_value, uint32_t hold_periods) {
+
+    // Only after long stalls (rare), step with the largest table factor
+    while (hold_periods >= DECAY_TABLE_SIZE && peak_value > 0) {
+        peak_value = ((uint64_t) peak_value * table[DECAY_TABLE_SIZE-1]) >> Q16_SHIFT;
+        hold_periods -= DECAY_TABLE_SIZE-1;
+    }
+
+    if (hold_periods >= DECAY_TABLE_SIZE) {
+        return 0;
+    }
+    return ((uint64_t) peak_value * table[hold_periods]) >> Q16_SHIFT;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Precomputes the single-pole factors exp(-t/tau) for t = 2^n 
+         microseconds in Q2.30. A zero time constant gives zero factors,
+         i.e. the envelope follows at once.
+
+ @param  table
+         The table that will be populated.
+ @param  ms_time_constant
+         Attack or release time constant (milliseconds).
+ */
+//-----------------------------------------------------------------------------
+void SensorWLED::generateEnvelopeTable(uint32_t (&table)[ENVELOPE_TABLE_SIZE],
+                                                    uint16_t ms_time_constant) {
+
+    for (uint16_t cnt = 0; cnt < ENVELOPE_TABLE_SIZE; cnt++) {
+        double factor = 0;
+        if (ms_time_constant > 0) {
+            factor = exp(-ldexp(1.0, cnt) / (ms_time_constant * 1000.0));
+        }
+        table[cnt] = lround(ldexp(factor, Q30_SHIFT));
+    }
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  The single-pole factor exp(-t/tau) for any elapsed time, with one 
+         multiplication per set bit in 'elapsed_us'.
+
+ @param  table
+         Factors for 2^n microseconds.
+ @param  elapsed_us
+         Time since the previous reading (microseconds).
+ @return The factor in Q2.30.
+ */
+//-----------------------------------------------------------------------------
+uint32_t SensorWLED::envelopeFactor(const uint32_t (&table)[ENVELOPE_TABLE_SIZE],
+                                                        uint32_t elapsed_us) {
+
+    if (elapsed_us >> ENVELOPE_TABLE_SIZE) {
+        return 0;
+    }
+
+    uint32_t factor = 1UL << Q30_SHIFT;
+    for (uint16_t bit = 0; elapsed_us != 0 && factor != 0; bit++, elapsed_us >>= 1) {
+        if (elapsed_us & 1) {
+            factor = ((uint64_t) factor * table[bit]) >> Q30_SHIFT;
+        }
+    }
+    return factor;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Integer single-pole IIR envelope follower, i.e. the peak value 
+         rises with the attack and falls with the release time constant.
+         The factor is exact for the elapsed time, so irregular readings
+         give the same ballistics.
+
+ @param  raw_value
+         Reading (after the moving average), at bits capability.
+ @param  reading_us
+         The time of the reading (microseconds).
+ */
+//-----------------------------------------------------------------------------
+void SensorWLED::updateEnvelope(uint32_t raw_value, uint32_t reading_us) {
+
+    uint32_t q16_value = raw_value << Q16_SHIFT;
+
+    if (envelope_started_flag == false) {
+        q16_envelope_value = q16_value;
+        envelope_started_flag = true;
+    } else if (q16_value > q16_envelope_value) {
+        uint32_t factor = envelopeFactor(q30_attack_table, reading_us - previous_envelope_us_tm);
+        q16_envelope_value = q16_value - 
+            (((uint64_t) (q16_value - q16_envelope_value) * factor) >> Q30_SHIFT);
+    } else {
+        uint32_t factor = envelopeFactor(q30_release_table, reading_us - previous_envelope_us_tm);
+        q16_envelope_value = q16_value + 
+            (((uint64_t) (q16_envelope_value - q16_value) * factor) >> Q30_SHIFT);
+    }
+    previous_envelope_us_tm = reading_us;
+
+    pk_raw_input_value = (q16_envelope_value + (Q16_ONE / 2)) >> Q16_SHIFT;
+    pk_mapped_input_value = mapRawValue(pk_raw_input_value);
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Calculate 32 bit CRC (slicing-by-8), over a whole buffer. The
+         result is the same as for one byte at a time, i.e. a stored CRC32
+         sum stays valid.
+
  @param  buf
          Pointer to start address of memory.
  @param  len
          Size of contingent memory area to apply the CRC32 algorithm.
+ @param  initial
+         Initial CRC32 value. 0 if first update, can be called repetingly.
  @return Calculated CRC32 value.
  */
 //-----------------------------------------------------------------------------
-uint32_t SensorWLED::updateCRC32(uint32_t (&table)[CRC32_TABLE_SIZE], uint32_t initial,
-                                             const void* buf, size_t len) {
+uint32_t SensorWLED::calculateCRC32(const void* buf, size_t len, uint32_t initial) {
 
     uint32_t c = initial ^ 0xFFFFFFFF;
     const uint8_t* u = static_cast<const uint8_t*>(buf);
-    for (size_t i = 0; i < len; ++i)
-    {
-        c = table[(c ^ u[i]) & 0xFF] ^ (c >> 8);
+
+    // Eight bytes per step, byte-wise loads are alignment and endian safe
+    while (len >= 8) {
+        uint32_t one = (u[0] | (u[1] << 8) | (u[2] << 16) | ((uint32_t) u[3] << 24)) ^ c;
+        uint32_t two = u[4] | (u[5] << 8) | (u[6] << 16) | ((uint32_t) u[7] << 24);
+        c = crc32Table(7, one & 0xFF) ^ crc32Table(6, (one >> 8) & 0xFF) ^
+            crc32Table(5, (one >> 16) & 0xFF) ^ crc32Table(4, one >> 24) ^
+            crc32Table(3, two & 0xFF) ^ crc32Table(2, (two >> 8) & 0xFF) ^
+            crc32Table(1, (two >> 16) & 0xFF) ^ crc32Table(0, two >> 24);
+        u += 8;
+        len -= 8;
+    }
+
+    while (len-- > 0) {
+        c = crc32Table(0, (c ^ *u++) & 0xFF) ^ (c >> 8);
     }
     return c ^ 0xFFFFFFFF;
 }
@@ -567,21 +2808,7 @@ uint32_t SensorWLED::updateCRC32(uint32_t (&table)[CRC32_TABLE_SIZE], uint32_t i
 //-----------------------------------------------------------------------------
 uint32_t SensorWLED::calculateCalibrationDataCRC32(CalibrationDataType_t CalibrationData)
 {
-    uint32_t crc32sum = 0;
-
-    uint32_t table[CRC32_TABLE_SIZE];
-    generateTableCRC32(table);
-    
-    // calculate CRC32 for 'CalibrationData'
-    char *ptrcal = (char *) &CalibrationData;
-    uint16_t slen1 = sizeof(CalibrationData);
-    // Step bytewise, piece-meal through the members in the structure
-    for (uint16_t cnt = 0; cnt < slen1; cnt++) {
-        crc32sum = updateCRC32(table, crc32sum, ptrcal, 1);
-        ptrcal++;
-    }
-
-    return crc32sum;
+    return calculateCRC32(&CalibrationData, sizeof(CalibrationData));
 }
 
 //-----------------------------------------------------------------------------
@@ -596,21 +2823,21 @@ uint32_t SensorWLED::calculateCalibrationDataCRC32(CalibrationDataType_t Calibra
 //-----------------------------------------------------------------------------
 uint32_t SensorWLED::calculateDynamicParamsCRC32(DynamicDataType_t DynamicParams)
 {
-    uint32_t crc32sum = 0;
+    return calculateCRC32(&DynamicParams, sizeof(DynamicParams));
+}
 
-    uint32_t table[CRC32_TABLE_SIZE];
-    generateTableCRC32(table);
-    
-    // calculate CRC32 for 'DynamicParams'
-    char *ptrcal = (char *) &DynamicParams;
-    uint16_t slen1 = sizeof(DynamicParams);
-    // Step bytewise, piece-meal through the members in the structure
-    for (uint16_t cnt = 0; cnt < slen1; cnt++) {
-        crc32sum = updateCRC32(table, crc32sum, ptrcal, 1);
-        ptrcal++;
-    }
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Calculates the CRC32 of the multi-point calibration struct.
 
-    return crc32sum;
+ @param  rPoints
+         The calibration points.
+ @return The CRC32 sum.
+ */
+//-----------------------------------------------------------------------------
+uint32_t SensorWLED::calculateCalibrationPointsCRC32(CalibrationPointsType_t const &rPoints)
+{
+    return calculateCRC32(&rPoints, sizeof(rPoints));
 }
 
 // EOF
@@ -21,32 +21,171 @@
 #include <plog/Formatters/TxtFormatter.h>
 #include <plog/Appenders/ConsoleAppender.h>
 
-        // <-- statement line will be removed
-  // <-- statement line will be removed
-;    // <-- statement line will be removed
+// EEPROM stand-in, stages data in RAM and counts commits
+#include "HostEEPROM.h"
+
+// analogRead(), millis(), and delays, on a virtual clock or providers
+#include "HostPlatform.h"
 
 #else  // The SensorWLED library is dependent on the Arduino EEPROM library
 #include <EEPROM.h>
 #endif
 
+#include "SampleQueue.h"
+#include "LogHistogram.h"
+#include "Decimator.h"
+
+#if !defined(IRAM_ATTR)
+    #define IRAM_ATTR       ///< Place interrupt code in IRAM (ESP32/ESP8266)
+#endif
+
+/** Max number of channels (instances), with ids 1..MAX_CHANNELS */
+#if !defined(MAX_CHANNELS)
+    #define MAX_CHANNELS 32
+#endif
+
 /** Microcontroller EEPROM memory locations */
-#define  EEPROM_IDSTART    0xA0  ///< Single EEPROM area: Id and Version
-#define  MAXINSTANCES     10     ///< Max number of instantiated EEPROM areas
+#define  EEPROM_AREA_SIZE (CONFIG_STORE_START + 2 * CONFIG_BANK_SIZE) ///< Used EEPROM size
 
 /** Members in the Version struct */
 #define EEPROM_ID 0xA5         ///< EEPROM id marker (never touch)
 #define VERSION_MAJOR 0        ///< Semantic versioning (M.m.p)
-#define VERSION_MINOR 1        ///< Semantic versioning (M.m.p)
+#define VERSION_MINOR 2        ///< Semantic versioning (M.m.p)
 #define VERSION_PATCH 0        ///< Semantic versioning (M.m.p)
 
 /** The size of the table used for CRC32 calculations */
 #define CRC32_TABLE_SIZE  256  ///< The size of table
+#define CRC32_SLICES      8    ///< Tables for slicing-by-8 CRC32
 
 /** Used ADC conversion time, in microseconds to (optionally) smooth readings */
 #if !defined(US_ADC_CONVERSION_TIME)
     #define US_ADC_CONVERSION_TIME 250
 #endif
 
+/** Set to 1 for integer-only (Q16.16) mapping, calibration and decay */
+#if !defined(FIXED_POINT_MATH)
+    #define FIXED_POINT_MATH 0
+#endif
+
+/** Set to 1 to count the polls, conversions, decays, EEPROM accesses and update times */
+#if !defined(SENSOR_INSTRUMENTATION)
+    #define SENSOR_INSTRUMENTATION 0
+#endif
+
+// Instrumentation statements, compiled out without 'SENSOR_INSTRUMENTATION'
+#if SENSOR_INSTRUMENTATION
+    #define INSTRUMENT(statement) statement
+#else
+    #define INSTRUMENT(statement)
+#endif
+
+/** Update time histogram buckets, bucket n counts times below 2^n us */
+#if !defined(INSTRUMENT_BUCKETS)
+    #define INSTRUMENT_BUCKETS 12
+#endif
+
+/** Fractional bits in the Q16.16 fixed-point values */
+#define Q16_SHIFT 16
+#define Q16_ONE   (1L << Q16_SHIFT)    ///< The value 1.0 in Q16.16
+
+/** Decay factors precomputed for 0..DECAY_TABLE_SIZE-1 elapsed hold periods */
+#if !defined(DECAY_TABLE_SIZE)
+    #define DECAY_TABLE_SIZE 16
+#endif
+
+/** Envelope factors for 2^0..2^(n-1) elapsed microseconds (~16 s) */
+#if !defined(ENVELOPE_TABLE_SIZE)
+    #define ENVELOPE_TABLE_SIZE 24
+#endif
+
+/** Fractional bits of the envelope factors (Q2.30) */
+#define Q30_SHIFT 30
+
+/** Used linear decay rate if the given rate is not less than one */
+#if !defined(LINEAR_DECAY_RATE)
+    #define LINEAR_DECAY_RATE 0.5
+#endif
+
+/** Set to 1 for the ISR sample queue, i.e. the 'interrupt_driven' mode */
+#if !defined(SENSOR_SAMPLE_QUEUE)
+    #define SENSOR_SAMPLE_QUEUE 0
+#endif
+
+/** Raw samples buffered between ISR and loop() (power of two) */
+#if !defined(SAMPLE_QUEUE_SIZE)
+    #define SAMPLE_QUEUE_SIZE 64
+#endif
+
+/** Set to 1 for the moving average, max, and sliding statistics ('window') */
+#if !defined(SENSOR_MOVING_WINDOW)
+    #define SENSOR_MOVING_WINDOW 0
+#endif
+
+/** Max moving average window (in polls), sets the ring buffer sizes */
+#if !defined(MAX_WINDOW_SIZE)
+    #define MAX_WINDOW_SIZE 32
+#endif
+
+// The record log is sized by MAX_CHANNELS
+#include "ConfigStore.h"
+
+// The multi-point calibration points, and their shared table
+#include "CalibrationTable.h"
+
+/** Readings per tumbling statistics window */
+#if !defined(STATS_WINDOW_SIZE)
+    #define STATS_WINDOW_SIZE 64
+#endif
+
+/** Set to 1 for the histograms of getQuantile() and getPeakQuantile() */
+#if !defined(SENSOR_QUANTILES)
+    #define SENSOR_QUANTILES 0
+#endif
+
+/** Histogram buckets per power of two are 2^HISTOGRAM_SUB_BITS (quantiles) */
+#if !defined(HISTOGRAM_SUB_BITS)
+    #define HISTOGRAM_SUB_BITS 3
+#endif
+
+/** CIC stages of the decimation filter, see setDecimation() */
+#if !defined(CIC_ORDER)
+    #define CIC_ORDER 3
+#endif
+
+/** Set to 1 for the threshold triggers and their event queue */
+#if !defined(SENSOR_TRIGGERS)
+    #define SENSOR_TRIGGERS 0
+#endif
+
+/** Set to 1 for the capture of the readings around a trigger */
+#if !defined(SENSOR_CAPTURE)
+    #define SENSOR_CAPTURE 0
+#endif
+
+#if SENSOR_CAPTURE && !SENSOR_TRIGGERS
+    #error "SENSOR_CAPTURE needs SENSOR_TRIGGERS"
+#endif
+
+/** Max number of triggers per instance */
+#if !defined(MAX_TRIGGERS)
+    #define MAX_TRIGGERS 4
+#endif
+
+/** Trigger events queued per instance, when triggers have no callback */
+#if !defined(TRIGGER_QUEUE_SIZE)
+    #define TRIGGER_QUEUE_SIZE 8
+#endif
+
+/** Readings kept before the trigger, in a capture snapshot */
+#if !defined(CAPTURE_PRE_SAMPLES)
+    #define CAPTURE_PRE_SAMPLES 16
+#endif
+
+/** Readings captured after the trigger, in a capture snapshot */
+#if !defined(CAPTURE_POST_SAMPLES)
+    #define CAPTURE_POST_SAMPLES 48
+#endif
+
 /** Sets the microcontroller ADC resolution in bits */
 typedef enum : uint16_t {
 	bits10 = 1023,			///< ADC max resolution is 10 bits
@@ -68,8 +207,34 @@ typedef enum : uint16_t {
 typedef enum : uint16_t {
 	linear_decay,			///< Peak value decay - linear
 	exponential_decay,		///< Peak value decay - exponentially
+	envelope_decay,			///< Attack/release envelope follower, per reading
 } DecayModelType_e;
 
+//-----------------------------------------------------------------------------
+/** ADC acquisition modes for the averaging ('sample_count' > 0) readings */
+typedef enum : uint16_t {
+	blocking_average,		///< All samples are read in one call (delays)
+	incremental_average,	///< At most one ADC conversion per call
+	interrupt_driven,		///< Samples pushed (ISR) with pushSample()
+} AcquisitionModeType_e;
+
+//-----------------------------------------------------------------------------
+/** Trigger conditions, on the readings (before the moving average) */
+typedef enum : uint8_t {
+	rising_trigger,			///< Reading at or above the threshold
+	falling_trigger,		///< Reading below the threshold
+	window_trigger,			///< Reading outside the low/high window
+	slope_trigger,			///< Step from the previous reading (< 0: falling)
+} TriggerType_e;
+
+//-----------------------------------------------------------------------------
+/** Trigger states */
+typedef enum : uint8_t {
+	trigger_idle,			///< Condition is false
+	trigger_pending,		///< Condition is true, for less than the min duration
+	trigger_active,			///< Fired, until released by the hysteresis band
+} TriggerStateType_e;
+
 //-----------------------------------------------------------------------------
 /*!
     @brief  Unique EEPROM Id and code version.
@@ -93,6 +258,7 @@ typedef struct {
     uint16_t sample_period;     ///< Averaging time window
     float cal_zero_offset;      ///< ADC zero offset value (mV)
     float cal_slope;            ///< Multiplication factor to adjust ADC reading
+    uint16_t window_size;       ///< Moving average window (number of polls)
 } CalibrationDataType_t;
 
 //-----------------------------------------------------------------------------
@@ -106,9 +272,130 @@ typedef struct {
     uint16_t ms_poll_time;                  ///< Instant poll time (milliseconds)
     uint16_t ms_hold_time;                  ///< Sample hold time (milliseconds)
     DecayModelType_e decay_model;           ///< Linear or exponetial model
-    float decay_rate;                       ///< Set sample decay factor
+    float decay_rate;                       ///< Decay factor (linear: < 1)
+    AcquisitionModeType_e acquisition_mode; ///< Blocking or incremental averaging
+    uint16_t ms_attack_time;                ///< Envelope rise time constant (ms)
+    uint16_t ms_release_time;               ///< Envelope fall time constant (ms)
 } DynamicDataType_t;
 
+//-----------------------------------------------------------------------------
+/*!
+    @brief  Energy/charge integral, also the EEPROM checkpoint record.
+*/
+//-----------------------------------------------------------------------------
+typedef struct {
+    uint64_t q16_area;          ///< Twice the integral, Q16.16 mV times ms
+    uint64_t ms_elapsed;        ///< Integrated time (milliseconds)
+} IntegratorDataType_t;
+
+//-----------------------------------------------------------------------------
+/*!
+    @brief  Instrumentation counters of an instance ('SENSOR_INSTRUMENTATION').
+*/
+//-----------------------------------------------------------------------------
+typedef struct {
+    uint32_t update_count;          ///< Calls to updateAnalogRead()
+    uint32_t reading_count;         ///< New readings, i.e. polls
+    uint32_t missed_deadline_count; ///< Polls a whole 'ms_poll_time' late
+    uint32_t ms_jitter_sum;         ///< Sum of the poll lateness (milliseconds)
+    uint32_t ms_jitter_max;         ///< Largest poll lateness (milliseconds)
+    uint32_t adc_conversion_count;  ///< ADC conversions (analogRead)
+    uint32_t decay_tick_count;      ///< Elapsed hold periods, i.e. peak decays
+    uint32_t eeprom_read_count;     ///< EEPROM records read
+    uint32_t eeprom_write_count;    ///< EEPROM records staged (changed)
+    uint64_t us_update_sum;         ///< Time in updateAnalogRead() (microseconds)
+    uint32_t us_update_max;         ///< Longest updateAnalogRead() (microseconds)
+    uint32_t us_begin_time;         ///< Time of the last begin() (microseconds)
+    uint32_t update_histogram[INSTRUMENT_BUCKETS]; ///< updateAnalogRead() times, 
+                                    ///< bucket 0: below 1 us, n: below 2^n us
+} InstrumentationType_t;
+
+//-----------------------------------------------------------------------------
+/*!
+    @brief  Instrumentation counters shared by all instances.
+*/
+//-----------------------------------------------------------------------------
+typedef struct {
+    uint32_t eeprom_commit_count;   ///< Calls to commitEEPROM()
+    uint32_t eeprom_write_count;    ///< Common records staged (version)
+    uint32_t us_commit_sum;         ///< Time in commitEEPROM() (microseconds)
+    uint32_t us_commit_max;         ///< Longest commitEEPROM() (microseconds)
+} SharedInstrumentationType_t;
+
+//-----------------------------------------------------------------------------
+/*!
+    @brief  Statistics of the readings in a window, mapped to mV.
+*/
+//-----------------------------------------------------------------------------
+typedef struct {
+    double mean;                ///< Mean value (mV)
+    double rms;                 ///< Root mean square value (mV)
+    double min;                 ///< Smallest reading (mV)
+    double max;                 ///< Largest reading (mV)
+    double variance;            ///< Population variance (mV^2)
+    uint32_t count;             ///< Number of readings, 0: no statistics yet
+} StatisticsType_t;
+
+//-----------------------------------------------------------------------------
+/*!
+    @brief  Exact integer sums of raw readings, for the statistics.
+*/
+//-----------------------------------------------------------------------------
+typedef struct {
+    uint64_t sum;               ///< Sum of the readings
+    uint64_t sq_sum;            ///< Sum of the squared readings
+    uint32_t count;             ///< Number of readings
+    uint16_t min;               ///< Smallest reading
+    uint16_t max;               ///< Largest reading
+    int64_t mapped_sum;         ///< Sum of the mapped readings (1/256 mV), multi-point calibration
+    uint64_t mapped_sq_sum;     ///< Sum of the squared mapped readings (1/65536 mV^2)
+} StatisticsSumType_t;
+
+//-----------------------------------------------------------------------------
+/*!
+    @brief  A fired, or released, trigger.
+*/
+//-----------------------------------------------------------------------------
+typedef struct {
+    uint32_t ms_time;           ///< millis() time of the reading
+    double mv_value;            ///< The reading (mV)
+    uint16_t raw_value;         ///< The reading, at bits capability
+    uint8_t trigger;            ///< Trigger index, from addTrigger()
+    bool is_active;             ///< True when fired, false when released
+} TriggerEventType_t;
+
+//-----------------------------------------------------------------------------
+/*!
+    @brief  Readings around a trigger, in time order.
+*/
+//-----------------------------------------------------------------------------
+typedef struct {
+    uint16_t raw_value[CAPTURE_PRE_SAMPLES + CAPTURE_POST_SAMPLES];///< Readings
+    uint32_t ms_time[CAPTURE_PRE_SAMPLES + CAPTURE_POST_SAMPLES];  ///< Reading times
+    uint16_t count;             ///< Number of readings
+    uint16_t trigger_position;  ///< Index of the trigger reading
+    uint16_t pk_raw_value;      ///< Largest reading
+    uint8_t trigger;            ///< Trigger index, from addTrigger()
+    uint32_t sequence;          ///< Increases with each completed capture
+} CaptureType_t;
+
+/** Called with each event of a trigger */
+typedef void (*TriggerCallbackType_t)(TriggerEventType_t const &rEvent);
+
+//-----------------------------------------------------------------------------
+/*!
+    @brief  Trigger setup.
+*/
+//-----------------------------------------------------------------------------
+typedef struct {
+    TriggerType_e type;                 ///< Rising, falling, or window
+    float mv_threshold;                 ///< Threshold, or window low limit (mV)
+    float mv_threshold_high;            ///< Window high limit (mV)
+    float mv_hysteresis;                ///< Release band inside the threshold (mV)
+    uint16_t ms_min_duration;           ///< Condition must hold this long to fire
+    TriggerCallbackType_t callback;     ///< Called on events, nullptr: event queue
+} TriggerDataType_t;
+
 //-----------------------------------------------------------------------------
 /*!
     @brief  Track instant and peak DC ADC input readings.
@@ -124,7 +411,7 @@ public:
 
     // Constructor, default: no calibration or averaging smooting are applied
     SensorWLED(uint16_t analog_pin, float mv_offset = 0.0, float slope = 1.0, 
-                                                        uint16_t samples = 0 );
+                                    uint16_t samples = 0, uint16_t window = 0 );
     
     // Destructor: Restore pinMode to default
 	~SensorWLED(void);
@@ -138,6 +425,71 @@ public:
     // for ADC resolution and max supply voltage.
 	double getMappedValue(void);
 	double getMappedPeakValue(void);
+    double getMappedWindowPeakValue(void);
+
+    // The unmapped codes, at getCodeMax() scale (e.g. for telemetry).
+    uint16_t getRawValue(void);
+    uint16_t getRawPeakValue(void);
+
+    // Statistics of the last completed tumbling window, and the moving window
+    // ('SENSOR_MOVING_WINDOW').
+    StatisticsType_t getWindowStatistics(void);
+    StatisticsType_t getSlidingStatistics(void);
+
+    // Trapezoidal integral of the mapped value over time (e.g. mAh, mWh).
+    double getCharge(void);
+    double getEnergy(float mv_supply);
+    double getIntegratedSeconds(void);
+    void resetIntegral(void);
+    void setCheckpointInterval(uint16_t minutes);
+
+    // Quantiles (e.g. 0.95) of the instant and peak values, in mV ('SENSOR_QUANTILES').
+    double getQuantile(double q);
+    double getPeakQuantile(double q);
+    void resetStatistics(void);
+
+    // Threshold triggers, evaluated for each reading ('SENSOR_TRIGGERS').
+    int16_t addTrigger(TriggerDataType_t const &rTrigger);
+    void clearTriggers(void);
+    bool isTriggerActive(uint8_t trigger);
+    bool readTriggerEvent(TriggerEventType_t &rEvent);
+
+    // Pre/post-trigger capture of the readings around a trigger ('SENSOR_CAPTURE').
+    bool armCapture(uint8_t trigger);
+    void disarmCapture(void);
+    const CaptureType_t *readCapture(void);
+    uint32_t getCaptureOverrunCount(void);
+
+    // Process a block of converted samples (e.g. ESP32 continuous ADC mode).
+    bool processBlock(const uint16_t* codes, size_t n, uint32_t t0_us, uint32_t dt_us);
+
+    // Call from a timer ISR (or another thread) in 'interrupt_driven' mode ('SENSOR_SAMPLE_QUEUE').
+    void IRAM_ATTR pushSample(uint16_t code);
+    uint32_t getSampleOverflowCount(void);
+
+    // Stable channel id (1..MAX_CHANNELS), assigned at the first begin().
+    uint16_t getChannelId(void);
+
+    // Virtual channel behind an analog multiplexer on 'analog_pin'.
+    void setMuxSelect(void (*select)(uint16_t mux_channel), uint16_t mux_channel);
+
+    // Oversampling CIC/FIR filter instead of the average (before begin()).
+    void setDecimation(uint8_t log2_ratio, uint8_t extra_bits);
+    uint32_t getCodeMax(void);
+
+    // Piecewise-linear calibration, replaces the slope and offset (before begin()).
+    bool setCalibrationPoints(const CalibrationPointType_t *pPoints, uint8_t count);
+    size_t getCalibrationTableSize(void);
+    uint32_t getCalibrationTableBuildTime(void);
+    CalibrationTableStatusType_e getCalibrationTableStatus(void);
+
+    // Counters of 'SENSOR_INSTRUMENTATION', all zero without it.
+    InstrumentationType_t getInstrumentation(void);
+    void resetInstrumentation(void);
+
+    // Each reading (before the moving average) is also passed to 'tap'.
+    void setReadingTap(void (*tap)(uint16_t raw_value, uint32_t reading_millis,
+                            void *context), void *context);
 
 
     // Read stored EEPROM Id and program version.
@@ -149,14 +501,19 @@ public:
     bool writeDynamicEEPROM(uint16_t instance, uint32_t crc32);
     DynamicDataType_t readDynamicEEPROM(uint16_t instance);
 
+    bool writeCalibrationPointsEEPROM(uint16_t instance, uint32_t crc32);
+    CalibrationPointsType_t readCalibrationPointsEEPROM(uint16_t instance);
+
     uint32_t calculateCalibrationDataCRC32(CalibrationDataType_t CalibrationData);
     uint32_t calculateDynamicParamsCRC32(DynamicDataType_t DynamicParams);
+    uint32_t calculateCalibrationPointsCRC32(CalibrationPointsType_t const &rPoints);
 
     uint32_t cal_crc32;      ///< CRC32 sum of stored EEPROM (begin) calibration data
     uint32_t dyn_crc32;      ///< CRC32 sum of stored EEPROM (begin) dynamic data
 
     CalibrationDataType_t CalibrationData;  ///< ADC channel setup and calibration
     DynamicDataType_t DynamicParams;        ///< Static and dynamic setup parameters
+    CalibrationPointsType_t CalibrationPoints; ///< Multi-point calibration, if any
 
 
     // -------------------------------------------------------
@@ -164,39 +521,234 @@ public:
     // -------------------------------------------------------
     static uint16_t getInstanceNumber(void);
 
-    // Each instance has its own 'emulated eeprom' flash area
-    // storing calibration, static, and dynamic parameters.
-    // Note: 0x100 is for the first instance, 0x200 for the second,
-    // 0x0 is an unused area (reseved for the future).
-    inline static uint16_t eeprom_area[MAXINSTANCES+1] = 
-        {0,0x100,0x200,0x300,0x400,0x500,0x600,0x700,0x800,0x900,0xA00};
-                          ///< Emulated EEPROM areas for each instance
- 
-    // Id and program version is stored at location 'EEPROM_IDSTART'.
+    // Channel registry, lookup by id.
+    static SensorWLED *getChannel(uint16_t id);
+    static size_t getChannelRAMSize(void);
+    static size_t getChannelStorageSize(void);
+    static SharedInstrumentationType_t getSharedInstrumentation(void);
+
+    static uint32_t calculateCRC32(const void* buf, size_t len, uint32_t initial = 0);
+
+    // Writes all staged EEPROM changes, of all instances, in one commit.
+    static bool commitEEPROM(void);
+
+    // Decay model helpers, also used by the multi-channel SensorArray.
+    static float validateDecayRate(DecayModelType_e decay_model, float decay_rate);
+    static void generateDecayTable(uint32_t (&table)[DECAY_TABLE_SIZE],
+                            DecayModelType_e decay_model, float decay_rate);
+    static uint32_t applyDecayTable(const uint32_t (&table)[DECAY_TABLE_SIZE],
+                            uint32_t peak_value, uint32_t hold_periods);
+
+    // Version, calibration, and dynamic parameters of all instances
+    // are records in one append-only (wear-leveled) log.
+    inline static ConfigStore config_store; ///< Emulated EEPROM record log
+
+    // Id and program version is stored as a common (id 0) record.
     inline static VersionType_t Version = 
              {EEPROM_ID, VERSION_MAJOR, VERSION_MINOR, VERSION_PATCH};
                         ///< Program version stored in emulated EEPROM
 
-    inline static uint16_t instance_counter = 0; ///< Number of instances
+    inline static uint16_t instance_counter = 0; ///< Number of registered instances
+
+#if SENSOR_INSTRUMENTATION
+    inline static SharedInstrumentationType_t SharedInstrumentation = {};
+                        ///< Counters of all instances, e.g. EEPROM commits
+#endif
+
+    inline static SensorWLED *channel_registry[MAX_CHANNELS + 1] = {};
+                        ///< Instance of each channel id, [0] is unused
 
-private:
+protected:
 
 	void setAnalogPin(uint16_t a_pin, uint16_t mode = INPUT);
-    uint32_t applyDecay(uint32_t peak_value);
+    bool registerChannel(void);
+    uint16_t readADC(void);
+    uint32_t applyDecay(uint32_t peak_value, uint32_t hold_periods);
+    uint32_t elapsedHoldPeriods(uint32_t current_millis);
+    template <typename MapHook, typename DecayHook>
+    bool pollAnalogRead(MapHook mapValue, DecayHook decayValue);
+    void setDecayTable(void);
+    void setEnvelopeTables(void);
+    void updateEnvelope(uint32_t raw_value, uint32_t reading_us);
+    static void generateEnvelopeTable(uint32_t (&table)[ENVELOPE_TABLE_SIZE],
+                            uint16_t ms_time_constant);
+    static uint32_t envelopeFactor(const uint32_t (&table)[ENVELOPE_TABLE_SIZE],
+                            uint32_t elapsed_us);
+
+    bool acquireRawValue(uint32_t current_millis);
+    bool acquireBlockingAverage(void);
+    bool acquireIncrementalAverage(uint32_t current_millis);
+#if SENSOR_SAMPLE_QUEUE
+    bool acquireQueuedSamples(void);
+#endif
+    bool accumulateSample(uint16_t code);
+    void trackReading(uint32_t reading_millis, uint16_t reading_frac_us = 0);
+    bool processSegment(const uint16_t* codes, size_t n, uint32_t t0_millis,
+                            uint64_t t_us, uint32_t dt_us);
+    uint64_t unwrapBlockTime(uint32_t t0_us);
+    void processReading(uint16_t raw_value, uint32_t reading_millis);
+#if SENSOR_TRIGGERS
+    void evaluateTriggers(uint16_t raw_value, uint32_t reading_millis);
+    void fireTrigger(uint8_t trigger, bool is_active, uint16_t raw_value, 
+                            uint32_t reading_millis);
+    void setTriggerCodes(void);
+    uint32_t thresholdCode(float mv_value);
+#endif
+#if SENSOR_CAPTURE
+    void captureReading(uint16_t raw_value, uint32_t reading_millis);
+    void startCapture(uint8_t trigger);
+#endif
+    void updateMappedValues(void);
+    int32_t mapRawValue(uint32_t raw_value);
+    void setFixedPointParams(void);
+#if SENSOR_MOVING_WINDOW
+    void updateWindow(uint16_t raw_value);
+    void updateWindowQueue(uint16_t *queue, uint16_t &rFirst, uint16_t &rCount, 
+                            uint16_t raw_value, bool is_max);
+#endif
+    void integrateValue(uint32_t current_millis);
+    void writeCheckpoint(void);
+#if SENSOR_QUANTILES
+    void updateHistograms(void);
+    void updateHistograms(const uint16_t* codes, size_t n);
+#endif
+    void updateStatistics(uint16_t raw_value);
+    void updateStatistics(const uint16_t* codes, size_t n);
+    void addMappedStatistics(StatisticsSumType_t &rSums, uint16_t raw_value);
+    StatisticsType_t calculateStatistics(StatisticsSumType_t const &rSums);
 
 	uint32_t previous_poll_millis_tm;    ///< Holds previous ADC poll time
     uint32_t previous_hold_millis_tm;    ///< Holds previous ADC hold time
+    uint32_t previous_sample_micros_tm;  ///< Holds previous incremental ADC sample time
+
+    uint32_t accumulated_raw_value;    ///< Running sum of incremental ADC readings
+    uint16_t accumulated_count;        ///< Number of readings in the running sum
 
 	uint32_t raw_input_value;          ///< ADC raw input at bits capability
-	double mapped_input_value;       ///< ADC values mapped to VCC range
+	int32_t mapped_input_value;        ///< ADC values mapped to VCC range (Q16.16)
 
 	uint32_t pk_raw_input_value;       ///< ADC peak input at bits capability
-	double pk_mapped_input_value;      ///< ADC peak mapped to VCC range
+	int32_t pk_mapped_input_value;     ///< ADC peak mapped to VCC range (Q16.16)
+
+    // Calibration, precomputed in begin() for integer-only math
+    int32_t q16_cal_slope;             ///< 'cal_slope' in Q16.16
+    int32_t q16_cal_zero_offset;       ///< 'cal_zero_offset' (mV) in Q16.16
+
+    // Multi-point calibration, expanded in begin() to a value per code
+    void buildCalibrationTable(void);
+
+    CalibrationTable calibration_table;        ///< Shared value per native code
+    CalibrationTableStatusType_e cal_table_status; ///< How the points are mapped
+    uint32_t us_cal_table_build_time;  ///< Time to build the table (microseconds)
+
+    uint32_t q16_decay_table[DECAY_TABLE_SIZE]; ///< Decay factor^n in Q16.16
+
+    // Envelope follower (envelope_decay), updated with each reading
+    uint32_t q30_attack_table[ENVELOPE_TABLE_SIZE]; ///< Rise factor for 2^n us
+    uint32_t q30_release_table[ENVELOPE_TABLE_SIZE];///< Fall factor for 2^n us
+    uint32_t q16_envelope_value;        ///< Envelope of the readings (Q16.16 raw)
+    uint32_t previous_envelope_us_tm;   ///< Holds previous envelope reading time
+    bool envelope_started_flag;         ///< There is a previous reading
+
+#if SENSOR_MOVING_WINDOW
+    // Moving average and moving max over the last 'window_size' polls
+    uint16_t window_buffer[MAX_WINDOW_SIZE];   ///< Ring buffer of raw readings
+    uint16_t window_max_queue[MAX_WINDOW_SIZE];///< Buffer positions, decreasing values
+    uint16_t window_min_queue[MAX_WINDOW_SIZE];///< Buffer positions, increasing values
+    uint32_t window_sum;                ///< Running sum of the ring buffer
+    uint64_t window_sq_sum;             ///< Running sum of squares of the ring buffer
+    uint16_t window_head;               ///< Next ring buffer write position
+    uint16_t window_fill;               ///< Number of readings in the ring buffer
+    uint16_t window_max_first;          ///< Moving max queue, first position
+    uint16_t window_max_count;          ///< Moving max queue, number of entries
+    uint16_t window_min_first;          ///< Moving min queue, first position
+    uint16_t window_min_count;          ///< Moving min queue, number of entries
+#endif
 
-    // EEPROM and CRC32 methods
-    static void generateTableCRC32(uint32_t(&table)[CRC32_TABLE_SIZE]);
-    static uint32_t updateCRC32(uint32_t (&table)[CRC32_TABLE_SIZE], 
-                          uint32_t initial, const void* buf, size_t len);
+    // Energy/charge integral, updated with each new reading
+    IntegratorDataType_t Integral;      ///< Integral since start, or reset
+    uint32_t previous_integral_millis_tm; ///< Holds previous integrated reading time
+    int32_t previous_integral_value;    ///< Previous integrated reading (Q16.16 mV)
+    bool integral_started_flag;         ///< There is a previous reading
+    uint16_t checkpoint_minutes;        ///< EEPROM checkpoint interval, 0: off
+    uint32_t previous_checkpoint_millis_tm; ///< Holds previous checkpoint time
+
+    // processBlock() time line, without the 32-bit micros() wraparound
+    uint64_t block_us_tm;               ///< Unwrapped time of the last block start
+    uint32_t previous_block_t0_us;      ///< Holds previous block start (micros())
+    bool block_started_flag;            ///< There is a previous block
+
+    uint8_t trigger_count;              ///< Added triggers, 0 without SENSOR_TRIGGERS
+
+#if SENSOR_TRIGGERS
+    // Triggers, with the thresholds as raw codes (set by begin())
+    TriggerDataType_t Triggers[MAX_TRIGGERS];   ///< Trigger setup
+    uint32_t trigger_on_code[MAX_TRIGGERS];     ///< Fires at (or, falling, below)
+    uint32_t trigger_off_code[MAX_TRIGGERS];    ///< Releases below (falling, at)
+    uint32_t trigger_high_on_code[MAX_TRIGGERS];///< Window: fires at or above
+    uint32_t trigger_high_off_code[MAX_TRIGGERS];///< Window: releases below
+    uint32_t trigger_since_millis_tm[MAX_TRIGGERS]; ///< Holds pending start time
+    TriggerStateType_e trigger_state[MAX_TRIGGERS]; ///< Idle, pending, or active
+    uint16_t trigger_previous_value;    ///< Previous reading, for slope triggers
+    bool trigger_previous_flag;         ///< There is a previous reading
+
+    TriggerEventType_t trigger_events[TRIGGER_QUEUE_SIZE]; ///< Event ring buffer
+    uint8_t trigger_event_first;        ///< Oldest queued event
+    uint8_t trigger_event_count;        ///< Queued events
+#endif
+
+#if SENSOR_CAPTURE
+    // Capture: a pre-trigger ring, and two snapshots, one filled while
+    // the other is read.
+    uint16_t capture_pre_raw[CAPTURE_PRE_SAMPLES];  ///< Ring of recent readings
+    uint32_t capture_pre_ms[CAPTURE_PRE_SAMPLES];   ///< Ring of reading times
+    uint16_t capture_pre_head;          ///< Next ring write position
+    uint16_t capture_pre_fill;          ///< Readings in the ring
+    CaptureType_t Captures[2];          ///< Snapshot buffers
+    int8_t capture_trigger;             ///< Armed trigger, -1: disarmed
+    int8_t capture_fill;                ///< Snapshot being filled, -1: none
+    int8_t capture_ready;               ///< Completed unread snapshot, -1: none
+    int8_t capture_read;                ///< Snapshot held by the reader, -1: none
+    uint32_t capture_sequence;          ///< Completed captures
+    uint32_t capture_overrun_count;     ///< Unread snapshots overwritten
+#endif
+
+#if SENSOR_QUANTILES
+    // Distributions of the instant and peak values, for quantiles
+    LogHistogram<HISTOGRAM_SUB_BITS> instant_histogram; ///< Instant raw values
+    LogHistogram<HISTOGRAM_SUB_BITS> peak_histogram;    ///< Peak raw values
+#endif
+
+    // Tumbling window statistics, converted to mV only when read
+    StatisticsSumType_t stats_sums;     ///< Sums of the current window
+    StatisticsSumType_t stats_last_sums;///< Sums of the last completed window
+
+#if SENSOR_SAMPLE_QUEUE
+    SampleQueue<SAMPLE_QUEUE_SIZE> sample_queue; ///< ISR to loop() raw samples
+#endif
+
+    // Decimation filter, replaces the averaging when enabled
+    Decimator<CIC_ORDER> decimator;     ///< CIC and compensating FIR
+    uint8_t decimation_log2_ratio;      ///< Requested ratio (log2), 0: off
+    uint8_t decimation_extra_bits;      ///< Requested extra resolution (bits)
+
+    uint16_t channel_id;                ///< Registry id, 0: not registered
+    void (*mux_select)(uint16_t mux_channel);   ///< Analog mux select, or nullptr
+    uint16_t mux_channel;               ///< Analog mux input of this channel
+
+    void (*reading_tap)(uint16_t raw_value, uint32_t reading_millis, void *context);
+                                        ///< Reading consumer, or nullptr
+    void *reading_tap_context;          ///< Passed to 'reading_tap'
+
+#if SENSOR_INSTRUMENTATION
+    void countUpdate(uint32_t us_start_time);
+    void countReading(uint32_t reading_millis);
+
+    InstrumentationType_t Instrumentation;  ///< Counters of this instance
+    uint32_t previous_reading_millis_tm;    ///< Time of the last reading
+#endif
+
+    // EEPROM methods
     static bool writeVersionEEPROM(void);
 
     static bool inline eeprom_version_written_flag = false; ///< EEPROM write flag
@@ -204,4 +756,55 @@ private:
 };
 /* class SensorWLED */
 
+//-----------------------------------------------------------------------------
+/*!
+ @brief  The steps of one updateAnalogRead() call, with the mapping and the
+         peak decay as inline hooks, i.e. SensorWLEDStatic passes its
+         compile-time map and decay table without a virtual call.
+
+ @param  mapValue
+         int32_t (uint32_t raw_value), the mapped value (mV) in Q16.16.
+ @param  decayValue
+         uint32_t (uint32_t peak_value, uint32_t hold_periods), the decayed
+         peak value.
+ @return Returns true when a new value is available.
+ */
+//-----------------------------------------------------------------------------
+template <typename MapHook, typename DecayHook>
+bool SensorWLED::pollAnalogRead(MapHook mapValue, DecayHook decayValue) {
+
+    INSTRUMENT(uint32_t us_start_time = micros());
+
+    // Deferred from begin(), one commit for all instances
+    if (config_store.isDirty()) {
+        commitEEPROM();
+    }
+
+    // Check to see if it's time to read from the analog input
+    uint32_t current_millis = millis();
+
+    //
+    // Decay the peak value, depending on the hold time (not the poll time)
+    //
+    uint32_t hold_periods = elapsedHoldPeriods(current_millis);
+    if (hold_periods > 0) {
+        pk_raw_input_value = decayValue(pk_raw_input_value, hold_periods);
+    }
+
+    //
+    // Get a new input value (poll time)
+    //
+    if (acquireRawValue(current_millis) == false) {
+        INSTRUMENT(countUpdate(us_start_time));
+        return false;
+    }
+    INSTRUMENT(countReading(current_millis));
+
+    mapped_input_value = mapValue(raw_input_value);
+    integrateValue(current_millis);
+
+    INSTRUMENT(countUpdate(us_start_time));
+    return true;
+}
+
 #endif /* SENSORWLED_H_ */
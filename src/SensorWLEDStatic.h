@@ -0,0 +1,177 @@
+/*!
+ * @file SensorWLEDStatic.h
+ *
+ * This is part of SensorWLED library for the Arduino platform.
+ * Source: https://github.com/berrak/SensorWLED
+ *
+ * The MIT license.
+ *
+ */
+#ifndef SENSORWLEDSTATIC_H_
+#define SENSORWLEDSTATIC_H_
+
+#include "SensorWLED.h"
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Compile-time exp(-x), with range reduction e^-x = (e^(-x/16))^16.
+
+ @param  x
+         Non-negative exponent.
+ @return The value of exp(-x).
+ */
+//-----------------------------------------------------------------------------
+constexpr double staticExpNegative(double x) {
+
+    double y = -x / 16;
+    double term = 1.0;
+    double sum = 1.0;
+    for (int n = 1; n < 20; n++) {
+        term *= y / n;
+        sum += term;
+    }
+    for (int n = 0; n < 4; n++) {
+        sum *= sum;
+    }
+    return sum;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+    @brief  Compile-time decay factor^n table (Q16.16), for 0..
+            DECAY_TABLE_SIZE-1 elapsed hold periods.
+*/
+//-----------------------------------------------------------------------------
+template <DecayModelType_e MODEL, uint16_t DECAY_RATE_PERMILLE>
+struct StaticDecayTableType_t {
+
+    /** The decay multiplication factor, for one hold time period */
+    static constexpr double decay_factor = (MODEL == linear_decay) ?
+        DECAY_RATE_PERMILLE / 1000.0 : staticExpNegative(DECAY_RATE_PERMILLE / 1000.0);
+
+    uint32_t q16[DECAY_TABLE_SIZE];   ///< Decay factor^n in Q16.16
+
+    constexpr StaticDecayTableType_t() : q16() {
+        double factor = 1.0;
+        for (uint16_t cnt = 0; cnt < DECAY_TABLE_SIZE; cnt++) {
+            q16[cnt] = (uint32_t) (factor * Q16_ONE + 0.5);
+            factor *= decay_factor;
+        }
+    }
+};
+
+//-----------------------------------------------------------------------------
+/*!
+    @brief  SensorWLED with a compile-time fixed ADC resolution, VCC, and
+            decay model.
+
+            The scale and the decay table are constexpr values, and the
+            unused decay model is never compiled. Switch a sketch with a
+            one-line change, e.g.:
+
+            SensorWLEDStatic<bits12, mv_vcc_3v3, exponential_decay> ProbeOne(33);
+
+            The 'decay_rate' is given in 1/1000 units (default 1000, i.e. 1.0).
+            The same fields in the DynamicDataType_t struct given to begin()
+            are replaced with the template values.
+*/
+//-----------------------------------------------------------------------------
+template <AdcResolutionType_e BITS, VoltageVccType_e VCC, DecayModelType_e MODEL,
+                                            uint16_t DECAY_RATE_PERMILLE = 1000>
+class SensorWLEDStatic : public SensorWLED {
+
+    static_assert(MODEL == linear_decay || MODEL == exponential_decay,
+                    "Unsupported decay model");
+    static_assert(MODEL != linear_decay || DECAY_RATE_PERMILLE < 1000,
+                    "Linear decay rate must be less than one (1000)");
+
+public:
+
+    using SensorWLED::SensorWLED;
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Applies user parameters, with the template values.
+
+     @param  UserDynamicParams
+             Takes a DynamicDataType_t' structure and loads it into memory.
+     */
+    //-------------------------------------------------------------------------
+    void begin(DynamicDataType_t const &UserDynamicParams) {
+
+        DynamicDataType_t StaticParams = UserDynamicParams;
+        StaticParams.bits_resolution_adc = BITS;
+        StaticParams.mv_maxvoltage_adc = VCC;
+        StaticParams.decay_model = MODEL;
+        StaticParams.decay_rate = decay_rate;
+
+        SensorWLED::begin(StaticParams);
+    }
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Call continously (in loop()) for updated values.
+     @return Returns true when a new value is available.
+     */
+    //-------------------------------------------------------------------------
+    bool updateAnalogRead(void) {
+
+        return pollAnalogRead(
+            [this](uint32_t raw_value) { return mapStaticRawValue(raw_value); },
+            [](uint32_t peak_value, uint32_t hold_periods) {
+                return applyDecayTable(decay_table.q16, peak_value, hold_periods);
+            });
+    }
+
+private:
+
+    /** Decay rate as given in the DynamicDataType_t struct */
+    static constexpr float decay_rate = DECAY_RATE_PERMILLE / 1000.0f;
+
+    /** Decay factor^n for 0..DECAY_TABLE_SIZE-1 hold periods */
+    static constexpr StaticDecayTableType_t<MODEL, DECAY_RATE_PERMILLE> decay_table{};
+
+    //-------------------------------------------------------------------------
+    /*!
+     @brief  Maps a raw ADC value with the compile-time resolution and VCC
+             (the division by a constant compiles to a multiplication), and
+             applies the slope and zero offset calibration. Decimated codes
+             (extra bits, a code range set at run time) and a multi-point
+             calibration are mapped as the peak values, i.e. by the table.
+     @param  raw_value
+             Raw ADC value at getCodeMax() scale.
+     @return The calibrated value (mV) in Q16.16.
+     */
+    //-------------------------------------------------------------------------
+    int32_t mapStaticRawValue(uint32_t raw_value) {
+
+        if (decimator.getExtraBits() > 0 || CalibrationPoints.point_count >= 2) {
+            return mapRawValue(raw_value);
+        }
+#if FIXED_POINT_MATH
+        int64_t mv_value = (int64_t) ((raw_value * (uint64_t) VCC) / BITS);
+        mv_value *= q16_cal_slope;
+
+        if (q16_cal_zero_offset <= mv_value) {
+            mv_value -= q16_cal_zero_offset;
+        } else {
+            mv_value = 0;
+        }
+        return (int32_t) mv_value;
+#else
+        double mv_value = (double) ((raw_value * (uint32_t) VCC) / BITS);
+        mv_value *= CalibrationData.cal_slope;
+
+        if (CalibrationData.cal_zero_offset <= mv_value) {
+            mv_value -= CalibrationData.cal_zero_offset;
+        } else {
+            mv_value = 0;
+        }
+        return (int32_t) lround(mv_value * Q16_ONE);
+#endif
+    }
+
+};
+/* class SensorWLEDStatic */
+
+#endif /* SENSORWLEDSTATIC_H_ */
@@ -0,0 +1,224 @@
+/*!
+ * @file Telemetry.cpp
+ *
+ * This is part of SensorWLED library for the Arduino platform.
+ * Source: https://github.com/berrak/SensorWLED
+ *
+ * The MIT license.
+ *
+ */
+#ifdef ARDUINO
+// Required includes for Arduino libraries always go first.
+#include <Arduino.h>
+#endif
+
+#include "Telemetry.h"
+
+#include <string.h>
+
+static_assert(TELEMETRY_FRAME_SIZE >= 32 && TELEMETRY_FRAME_SIZE <= 16383 + 8,
+                                        "Use a frame size of 32 to 16391 bytes");
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Constructor, with an empty frame.
+ */
+//-----------------------------------------------------------------------------
+TelemetryEncoder::TelemetryEncoder(void) {
+
+    frame_sequence = 0;
+    clear();
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Drops the records of the current frame.
+ */
+//-----------------------------------------------------------------------------
+void TelemetryEncoder::clear(void) {
+
+    body_end = HEADER_SIZE;
+    frame_start = 0;
+    frame_length = 0;
+    record_count = 0;
+    previous_ms_time = 0;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Adds the current raw and peak codes of a sensor, at millis().
+
+ @param  rSensor
+         The sensor, with a channel id (after begin()).
+ @return true if added, false if the frame is full.
+ */
+//-----------------------------------------------------------------------------
+bool TelemetryEncoder::add(SensorWLED &rSensor) {
+    return add(rSensor.getChannelId(), millis(), rSensor.getRawValue(), 
+                                                    rSensor.getRawPeakValue());
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Adds a record. A sealed frame is replaced by a new one.
+
+ @param  channel_id
+         Channel id (0..MAX_CHANNELS have delta coded raw codes).
+ @param  ms_time
+         Time of the reading (milliseconds).
+ @param  raw_value
+         Raw code.
+ @param  pk_raw_value
+         Peak raw code.
+ @return true if added, false if the frame is full.
+ */
+//-----------------------------------------------------------------------------
+bool TelemetryEncoder::add(uint16_t channel_id, uint32_t ms_time, 
+                                    uint16_t raw_value, uint16_t pk_raw_value) {
+
+    if (frame_length > 0) {
+        frame_sequence++;
+        clear();
+    }
+    if (record_count == 0) {
+        startFrame(ms_time);
+    }
+
+    // Room for the record and the CRC32
+    if (body_end + TELEMETRY_MAX_RECORD + sizeof(uint32_t) > TELEMETRY_FRAME_SIZE) {
+        return false;
+    }
+
+    uint16_t previous_raw = 0;
+    if (channel_id <= MAX_CHANNELS) {
+        previous_raw = previous_raw_value[channel_id];
+        previous_raw_value[channel_id] = raw_value;
+    }
+
+    putVarint(channel_id);
+    putVarint(ms_time - previous_ms_time);
+    putZigZag((int32_t) raw_value - previous_raw);
+    putZigZag((int32_t) pk_raw_value - raw_value);
+
+    previous_ms_time = ms_time;
+    record_count++;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Seals the frame, i.e. adds the header and the CRC32.
+
+ @return Frame size (bytes), or 0 without new records, i.e. nothing to send
+         (a sealed frame is sent once).
+ */
+//-----------------------------------------------------------------------------
+size_t TelemetryEncoder::finish(void) {
+
+    if (record_count == 0 || frame_length > 0) {
+        return 0;
+    }
+
+    uint16_t body_size = body_end - HEADER_SIZE;
+    uint32_t crc32 = SensorWLED::calculateCRC32(frame_buffer + HEADER_SIZE, body_size);
+    for (uint8_t cnt = 0; cnt < sizeof(crc32); cnt++) {
+        frame_buffer[body_end + cnt] = crc32 >> (8 * cnt);
+    }
+
+    // The header ends where the body starts, a short size takes one byte
+    frame_start = HEADER_SIZE;
+    if (body_size >= 0x80) {
+        frame_buffer[--frame_start] = body_size >> 7;
+        frame_buffer[--frame_start] = (body_size & 0x7F) | 0x80;
+    } else {
+        frame_buffer[--frame_start] = body_size;
+    }
+    frame_buffer[--frame_start] = TELEMETRY_SYNC_1;
+    frame_buffer[--frame_start] = TELEMETRY_SYNC_0;
+
+    frame_length = body_end + sizeof(crc32) - frame_start;
+    return frame_length;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  The sealed frame, to send.
+
+ @return First byte of the frame (see finish() for the size).
+ */
+//-----------------------------------------------------------------------------
+const uint8_t *TelemetryEncoder::getFrame(void) {
+    return frame_buffer + frame_start;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Number of records in the frame.
+
+ @return Record count.
+ */
+//-----------------------------------------------------------------------------
+uint16_t TelemetryEncoder::getRecordCount(void) {
+    return record_count;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Sequence number of the frame, increases with each new frame.
+
+ @return Frame sequence number.
+ */
+//-----------------------------------------------------------------------------
+uint32_t TelemetryEncoder::getSequence(void) {
+    return frame_sequence;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Writes the body header, and clears the per-channel deltas.
+
+ @param  ms_time
+         Time of the first record.
+ */
+//-----------------------------------------------------------------------------
+void TelemetryEncoder::startFrame(uint32_t ms_time) {
+
+    memset(previous_raw_value, 0, sizeof(previous_raw_value));
+
+    frame_buffer[body_end++] = TELEMETRY_FORMAT;
+    putVarint(frame_sequence);
+    putVarint(ms_time);
+    previous_ms_time = ms_time;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Appends an unsigned LEB128 varint, 7 bits per byte.
+
+ @param  value
+         Value to append.
+ */
+//-----------------------------------------------------------------------------
+void TelemetryEncoder::putVarint(uint32_t value) {
+
+    while (value >= 0x80) {
+        frame_buffer[body_end++] = (value & 0x7F) | 0x80;
+        value >>= 7;
+    }
+    frame_buffer[body_end++] = value;
+}
+
+//-----------------------------------------------------------------------------
+/*!
+ @brief  Appends a signed value as a zig-zag varint, i.e. small negative 
+         values are short too.
+
+ @param  value
+         Value to append.
+ */
+//-----------------------------------------------------------------------------
+void TelemetryEncoder::putZigZag(int32_t value) {
+    putVarint(((uint32_t) value << 1) ^ (uint32_t) (value >> 31));
+}
+
+// EOF
@@ -0,0 +1,85 @@
+/*!
+ * @file Telemetry.h
+ *
+ * This is part of SensorWLED library for the Arduino platform.
+ * Source: https://github.com/berrak/SensorWLED
+ *
+ * The MIT license.
+ *
+ */
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#include "SensorWLED.h"
+
+/** Frame buffer size (bytes), i.e. the largest frame */
+#if !defined(TELEMETRY_FRAME_SIZE)
+    #define TELEMETRY_FRAME_SIZE 256
+#endif
+
+#define TELEMETRY_SYNC_0 0xA5       ///< First frame start byte
+#define TELEMETRY_SYNC_1 0x5A       ///< Second frame start byte
+#define TELEMETRY_FORMAT 1          ///< Frame format version
+#define TELEMETRY_MAX_RECORD 14     ///< Largest encoded record (bytes)
+
+//-----------------------------------------------------------------------------
+/*!
+    @brief  Encodes readings into compact, CRC-protected binary frames, 
+            e.g. for a serial link, instead of text.
+
+            A frame is: TELEMETRY_SYNC_0, TELEMETRY_SYNC_1, the body size
+            (varint), the body, and the CRC32 (little-endian) of the body.
+            The body is: TELEMETRY_FORMAT, the frame sequence number and
+            the time of the first record (varints), then the records.
+
+            A record is: the channel id, the time since the previous 
+            record (ms), the raw code as a zig-zag delta from the previous
+            record of the channel in the frame, and the peak code as a
+            zig-zag delta from the raw code (varints). So each frame
+            decodes on its own, and a lost frame shows as a sequence gap.
+            The decoder is in extras/telemetry.
+*/
+//-----------------------------------------------------------------------------
+class TelemetryEncoder {
+
+public:
+
+    TelemetryEncoder(void);
+
+    // Adds a record, false if the frame is full (finish() and send it).
+    bool add(SensorWLED &rSensor);
+    bool add(uint16_t channel_id, uint32_t ms_time, uint16_t raw_value, 
+                            uint16_t pk_raw_value);
+
+    // Seals the frame, the next add() starts a new one in the same buffer.
+    // Returns 0 if there is nothing new to send.
+    size_t finish(void);
+    const uint8_t *getFrame(void);
+    void clear(void);
+
+    uint16_t getRecordCount(void);
+    uint32_t getSequence(void);
+
+private:
+
+    void startFrame(uint32_t ms_time);
+    void putVarint(uint32_t value);
+    void putZigZag(int32_t value);
+
+    /** Frame size (varint, 2 bytes) and sync bytes, before the body */
+    static constexpr uint16_t HEADER_SIZE = 4;
+
+    uint8_t frame_buffer[TELEMETRY_FRAME_SIZE]; ///< Header, body and CRC32
+    uint16_t body_end;              ///< Next body write position
+    uint16_t frame_start;           ///< First byte of the sealed frame
+    uint16_t frame_length;          ///< Sealed frame size, 0: open frame
+    uint16_t record_count;          ///< Records in the frame
+    uint32_t frame_sequence;        ///< Number of the frame
+    uint32_t previous_ms_time;      ///< Time of the previous record
+
+    /** Raw code of the previous record per channel id, in this frame */
+    uint16_t previous_raw_value[MAX_CHANNELS + 1];
+};
+/* class TelemetryEncoder */
+
+#endif /* TELEMETRY_H_ */